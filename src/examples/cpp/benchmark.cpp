@@ -0,0 +1,482 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <log4cxx/logger.h>
+#include <log4cxx/appenderskeleton.h>
+#include <log4cxx/simplelayout.h>
+#include <log4cxx/patternlayout.h>
+#include <log4cxx/hierarchy.h>
+#include <log4cxx/helpers/pool.h>
+#include <log4cxx/helpers/stringhelper.h>
+#include <log4cxx/helpers/thread.h>
+#include <log4cxx/helpers/deferredlog.h>
+#include <apr_general.h>
+#include <apr_time.h>
+#include <iostream>
+#include <sstream>
+#include <exception>
+#include <vector>
+#include <stdlib.h>
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+using namespace log4cxx::spi;
+
+
+/**
+Appender that formats events with its layout and discards the result,
+so the benchmark measures log4cxx rather than I/O.
+*/
+class DiscardAppender : public AppenderSkeleton
+{
+public:
+        DiscardAppender(const LayoutPtr& layout1)
+        {
+                layout = layout1;
+        }
+
+        void close()
+        {
+        }
+
+        bool requiresLayout() const
+        {
+                return true;
+        }
+
+protected:
+        void append(const LoggingEventPtr& event, Pool& p)
+        {
+                output.erase();
+                layout->format(output, event, p);
+        }
+
+private:
+        LogString output;
+};
+
+
+/**
+PatternLayout that calls each converter and applies its field width
+in turn, as PatternLayout did before compiling the conversion pattern.
+*/
+class InterpretedPatternLayout : public PatternLayout
+{
+public:
+        InterpretedPatternLayout(const LogString& pattern)
+        {
+                setConversionPattern(pattern);
+        }
+
+        void activateOptions(Pool& p)
+        {
+                PatternLayout::activateOptions(p);
+                std::vector<pattern::PatternConverterPtr> parsed;
+                converters.clear();
+                fields.clear();
+                pattern::PatternParser::parse(getConversionPattern(),
+                        parsed, fields, getFormatSpecifiers());
+                for(std::vector<pattern::PatternConverterPtr>::const_iterator iter = parsed.begin();
+                    iter != parsed.end();
+                    iter++)
+                {
+                        converters.push_back(*iter);
+                }
+        }
+
+        void format(LogString& output, const LoggingEventPtr& event, Pool& p) const
+        {
+                std::vector<pattern::FormattingInfoPtr>::const_iterator fieldIter = fields.begin();
+                for(std::vector<pattern::LoggingEventPatternConverterPtr>::const_iterator
+                        converterIter = converters.begin();
+                    converterIter != converters.end();
+                    converterIter++, fieldIter++)
+                {
+                        int startField = output.length();
+                        (*converterIter)->format(event, output, p);
+                        (*fieldIter)->format(startField, output);
+                }
+        }
+
+private:
+        std::vector<pattern::LoggingEventPatternConverterPtr> converters;
+        std::vector<pattern::FormattingInfoPtr> fields;
+};
+
+
+/**
+This program measures the cost of logging statements against an
+appender that discards its output.
+*/
+class Benchmark
+{
+        static LoggerPtr logger;
+
+public:
+        static void main(int argc, const char * const argv[])
+        {
+                int count = 1000000;
+                if(argc == 2)
+                {
+                        count = atoi(argv[1]);
+                }
+                if(count <= 0)
+                {
+                        usage(argv[0], "Count must be a positive number.");
+                }
+
+                logger->addAppender(new DiscardAppender(new SimpleLayout()));
+                logger->setAdditivity(false);
+
+                report("LOG4CXX_INFO(logger, \"x=\" << 42)", count, streamInsertion(count));
+                report("std::ostringstream per statement", count, streamPerStatement(count));
+                report("Logger::forcedLogLS, pool per thread", count, threadPoolRequests(count));
+                report("Logger::callAppenders, pool per statement", count, poolPerStatement(count));
+#if LOG4CXX_HAS_VARIADIC_MACROS
+                apr_time_t flushed = 0;
+                report("LOG4CXX_INFO_DEFERRED(logger, \"x={}\", 42), calling thread", count,
+                        deferredRequests(count, flushed));
+                report("LOG4CXX_INFO_DEFERRED(logger, \"x={}\", 42), background thread", count,
+                        flushed);
+#endif
+
+                LogString ttcc(LOG4CXX_STR("%r [%t] %-5p %c %x - %m%n"));
+                report("TTCC PatternLayout::format, compiled pattern", count,
+                        layoutFormatting(new PatternLayout(ttcc), count));
+                report("TTCC PatternLayout::format, converter loop", count,
+                        layoutFormatting(new InterpretedPatternLayout(ttcc), count));
+                LogString dated(LOG4CXX_STR("%d %-5p [%t] %c - %m%n"));
+                report("Dated PatternLayout::format, compiled pattern", count,
+                        layoutFormatting(new PatternLayout(dated), count));
+                report("Dated PatternLayout::format, converter loop", count,
+                        layoutFormatting(new InterpretedPatternLayout(dated), count));
+
+                for(int threads = 1; threads <= 4; threads *= 2)
+                {
+                        reportThreads("Hierarchy::isDisabled, auto-configured", threads, count,
+                                disabledRequests(count, threads));
+                }
+                for(int threads = 1; threads <= 4; threads *= 2)
+                {
+                        reportThreads("Hierarchy::getLogger, existing logger", threads, count,
+                                loggerLookups(count, threads));
+                }
+                for(int loggers = 10000; loggers <= 40000; loggers *= 4)
+                {
+                        std::cout << "Hierarchy::getLogger, " << loggers << " new loggers: "
+                                  << (loggerCreation(loggers) * 1000.0) / loggers
+                                  << " ns per logger" << std::endl;
+                }
+        }
+
+        static void usage(const char * programName, const char * msg)
+        {
+                std::cout << msg << std::endl;
+                std::cout << "Usage: " << programName <<
+                                " [count]" << std::endl;
+                exit(1);
+        }
+
+        static void report(const char* name, int count, apr_time_t elapsed)
+        {
+                std::cout << name << ": "
+                          << (elapsed * 1000.0) / count << " ns per statement" << std::endl;
+        }
+
+        /**
+        Reports the time per statement of each thread, which stays
+        the same as threads are added unless the threads contend.
+        */
+        static void reportThreads(const char* name, int threads, int count, apr_time_t elapsed)
+        {
+                std::cout << name << ", " << threads << " thread(s): "
+                          << (elapsed * 1000.0) / count << " ns per statement" << std::endl;
+        }
+
+        struct Request
+        {
+                int count;
+                const void* data;
+        };
+
+        /**
+        Runs a routine on several threads at once, each
+        with the same request.
+        */
+        static apr_time_t timeThreads(Runnable fn, Request& request, int threadCount)
+        {
+                std::vector<Thread*> threads(threadCount);
+                apr_time_t start = apr_time_now();
+                for(int i = 0; i < threadCount; i++)
+                {
+                        threads[i] = new Thread();
+                        threads[i]->run(fn, &request);
+                }
+                for(int i = 0; i < threadCount; i++)
+                {
+                        threads[i]->join();
+                        delete threads[i];
+                }
+                return apr_time_now() - start;
+        }
+
+        static void* LOG4CXX_THREAD_FUNC checkDisabled(apr_thread_t* /* thread */, void* data)
+        {
+                const Request& request = *(const Request*) data;
+                const Hierarchy* hierarchy = (const Hierarchy*) request.data;
+                int disabled = 0;
+                for(int i = 0; i < request.count; i++)
+                {
+                        if (hierarchy->isDisabled(Level::TRACE_INT))
+                        {
+                                disabled++;
+                        }
+                }
+                return disabled == request.count ? 0 : data;
+        }
+
+        /**
+        Checks the threshold of a hierarchy that has only been
+        auto-configured, on several threads at once.
+        */
+        static apr_time_t disabledRequests(int count, int threads)
+        {
+                Hierarchy* hierarchy = new Hierarchy();
+                LoggerRepositoryPtr repository(hierarchy);
+                hierarchy->isDisabled(Level::TRACE_INT);
+                Request request = { count, hierarchy };
+                return timeThreads(checkDisabled, request, threads);
+        }
+
+        struct Lookups
+        {
+                Hierarchy* hierarchy;
+                std::vector<LogString> names;
+        };
+
+        static void* LOG4CXX_THREAD_FUNC lookupLoggers(apr_thread_t* /* thread */, void* data)
+        {
+                const Request& request = *(const Request*) data;
+                const Lookups& lookups = *(const Lookups*) request.data;
+                for(int i = 0; i < request.count; i++)
+                {
+                        lookups.hierarchy->getLogger(lookups.names[i % lookups.names.size()]);
+                }
+                return 0;
+        }
+
+        /**
+        Looks up 1000 existing loggers in turn on several threads at once.
+        */
+        static apr_time_t loggerLookups(int count, int threads)
+        {
+                Lookups lookups;
+                lookups.hierarchy = new Hierarchy();
+                LoggerRepositoryPtr repository(lookups.hierarchy);
+                Pool p;
+                for(int i = 0; i < 1000; i++)
+                {
+                        LogString name(LOG4CXX_STR("org.example.plugin"));
+                        name.append(1, (logchar) (0x61 + (i % 26)));
+                        name.append(LOG4CXX_STR(".Handler"));
+                        StringHelper::toString(i, p, name);
+                        lookups.names.push_back(name);
+                        lookups.hierarchy->getLogger(name);
+                }
+                Request request = { count, &lookups };
+                return timeThreads(lookupLoggers, request, threads);
+        }
+
+        /**
+        Creates loggers named com.example.m<i % 100>.p<i % 10>.C<i>
+        and then their ancestors com.example.m<i>, so that each new
+        ancestor becomes the parent of existing loggers.
+        */
+        static apr_time_t loggerCreation(int count)
+        {
+                LoggerRepositoryPtr repository(new Hierarchy());
+                std::vector<LogString> names;
+                Pool p;
+                for(int i = 0; i < count; i++)
+                {
+                        LogString name(LOG4CXX_STR("com.example.m"));
+                        StringHelper::toString(i % 100, p, name);
+                        name.append(LOG4CXX_STR(".p"));
+                        StringHelper::toString(i % 10, p, name);
+                        name.append(LOG4CXX_STR(".C"));
+                        StringHelper::toString(i, p, name);
+                        names.push_back(name);
+                }
+                apr_time_t start = apr_time_now();
+                for(int i = 0; i < count; i++)
+                {
+                        repository->getLogger(names[i]);
+                }
+                for(int i = 0; i < 100; i++)
+                {
+                        LogString name(LOG4CXX_STR("com.example.m"));
+                        StringHelper::toString(i, p, name);
+                        repository->getLogger(name);
+                }
+                return apr_time_now() - start;
+        }
+
+        /**
+        Streams a number through the LOG4CXX_INFO macro.
+        */
+        static apr_time_t streamInsertion(int count)
+        {
+                apr_time_t start = apr_time_now();
+                for(int i = 0; i < count; i++)
+                {
+                        LOG4CXX_INFO(logger, "x=" << 42);
+                }
+                return apr_time_now() - start;
+        }
+
+#if LOG4CXX_HAS_VARIADIC_MACROS
+        /**
+        Records a number through the LOG4CXX_INFO_DEFERRED macro in bursts
+        that fit in the thread's buffer.  Returns the time spent by the
+        calling thread and sets flushed to the time then needed for the
+        background thread to catch up after each burst.
+        */
+        static apr_time_t deferredRequests(int count, apr_time_t& flushed)
+        {
+                const int burst = 500;
+                apr_time_t elapsed = 0;
+                flushed = 0;
+                for(int done = 0; done < count; done += burst)
+                {
+                        int n = count - done < burst ? count - done : burst;
+                        apr_time_t start = apr_time_now();
+                        for(int i = 0; i < n; i++)
+                        {
+                                LOG4CXX_INFO_DEFERRED(logger, "x={}", 42);
+                        }
+                        apr_time_t end = apr_time_now();
+                        DeferredLog::flush();
+                        flushed += apr_time_now() - end;
+                        elapsed += end - start;
+                }
+                return elapsed;
+        }
+#endif
+
+        /**
+        Streams a number through a new std::ostringstream per statement
+        and logs a copy of its content, as LOG4CXX_INFO did before
+        message buffers were reused.
+        */
+        static apr_time_t streamPerStatement(int count)
+        {
+                apr_time_t start = apr_time_now();
+                for(int i = 0; i < count; i++)
+                {
+                        if (logger->isInfoEnabled())
+                        {
+                                std::ostringstream os;
+                                os << "x=" << 42;
+                                logger->forcedLog(Level::getInfo(), os.str(), LOG4CXX_LOCATION);
+                        }
+                }
+                return apr_time_now() - start;
+        }
+
+        /**
+        Logs through Logger::forcedLogLS, which lends each request
+        the pool of the calling thread.
+        */
+        static apr_time_t threadPoolRequests(int count)
+        {
+                LogString msg(LOG4CXX_STR("x=42"));
+                apr_time_t start = apr_time_now();
+                for(int i = 0; i < count; i++)
+                {
+                        logger->forcedLogLS(Level::getInfo(), msg, LOG4CXX_LOCATION);
+                }
+                return apr_time_now() - start;
+        }
+
+        /**
+        Creates and destroys a pool for each event,
+        as Logger::forcedLog did before reusing a pool per thread.
+        */
+        static apr_time_t poolPerStatement(int count)
+        {
+                LogString msg(LOG4CXX_STR("x=42"));
+                apr_time_t start = apr_time_now();
+                for(int i = 0; i < count; i++)
+                {
+                        Pool p;
+                        LoggingEventPtr event(new LoggingEvent(logger->getName(),
+                                Level::getInfo(), msg, LOG4CXX_LOCATION));
+                        logger->callAppenders(event, p);
+                }
+                return apr_time_now() - start;
+        }
+
+        /**
+        Formats one event repeatedly with the given layout.  The count
+        is split into ten rounds and the fastest round is scaled up,
+        so that differences of a few percent stand out from the noise.
+        */
+        static apr_time_t layoutFormatting(const LayoutPtr& layout, int count)
+        {
+                LoggingEventPtr event(new LoggingEvent(logger->getName(), Level::getInfo(),
+                        LOG4CXX_STR("x=42"), LOG4CXX_LOCATION));
+                Pool p;
+                LogString output;
+                const int rounds = 10;
+                int perRound = count / rounds > 0 ? count / rounds : 1;
+                apr_time_t fastest = 0;
+                for(int round = 0; round < rounds; round++)
+                {
+                        apr_time_t start = apr_time_now();
+                        for(int i = 0; i < perRound; i++)
+                        {
+                                output.erase();
+                                layout->format(output, event, p);
+                        }
+                        apr_time_t elapsed = apr_time_now() - start;
+                        if (round == 0 || elapsed < fastest)
+                        {
+                                fastest = elapsed;
+                        }
+                }
+                return (fastest * count) / perRound;
+        }
+};
+
+LoggerPtr Benchmark::logger = Logger::getLogger("Benchmark");
+
+int main(int argc, const char * const argv[])
+{
+    apr_app_initialize(&argc, &argv, NULL);
+    int result = EXIT_SUCCESS;
+    try
+    {
+        Benchmark::main(argc, argv);
+    }
+    catch(std::exception&)
+    {
+        result = EXIT_FAILURE;
+    }
+
+    apr_terminate();
+    return result;
+}
@@ -71,6 +71,18 @@ int AppenderAttachableImpl::appendLoopOnAppenders(
         return appenderList.size();
 }
 
+int AppenderAttachableImpl::appendLoopOnAppenders(
+    const spi::LoggingEventList& events,
+    Pool& p)
+{
+    for (AppenderList::iterator it = appenderList.begin();
+         it != appenderList.end();
+         it++) {
+        (*it)->doAppendBatch(events, p);
+    }
+        return appenderList.size();
+}
+
 AppenderList AppenderAttachableImpl::getAllAppenders() const
 {
     return appenderList;
@@ -36,6 +36,7 @@ AppenderSkeleton::AppenderSkeleton()
 :   layout(),
     name(),
     threshold(Level::getAll()),
+    thresholdInt((unsigned int) Level::ALL_INT),
     errorHandler(new OnlyOnceErrorHandler()),
     headFilter(),
     tailFilter(),
@@ -50,6 +51,7 @@ AppenderSkeleton::AppenderSkeleton(const LayoutPtr& layout1)
 : layout(layout1),
   name(),
   threshold(Level::getAll()),
+  thresholdInt((unsigned int) Level::ALL_INT),
   errorHandler(new OnlyOnceErrorHandler()),
   headFilter(),
   tailFilter(),
@@ -117,11 +119,59 @@ void AppenderSkeleton::doAppend(const spi::LoggingEventPtr& event, Pool& pool1)
                 return;
         }
 
-        if(!isAsSevereAsThreshold(event->getLevel()))
+        if(isAccepted(event))
         {
+                append(event, pool1);
+        }
+}
+
+void AppenderSkeleton::doAppendBatch(const spi::LoggingEventList& events, Pool& pool1)
+{
+        synchronized sync(mutex);
+
+
+        if(closed)
+        {
+                LogLog::error(((LogString) LOG4CXX_STR("Attempted to append to closed appender named ["))
+                      + name + LOG4CXX_STR("]."));
                 return;
         }
 
+        LoggingEventList accepted;
+        accepted.reserve(events.size());
+        for(LoggingEventList::const_iterator iter = events.begin();
+            iter != events.end();
+            iter++)
+        {
+                if(isAccepted(*iter))
+                {
+                        accepted.push_back(*iter);
+                }
+        }
+
+        if(!accepted.empty())
+        {
+                appendBatch(accepted, pool1);
+        }
+}
+
+void AppenderSkeleton::appendBatch(const spi::LoggingEventList& events, Pool& p)
+{
+        for(LoggingEventList::const_iterator iter = events.begin();
+            iter != events.end();
+            iter++)
+        {
+                append(*iter, p);
+        }
+}
+
+bool AppenderSkeleton::isAccepted(const spi::LoggingEventPtr& event) const
+{
+        if(!isAsSevereAsThreshold(event->getLevel()))
+        {
+                return false;
+        }
+
         FilterPtr f = headFilter;
 
 
@@ -130,7 +180,7 @@ void AppenderSkeleton::doAppend(const spi::LoggingEventPtr& event, Pool& pool1)
                  switch(f->decide(event))
                  {
                          case Filter::DENY:
-                                 return;
+                                 return false;
                          case Filter::ACCEPT:
                                  f = 0;
                                  break;
@@ -138,8 +188,7 @@ void AppenderSkeleton::doAppend(const spi::LoggingEventPtr& event, Pool& pool1)
                                  f = f->getNext();
                  }
         }
-
-        append(event, pool1);
+        return true;
 }
 
 void AppenderSkeleton::setErrorHandler(const spi::ErrorHandlerPtr& errorHandler1)
@@ -162,6 +211,7 @@ void AppenderSkeleton::setThreshold(const LevelPtr& threshold1)
 {
         synchronized sync(mutex);
         this->threshold = threshold1;
+        apr_atomic_set32(&thresholdInt, (unsigned int) threshold1->toInt());
 }
 
 void AppenderSkeleton::setOption(const LogString& option,
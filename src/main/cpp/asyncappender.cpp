@@ -24,6 +24,7 @@
 
 #include <log4cxx/helpers/loglog.h>
 #include <log4cxx/spi/loggingevent.h>
+#include <log4cxx/spi/filter.h>
 #include <apr_thread_proc.h>
 #include <apr_thread_mutex.h>
 #include <apr_thread_cond.h>
@@ -32,6 +33,8 @@
 #include <log4cxx/helpers/stringhelper.h>
 #include <apr_atomic.h>
 #include <log4cxx/helpers/optionconverter.h>
+#include <log4cxx/helpers/threadspecificdata.h>
+#include <algorithm>
 
 
 using namespace log4cxx;
@@ -41,19 +44,467 @@ using namespace log4cxx::spi;
 
 IMPLEMENT_LOG4CXX_OBJECT(AsyncAppender)
 
+/**
+ *  Each slot carries a sequence number that is the position of the
+ *  next event it may take while it is free and that position plus one
+ *  once the event has been stored.  Producers claim a position by
+ *  advancing head and only contend with each other on that claim,
+ *  the dispatcher removes events in order by advancing tail.
+ */
+class AsyncAppender::EventRing {
+public:
+    EventRing(int size);
+    ~EventRing();
+
+    /**
+     *  Adds an event unless limit events are already present.
+     *  @return false if full.
+     */
+    bool offer(const LoggingEventPtr& event, int limit);
+
+    /**
+     *  Moves the stored events to a list.  Called by the dispatcher only.
+     *  @return false if there were none.
+     */
+    bool poll(LoggingEventList& events);
+
+    /**
+     *  Returns true if the next event has not been stored.
+     *  Called by the dispatcher only.
+     */
+    bool isEmpty() const;
+
+    inline unsigned int getCapacity() const {
+        return mask + 1;
+    }
+
+    /**
+     *  Next retired buffer.
+     */
+    EventRing* next;
+
+private:
+    EventRing(const EventRing&);
+    EventRing& operator=(const EventRing&);
+
+    struct Slot {
+        unsigned int volatile sequence;
+        LoggingEventPtr event;
+    };
+    unsigned int mask;
+    Slot* slots;
+    /**
+     *  Keeps the positions written by producers and by the dispatcher
+     *  on separate cache lines.
+     */
+    char padding1[64];
+    unsigned int volatile head;
+    char padding2[64];
+    unsigned int volatile tail;
+    char padding3[64];
+};
+
+AsyncAppender::EventRing::EventRing(int size) : next(0), mask(1), slots(0), head(0), tail(0) {
+    while((int) mask < size - 1) {
+        mask = (mask << 1) | 1;
+    }
+    slots = new Slot[mask + 1];
+    for(unsigned int i = 0; i <= mask; i++) {
+        slots[i].sequence = i;
+    }
+}
+
+AsyncAppender::EventRing::~EventRing() {
+    delete [] slots;
+}
+
+bool AsyncAppender::EventRing::offer(const LoggingEventPtr& event, int limit) {
+    unsigned int position = apr_atomic_read32(&head);
+    while(true) {
+        Slot& slot = slots[position & mask];
+        int available = (int) (apr_atomic_read32(&slot.sequence) - position);
+        if (available == 0) {
+            if ((int) (position - apr_atomic_read32(&tail)) >= limit) {
+                return false;
+            }
+            unsigned int claimed = apr_atomic_cas32(&head, position + 1, position);
+            if (claimed == position) {
+                slot.event = event;
+                apr_atomic_xchg32(&slot.sequence, position + 1);
+                return true;
+            }
+            position = claimed;
+        } else if (available < 0) {
+            //
+            //   slot still holds the event of the previous lap
+            return false;
+        } else {
+            position = apr_atomic_read32(&head);
+        }
+    }
+}
+
+bool AsyncAppender::EventRing::poll(LoggingEventList& events) {
+    unsigned int position = tail;
+    unsigned int end = position + mask + 1;
+    for(; position != end; position++) {
+        Slot& slot = slots[position & mask];
+        if (apr_atomic_read32(&slot.sequence) != position + 1) {
+            break;
+        }
+        events.push_back(slot.event);
+        slot.event = 0;
+        apr_atomic_xchg32(&slot.sequence, position + mask + 1);
+    }
+    if (position == tail) {
+        return false;
+    }
+    apr_atomic_xchg32(&tail, position);
+    return true;
+}
+
+bool AsyncAppender::EventRing::isEmpty() const {
+    return apr_atomic_read32(const_cast<unsigned int volatile*>(&slots[tail & mask].sequence)) != tail + 1;
+}
+
+
+/**
+ *  Events waiting for one attached appender and the thread
+ *  that appends them.  Events beyond the buffer size either
+ *  wait for space or are summarized, as for the main buffer.
+ *  Waiting events are kept by the lane and retried by the
+ *  dispatcher, which never waits for the thread of one appender.
+ */
+class AsyncAppender::Lane {
+public:
+    Lane(AsyncAppender& owner, const AppenderPtr& appender, const LaneOptions& options);
+    ~Lane();
+
+    inline const AppenderPtr& getAppender() const {
+        return appender;
+    }
+
+    void setOptions(const LaneOptions& options);
+
+    /**
+     *  Adds the events kept by earlier calls and then the batch,
+     *  keeping the events that must wait for space and discarding
+     *  those that do not fit.  Events below the overflow threshold of
+     *  the owner do not wait and leave its reserved size to other events.
+     *  Called by one thread at a time.
+     */
+    void offer(const LoggingEventList& batch, Pool& p);
+
+    /**
+     *  Returns true if the lane keeps as many events waiting
+     *  for space as its buffer size.
+     *  Called by the thread calling offer.
+     */
+    bool isStalled();
+
+    /**
+     *  Returns true if the lane keeps events and has space for them.
+     *  Called by the thread calling offer.
+     */
+    bool canRetry();
+
+    /**
+     *  Waits for the remaining events to be appended.
+     */
+    void close();
+
+private:
+    Lane(const Lane&);
+    Lane& operator=(const Lane&);
+
+    static void* LOG4CXX_THREAD_FUNC work(apr_thread_t* thread, void* data);
+
+    /**
+     *  Adds events to the buffer or to the waiting events.
+     *  Called with mutex held.
+     */
+    void accept(const LoggingEventList& batch, DiscardCountMap& discardCounts);
+
+    /**
+     *  Appends the remaining events after the thread failed,
+     *  later events are appended by offer.
+     */
+    void fail();
+
+    /**
+     *  Appends events on the calling thread, reporting errors.
+     */
+    void appendDirect(const LoggingEventList& batch, Pool& p);
+
+    AsyncAppender& owner;
+    AppenderPtr appender;
+    Pool pool;
+    Mutex mutex;
+    Condition notEmpty;
+    LoggingEventList events;
+    /**
+     *  Events waiting for space, used by the thread calling offer.
+     */
+    LoggingEventList pending;
+    DiscardMap discardMap;
+    int bufferSize;
+    bool blocking;
+    bool closed;
+    bool failed;
+    Thread worker;
+};
+
+AsyncAppender::Lane::Lane(AsyncAppender& owner1, const AppenderPtr& appender1, const LaneOptions& options)
+    : owner(owner1), appender(appender1), pool(), mutex(pool), notEmpty(pool),
+      events(), pending(), discardMap(), bufferSize(options.bufferSize), blocking(options.blocking),
+      closed(false), failed(false), worker() {
+    worker.run(work, this);
+}
+
+AsyncAppender::Lane::~Lane() {
+    close();
+}
+
+void AsyncAppender::Lane::setOptions(const LaneOptions& options) {
+    {
+        synchronized sync(mutex);
+        bufferSize = options.bufferSize;
+        blocking = options.blocking;
+    }
+    owner.signalDispatcher();
+}
+
+void AsyncAppender::Lane::offer(const LoggingEventList& batch, Pool& p) {
+    if (batch.empty() && pending.empty()) {
+        return;
+    }
+    LoggingEventList direct;
+    DiscardCountMap discardCounts;
+    {
+        synchronized sync(mutex);
+        LoggingEventList waiting;
+        waiting.swap(pending);
+        if (failed) {
+            //
+            //   if the worker has failed then
+            //      append synchronously
+            //
+            direct.swap(waiting);
+            direct.insert(direct.end(), batch.begin(), batch.end());
+        } else {
+            accept(waiting, discardCounts);
+            accept(batch, discardCounts);
+            notEmpty.signalAll();
+        }
+    }
+    if (!direct.empty()) {
+        appendDirect(direct, p);
+    }
+    if (!discardCounts.empty()) {
+        synchronized sync(owner.bufferMutex);
+        for(DiscardCountMap::iterator iter = discardCounts.begin();
+            iter != discardCounts.end();
+            iter++) {
+            owner.discardCounts[iter->first] += iter->second;
+        }
+    }
+}
+
+void AsyncAppender::Lane::accept(const LoggingEventList& batch, DiscardCountMap& discardCounts) {
+    for(LoggingEventList::const_iterator iter = batch.begin();
+        iter != batch.end();
+        iter++) {
+        //
+        //   events after one that waits also wait to keep the order
+        //
+        if (!pending.empty()) {
+            pending.push_back(*iter);
+            continue;
+        }
+        bool overflowable = owner.isOverflowable(*iter);
+        if (blocking && !overflowable && !closed && (int) events.size() >= bufferSize) {
+            pending.push_back(*iter);
+            continue;
+        }
+        int limit = overflowable ? owner.getOverflowLimit(bufferSize) : bufferSize;
+        if ((int) events.size() < limit) {
+            events.push_back(*iter);
+        } else {
+            discardCounts[(*iter)->getLevel()->toInt()]++;
+            const LogString& loggerName = (*iter)->getLoggerName();
+            DiscardMap::iterator discard = discardMap.find(loggerName);
+            if (discard == discardMap.end()) {
+                discardMap.insert(DiscardMap::value_type(loggerName, DiscardSummary(*iter)));
+            } else {
+                discard->second.add(*iter);
+            }
+        }
+    }
+}
+
+bool AsyncAppender::Lane::isStalled() {
+    synchronized sync(mutex);
+    return !pending.empty() && (int) pending.size() >= bufferSize;
+}
+
+bool AsyncAppender::Lane::canRetry() {
+    synchronized sync(mutex);
+    return !pending.empty() &&
+        (failed || closed || !blocking || (int) events.size() < bufferSize);
+}
+
+void AsyncAppender::Lane::appendDirect(const LoggingEventList& batch, Pool& p) {
+    try {
+        appender->doAppendBatch(batch, p);
+    } catch(std::exception& e) {
+        LogLog::error(((LogString) LOG4CXX_STR("Error appending to appender named ["))
+            + appender->getName() + LOG4CXX_STR("]."), e);
+    } catch(...) {
+        LogLog::error(((LogString) LOG4CXX_STR("Error appending to appender named ["))
+            + appender->getName() + LOG4CXX_STR("]."));
+    }
+}
+
+void AsyncAppender::Lane::fail() {
+    Pool p;
+    LoggingEventList remaining;
+    {
+        synchronized sync(mutex);
+        failed = true;
+        remaining.swap(events);
+        for(DiscardMap::iterator iter = discardMap.begin();
+            iter != discardMap.end();
+            iter++) {
+            remaining.push_back(iter->second.createEvent(p));
+        }
+        discardMap.clear();
+    }
+    owner.signalDispatcher();
+    if (!remaining.empty()) {
+        appendDirect(remaining, p);
+    }
+}
+
+void AsyncAppender::Lane::close() {
+    LoggingEventList direct;
+    {
+        synchronized sync(mutex);
+        closed = true;
+        //
+        //   the worker appends the waiting events
+        //     before it ends unless it has failed
+        //
+        if (failed) {
+            direct.swap(pending);
+        } else {
+            events.insert(events.end(), pending.begin(), pending.end());
+            pending.clear();
+        }
+        notEmpty.signalAll();
+    }
+    if (!direct.empty()) {
+        Pool p;
+        appendDirect(direct, p);
+    }
+    try {
+        worker.join();
+    } catch(InterruptedException& e) {
+        Thread::currentThreadInterrupt();
+        LogLog::error(LOG4CXX_STR("Got an InterruptedException while waiting for an appender to finish,"), e);
+    }
+}
+
+void* LOG4CXX_THREAD_FUNC AsyncAppender::Lane::work(apr_thread_t* /* thread */, void* data) {
+    Lane* lane = (Lane*) data;
+    bool isActive = true;
+    try {
+        while(isActive) {
+            Pool p;
+            LoggingEventList batch;
+            {
+                synchronized sync(lane->mutex);
+                while(!lane->closed && lane->events.empty() && lane->discardMap.empty()) {
+                    lane->notEmpty.await(lane->mutex);
+                }
+                isActive = !lane->closed;
+                batch.swap(lane->events);
+                for(DiscardMap::iterator iter = lane->discardMap.begin();
+                    iter != lane->discardMap.end();
+                    iter++) {
+                    batch.push_back(iter->second.createEvent(p));
+                }
+                lane->discardMap.clear();
+            }
+            //
+            //   the dispatcher retries the events
+            //     waiting for the space just freed
+            //
+            lane->owner.signalDispatcher();
+            if (!batch.empty()) {
+                lane->appender->doAppendBatch(batch, p);
+            }
+        }
+    } catch(InterruptedException& ex) {
+        Thread::currentThreadInterrupt();
+        LogLog::error(LOG4CXX_STR("Lane interrupted, appending synchronously."), ex);
+        lane->fail();
+    } catch(std::exception& ex) {
+        LogLog::error(((LogString) LOG4CXX_STR("Error appending to appender named ["))
+            + lane->appender->getName() + LOG4CXX_STR("], appending synchronously."), ex);
+        lane->fail();
+    } catch(...) {
+        LogLog::error(((LogString) LOG4CXX_STR("Error appending to appender named ["))
+            + lane->appender->getName() + LOG4CXX_STR("], appending synchronously."));
+        lane->fail();
+    }
+    return 0;
+}
+
+
+namespace {
+    unsigned int nextAppenderId() {
+        static apr_uint32_t volatile lastId = 0;
+        return apr_atomic_inc32(&lastId) + 1;
+    }
+
+    bool isEarlier(const LoggingEventPtr& event1, const LoggingEventPtr& event2) {
+        return event1->getTimeStamp() < event2->getTimeStamp();
+    }
+}
+
 
 AsyncAppender::AsyncAppender()
 : AppenderSkeleton(),
-  buffer(),
+  buffer(new EventRing(DEFAULT_BUFFER_SIZE)),
+  retiredBuffers(0),
+  id(nextAppenderId()),
+  newQueues(),
+  dispatchQueues(),
+  producers(0),
+  accepting(1),
+  dispatcherIdle(0),
+  blockedProducers(0),
   bufferMutex(pool),
   bufferNotFull(pool),
   bufferNotEmpty(pool),
   discardMap(new DiscardMap()),
+  discardCounts(),
+  retiredFilters(),
+  overflowThreshold(),
+  overflowLevel((unsigned int) Level::ALL_INT),
+  reservedSize(0),
   bufferSize(DEFAULT_BUFFER_SIZE),
   appenders(new AppenderAttachableImpl(pool)),
   dispatcher(),
   locationInfo(false),
-  blocking(true) {
+  blocking(true),
+  producerQueues(false),
+  strictOrdering(true),
+  dispatchLanes(false),
+  lanes(),
+  laneOptions() {
+  defaultLaneOptions.bufferSize = DEFAULT_BUFFER_SIZE;
+  defaultLaneOptions.blocking = false;
 #if APR_HAS_THREADS
   dispatcher.run(dispatch, this);
 #endif
@@ -62,7 +513,16 @@ AsyncAppender::AsyncAppender()
 AsyncAppender::~AsyncAppender()
 {
         finalize();
+        for(LaneList::iterator iter = lanes.begin(); iter != lanes.end(); iter++) {
+            delete *iter;
+        }
         delete discardMap;
+        while(retiredBuffers != 0) {
+            EventRing* next = retiredBuffers->next;
+            delete retiredBuffers;
+            retiredBuffers = next;
+        }
+        delete buffer;
 }
 
 void AsyncAppender::addRef() const {
@@ -88,6 +548,27 @@ void AsyncAppender::setOption(const LogString& option,
         if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("BUFFERSIZE"), LOG4CXX_STR("buffersize"))) {
              setBufferSize(OptionConverter::toInt(value, DEFAULT_BUFFER_SIZE));
         }
+        if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("OVERFLOWTHRESHOLD"), LOG4CXX_STR("overflowthreshold"))) {
+             setOverflowThreshold(Level::toLevelLS(value));
+        }
+        if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("RESERVEDSIZE"), LOG4CXX_STR("reservedsize"))) {
+             setReservedSize(OptionConverter::toInt(value, 0));
+        }
+        if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("PRODUCERQUEUES"), LOG4CXX_STR("producerqueues"))) {
+             setProducerQueues(OptionConverter::toBoolean(value, false));
+        }
+        if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("STRICTORDERING"), LOG4CXX_STR("strictordering"))) {
+             setStrictOrdering(OptionConverter::toBoolean(value, true));
+        }
+        if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("DISPATCHLANES"), LOG4CXX_STR("dispatchlanes"))) {
+             setDispatchLanes(OptionConverter::toBoolean(value, false));
+        }
+        if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("LANEBUFFERSIZE"), LOG4CXX_STR("lanebuffersize"))) {
+             setLaneBufferSize(OptionConverter::toInt(value, DEFAULT_BUFFER_SIZE));
+        }
+        if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("LANEBLOCKING"), LOG4CXX_STR("laneblocking"))) {
+             setLaneBlocking(OptionConverter::toBoolean(value, false));
+        }
         if (StringHelper::equalsIgnoreCase(option, LOG4CXX_STR("BLOCKING"), LOG4CXX_STR("blocking"))) {
              setBlocking(OptionConverter::toBoolean(value, true));
         } else {
@@ -96,6 +577,46 @@ void AsyncAppender::setOption(const LogString& option,
 }
 
 
+void AsyncAppender::doAppend(const spi::LoggingEventPtr& event, Pool& pool1) {
+        if (closed) {
+                LogLog::error(((LogString) LOG4CXX_STR("Attempted to append to closed appender named ["))
+                      + name + LOG4CXX_STR("]."));
+                return;
+        }
+
+        if (event->getLevel()->toInt() <
+            (int) apr_atomic_read32(const_cast<unsigned int volatile*>(&thresholdInt))) {
+                return;
+        }
+
+        //
+        //   chains removed by clearFilters are kept, so the filters
+        //     reached here stay valid without the mutex
+        //
+        FilterPtr f = headFilter;
+        while(f != 0) {
+                switch(f->decide(event)) {
+                        case Filter::DENY:
+                                return;
+                        case Filter::ACCEPT:
+                                f = 0;
+                                break;
+                        case Filter::NEUTRAL:
+                                f = f->getNext();
+                }
+        }
+
+        append(event, pool1);
+}
+
+void AsyncAppender::clearFilters() {
+        synchronized sync(mutex);
+        if (headFilter != 0) {
+                retiredFilters.push_back(headFilter);
+        }
+        headFilter = tailFilter = 0;
+}
+
 void AsyncAppender::append(const spi::LoggingEventPtr& event, Pool& p) {
 #if APR_HAS_THREADS
        //
@@ -117,15 +638,29 @@ void AsyncAppender::append(const spi::LoggingEventPtr& event, Pool& p) {
         event->getMDCCopy();
 
 
+        //
+        //   events below the overflow threshold
+        //      leave the reserved part of the buffer
+        //
+        bool overflowable = isOverflowable(event);
+        int limit = overflowable ? getOverflowLimit(bufferSize) : bufferSize;
+        if (tryAppend(event, limit)) {
+            signalDispatcher();
+            return;
+        }
+
+        bool added = false;
         {
              synchronized sync(bufferMutex);
+             apr_atomic_inc32(&blockedProducers);
              while(true) {
-                 int previousSize = buffer.size();
-                 if (previousSize < bufferSize) {
-                     buffer.push_back(event);
-                     if (previousSize == 0) {
-                        bufferNotEmpty.signalAll();
-                     }
+                 //
+                 //   the dispatcher signals bufferNotFull after
+                 //     removing events if blockedProducers is nonzero
+                 //
+                 limit = overflowable ? getOverflowLimit(bufferSize) : bufferSize;
+                 if (tryAppend(event, limit)) {
+                     added = true;
                      break;
                  }
              
@@ -133,11 +668,13 @@ void AsyncAppender::append(const spi::LoggingEventPtr& event, Pool& p) {
                 //   Following code is only reachable if buffer is full
                 //
                 //
-                //   if blocking and thread is not already interrupted
+                //   if blocking, the event is not below the overflow threshold,
+                //      the thread is not already interrupted
                 //      and not the dispatcher then
                 //      wait for a buffer notification
                 bool discard = true;
                 if (blocking
+                    && !overflowable
                     && !Thread::interrupted()
                     && !dispatcher.isCurrentThread()) {
                     try {
@@ -157,7 +694,8 @@ void AsyncAppender::append(const spi::LoggingEventPtr& event, Pool& p) {
                 //   add event to discard map.
                 //
                 if (discard) {
-                    LogString loggerName = event->getLoggerName();
+                    discardCounts[event->getLevel()->toInt()]++;
+                    const LogString& loggerName = event->getLoggerName();
                     DiscardMap::iterator iter = discardMap->find(loggerName);
                     if (iter == discardMap->end()) {
                         DiscardSummary summary(event);
@@ -168,6 +706,10 @@ void AsyncAppender::append(const spi::LoggingEventPtr& event, Pool& p) {
                     break;
                 }
             }
+            apr_atomic_dec32(&blockedProducers);
+        }
+        if (added) {
+            signalDispatcher();
         }
 #else
         synchronized sync(appenders->getMutex());
@@ -176,6 +718,154 @@ void AsyncAppender::append(const spi::LoggingEventPtr& event, Pool& p) {
   }
   
 
+bool AsyncAppender::isOverflowable(const LoggingEventPtr& event) const {
+    return event->getLevel()->toInt() <
+        (int) apr_atomic_read32(const_cast<unsigned int volatile*>(&overflowLevel));
+}
+
+int AsyncAppender::getOverflowLimit(int size) const {
+    int limit = size - reservedSize;
+    return (limit < 1) ? 1 : limit;
+}
+
+bool AsyncAppender::tryAppend(const LoggingEventPtr& event, int limit) {
+    bool added = true;
+    if (producerQueues) {
+        EventQueue* queue = getProducerQueue();
+        if (queue != 0) {
+            //
+            //   close waits for the mark of each queue rather than
+            //     a count shared by the logging threads
+            //
+            queue->beginOffer();
+            if (apr_atomic_read32(&accepting) != 0) {
+                added = queue->offer(event, limit);
+            }
+            queue->endOffer();
+            return added;
+        }
+    }
+    //
+    //   setBufferSize waits for producers to drop to zero
+    //     before retiring the buffer read here and close
+    //     before taking the remaining events.
+    //
+    apr_atomic_inc32(&producers);
+    if (apr_atomic_read32(&accepting) != 0) {
+        EventRing* current = buffer;
+        added = current->offer(event, limit);
+    }
+    apr_atomic_dec32(&producers);
+    return added;
+}
+
+EventQueue* AsyncAppender::getProducerQueue() {
+    ThreadSpecificData::EventQueueList* queues = ThreadSpecificData::getEventQueues();
+    if (queues == 0) {
+        return 0;
+    }
+    ThreadSpecificData::EventQueueList::iterator iter = queues->begin();
+    while(iter != queues->end()) {
+        if ((*iter)->getOwnerId() == id) {
+            if ((int) (*iter)->getCapacity() >= bufferSize) {
+                return *iter;
+            }
+            //
+            //   the buffer has grown, the dispatcher reads
+            //     the remaining events of the released queue
+            //     before those of its replacement
+            //
+            queues->erase(iter);
+            break;
+        }
+        //
+        //   drop the queues of closed appenders
+        //
+        if ((*iter)->isDetached()) {
+            iter = queues->erase(iter);
+        } else {
+            iter++;
+        }
+    }
+    EventQueuePtr queue(new EventQueue(id, bufferSize));
+    queues->push_back(queue);
+    synchronized sync(bufferMutex);
+    newQueues.push_back(queue);
+    return queue;
+}
+
+bool AsyncAppender::isIdle() const {
+    if (retiredBuffers != 0 || !newQueues.empty() || !buffer->isEmpty()) {
+        return false;
+    }
+    for(EventQueueList::const_iterator iter = dispatchQueues.begin();
+        iter != dispatchQueues.end();
+        iter++) {
+        if (!(*iter)->isEmpty()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void AsyncAppender::pollQueues(LoggingEventList& events) {
+    size_t start = events.size();
+    std::vector<size_t> runs;
+    EventQueueList::iterator iter = dispatchQueues.begin();
+    while(iter != dispatchQueues.end()) {
+        //
+        //   an orphaned queue receives no more events
+        //     and can be dropped once emptied
+        //
+        bool orphaned = (*iter)->isOrphaned();
+        if ((*iter)->poll(events)) {
+            runs.push_back(events.size());
+        }
+        if (orphaned) {
+            iter = dispatchQueues.erase(iter);
+        } else {
+            iter++;
+        }
+    }
+    if (strictOrdering) {
+        //
+        //   the events of each queue are in order,
+        //     merge pairs of adjacent runs until one is left
+        //
+        while(runs.size() > 1) {
+            std::vector<size_t> merged;
+            size_t begin = start;
+            size_t i = 0;
+            for(; i + 1 < runs.size(); i += 2) {
+                std::inplace_merge(events.begin() + begin,
+                    events.begin() + runs[i],
+                    events.begin() + runs[i + 1],
+                    isEarlier);
+                begin = runs[i + 1];
+                merged.push_back(begin);
+            }
+            if (i < runs.size()) {
+                merged.push_back(runs[i]);
+            }
+            runs.swap(merged);
+        }
+    }
+}
+
+void AsyncAppender::signalDispatcher() {
+    //
+    //   the xchg32 that published the event in the ring or queue is
+    //     a full barrier between storing it and this read of the flag
+    //     the dispatcher sets before its final check of the buffers.
+    //     Lanes free space with their mutex held, which the dispatcher
+    //     also takes after setting the flag to check the lanes.
+    //
+    if (apr_atomic_read32(&dispatcherIdle) != 0) {
+        synchronized sync(bufferMutex);
+        bufferNotEmpty.signalAll();
+    }
+}
+
 void AsyncAppender::close() {
     {
         synchronized sync(bufferMutex);
@@ -183,6 +873,15 @@ void AsyncAppender::close() {
         bufferNotEmpty.signalAll();
         bufferNotFull.signalAll();
     }
+    //
+    //   cas32 orders clearing accepting before reading producers
+    //     and the marks of the queues, events added after the
+    //     waits would not be appended
+    //
+    apr_atomic_cas32(&accepting, 0, 1);
+    while (apr_atomic_cas32(&producers, 0, 0) != 0) {
+        apr_thread_yield();
+    }
     
 #if APR_HAS_THREADS
     try {
@@ -192,6 +891,53 @@ void AsyncAppender::close() {
         LogLog::error(LOG4CXX_STR("Got an InterruptedException while waiting for the dispatcher to finish,"), e);
     }
 #endif
+
+    //
+    //   append the events added after the final pass of
+    //     the dispatcher and release the queues of the logging threads
+    //
+    {
+        Pool p;
+        LoggingEventList events;
+        {
+            synchronized sync(bufferMutex);
+            while(retiredBuffers != 0) {
+                while(retiredBuffers->poll(events)) {
+                }
+                EventRing* next = retiredBuffers->next;
+                delete retiredBuffers;
+                retiredBuffers = next;
+            }
+            dispatchQueues.insert(dispatchQueues.end(), newQueues.begin(), newQueues.end());
+            newQueues.clear();
+        }
+        //
+        //   a thread that registered its queue after this point
+        //     finds accepting cleared and adds nothing
+        //
+        for(EventQueueList::iterator iter = dispatchQueues.begin();
+            iter != dispatchQueues.end();
+            iter++) {
+            while((*iter)->isOffering()) {
+                apr_thread_yield();
+            }
+        }
+        buffer->poll(events);
+        pollQueues(events);
+        for(EventQueueList::iterator iter = dispatchQueues.begin();
+            iter != dispatchQueues.end();
+            iter++) {
+            (*iter)->detach();
+        }
+        dispatchQueues.clear();
+        if (dispatchLanes) {
+            dispatchToLanes(events, p);
+        } else if (!events.empty()) {
+            synchronized sync(appenders->getMutex());
+            appenders->appendLoopOnAppenders(events, p);
+        }
+        closeLanes();
+    }
     
     {
         synchronized sync(appenders->getMutex());
@@ -260,6 +1006,24 @@ void AsyncAppender::setBufferSize(int size)
     }
     synchronized sync(bufferMutex);
     bufferSize = (size < 1) ? 1 : size;
+    if ((unsigned int) bufferSize > buffer->getCapacity()) {
+        //
+        //   producers that read the previous buffer are done
+        //     once the count drops to zero, the dispatcher then
+        //     removes its remaining events before those of the new one.
+        //
+        EventRing* previous = (EventRing*)
+            apr_atomic_xchgptr((volatile void**) &buffer, new EventRing(bufferSize));
+        while (apr_atomic_cas32(&producers, 0, 0) != 0) {
+            apr_thread_yield();
+        }
+        EventRing** last = &retiredBuffers;
+        while(*last != 0) {
+            last = &(*last)->next;
+        }
+        *last = previous;
+        bufferNotEmpty.signalAll();
+    }
     bufferNotFull.signalAll();
 }
 
@@ -278,6 +1042,197 @@ bool AsyncAppender::getBlocking() const {
     return blocking;
 }
 
+void AsyncAppender::setOverflowThreshold(const LevelPtr& level) {
+    synchronized sync(bufferMutex);
+    overflowThreshold = level;
+    apr_atomic_set32(&overflowLevel,
+        (unsigned int) ((level == 0) ? Level::ALL_INT : level->toInt()));
+    bufferNotFull.signalAll();
+}
+
+const LevelPtr& AsyncAppender::getOverflowThreshold() const {
+    return overflowThreshold;
+}
+
+void AsyncAppender::setReservedSize(int size) {
+    if (size < 0) {
+          throw IllegalArgumentException(LOG4CXX_STR("size argument must be non-negative"));
+    }
+    synchronized sync(bufferMutex);
+    reservedSize = size;
+    bufferNotFull.signalAll();
+}
+
+int AsyncAppender::getReservedSize() const {
+    return reservedSize;
+}
+
+unsigned int AsyncAppender::getDiscardCount(const LevelPtr& level) const {
+    synchronized sync(bufferMutex);
+    DiscardCountMap::const_iterator iter = discardCounts.find(level->toInt());
+    if (iter != discardCounts.end()) {
+        return iter->second;
+    }
+    return 0;
+}
+
+void AsyncAppender::setProducerQueues(bool value) {
+    producerQueues = value;
+}
+
+bool AsyncAppender::getProducerQueues() const {
+    return producerQueues;
+}
+
+void AsyncAppender::setStrictOrdering(bool value) {
+    strictOrdering = value;
+}
+
+bool AsyncAppender::getStrictOrdering() const {
+    return strictOrdering;
+}
+
+void AsyncAppender::setDispatchLanes(bool value) {
+    dispatchLanes = value;
+}
+
+bool AsyncAppender::getDispatchLanes() const {
+    return dispatchLanes;
+}
+
+void AsyncAppender::setLaneBufferSize(int size) {
+    if (size < 0) {
+          throw IllegalArgumentException(LOG4CXX_STR("size argument must be non-negative"));
+    }
+    synchronized sync(appenders->getMutex());
+    defaultLaneOptions.bufferSize = (size < 1) ? 1 : size;
+    updateLanes();
+}
+
+int AsyncAppender::getLaneBufferSize() const {
+    return defaultLaneOptions.bufferSize;
+}
+
+void AsyncAppender::setLaneBlocking(bool value) {
+    synchronized sync(appenders->getMutex());
+    defaultLaneOptions.blocking = value;
+    updateLanes();
+}
+
+bool AsyncAppender::getLaneBlocking() const {
+    return defaultLaneOptions.blocking;
+}
+
+void AsyncAppender::setLaneOptions(const LogString& appenderName, int size, bool blocking1) {
+    if (size < 0) {
+          throw IllegalArgumentException(LOG4CXX_STR("size argument must be non-negative"));
+    }
+    synchronized sync(appenders->getMutex());
+    LaneOptions& options = laneOptions[appenderName];
+    options.bufferSize = (size < 1) ? 1 : size;
+    options.blocking = blocking1;
+    updateLanes();
+}
+
+const AsyncAppender::LaneOptions& AsyncAppender::getLaneOptions(const LogString& appenderName) const {
+    LaneOptionMap::const_iterator iter = laneOptions.find(appenderName);
+    if (iter != laneOptions.end()) {
+        return iter->second;
+    }
+    return defaultLaneOptions;
+}
+
+void AsyncAppender::updateLanes() {
+    for(LaneList::iterator iter = lanes.begin(); iter != lanes.end(); iter++) {
+        (*iter)->setOptions(getLaneOptions((*iter)->getAppender()->getName()));
+    }
+}
+
+void AsyncAppender::dispatchToLanes(const LoggingEventList& events, Pool& p) {
+    LaneList targets;
+    LaneList removed;
+    {
+        synchronized sync(appenders->getMutex());
+        AppenderList appenderList(appenders->getAllAppenders());
+        LaneList::iterator iter = lanes.begin();
+        while(iter != lanes.end()) {
+            if (std::find(appenderList.begin(), appenderList.end(),
+                    (*iter)->getAppender()) == appenderList.end()) {
+                removed.push_back(*iter);
+                iter = lanes.erase(iter);
+            } else {
+                iter++;
+            }
+        }
+        for(AppenderList::iterator appender = appenderList.begin();
+            appender != appenderList.end();
+            appender++) {
+            Lane* lane = 0;
+            for(iter = lanes.begin(); iter != lanes.end(); iter++) {
+                if ((*iter)->getAppender() == *appender) {
+                    lane = *iter;
+                    break;
+                }
+            }
+            if (lane == 0) {
+                lane = new Lane(*this, *appender, getLaneOptions((*appender)->getName()));
+                lanes.push_back(lane);
+            }
+            targets.push_back(lane);
+        }
+    }
+    //
+    //   only the dispatcher removes lanes, so the lanes stay valid
+    //     without the mutex of the appenders.  Lanes of removed
+    //     appenders append their remaining events before being closed.
+    //
+    for(LaneList::iterator iter = removed.begin(); iter != removed.end(); iter++) {
+        delete *iter;
+    }
+    //
+    //   a full blocking lane keeps the events that do not fit
+    //     and the other lanes still receive them
+    //
+    for(LaneList::iterator iter = targets.begin(); iter != targets.end(); iter++) {
+        (*iter)->offer(events, p);
+    }
+}
+
+bool AsyncAppender::hasStalledLane() const {
+    for(LaneList::const_iterator iter = lanes.begin(); iter != lanes.end(); iter++) {
+        if ((*iter)->isStalled()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AsyncAppender::canRetryLanes() const {
+    for(LaneList::const_iterator iter = lanes.begin(); iter != lanes.end(); iter++) {
+        if ((*iter)->canRetry()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void AsyncAppender::closeLanes() {
+    //
+    //   only the dispatcher adds lanes
+    //
+    if (lanes.empty()) {
+        return;
+    }
+    LaneList closing;
+    {
+        synchronized sync(appenders->getMutex());
+        closing.swap(lanes);
+    }
+    for(LaneList::iterator iter = closing.begin(); iter != closing.end(); iter++) {
+        delete *iter;
+    }
+}
+
 AsyncAppender::DiscardSummary::DiscardSummary(const LoggingEventPtr& event) : 
       maxEvent(event), count(1) {
 }
@@ -304,8 +1259,8 @@ LoggingEventPtr AsyncAppender::DiscardSummary::createEvent(Pool& p) {
     StringHelper::toString(count, p, msg);
     msg.append(LOG4CXX_STR(" messages due to a full event buffer including: "));
     msg.append(maxEvent->getMessage()); 
-    return new LoggingEvent(   
-              maxEvent->getLoggerName(),
+    return LoggingEvent::obtain(
+              maxEvent->getSharedLoggerName(),
               maxEvent->getLevel(),
               msg,
               LocationInfo::getLocationUnavailable());
@@ -323,36 +1278,77 @@ void* LOG4CXX_THREAD_FUNC AsyncAppender::dispatch(apr_thread_t* /*thread*/, void
              //
             Pool p;
             LoggingEventList events;
+            LoggingEventList summaries;
+            EventRing* retired = 0;
+            EventRing* current = 0;
             {
                    synchronized sync(pThis->bufferMutex);
-                   size_t bufferSize = pThis->buffer.size();
                    isActive = !pThis->closed;
-               
-                   while((bufferSize == 0) && isActive) {
-                       pThis->bufferNotEmpty.await(pThis->bufferMutex);
-                       bufferSize = pThis->buffer.size();
-                       isActive = !pThis->closed;
+                   //
+                   //   while a blocking lane is stalled the events stay in
+                   //     the buffers and producers wait or discard as for
+                   //     a full buffer, lanes are retried as they free space.
+                   //
+                   bool laneDispatch = pThis->dispatchLanes;
+                   bool stalled = laneDispatch && pThis->hasStalledLane();
+                   if (isActive && (stalled || pThis->isIdle())
+                       && !(laneDispatch && pThis->canRetryLanes())) {
+                       //
+                       //   producers and lanes signal bufferNotEmpty only
+                       //     while dispatcherIdle is set, xchg32 orders setting
+                       //     it before the final check of the buffers and lanes.
+                       //
+                       apr_atomic_xchg32(&pThis->dispatcherIdle, 1);
+                       while(isActive && (stalled || pThis->isIdle())
+                           && !(laneDispatch && pThis->canRetryLanes())) {
+                           pThis->bufferNotEmpty.await(pThis->bufferMutex);
+                           isActive = !pThis->closed;
+                       }
+                       apr_atomic_xchg32(&pThis->dispatcherIdle, 0);
                    }
-                   for(LoggingEventList::iterator eventIter = pThis->buffer.begin();
-                       eventIter != pThis->buffer.end();
-                       eventIter++) {
-                       events.push_back(*eventIter);
+                   if (!stalled) {
+                       current = pThis->buffer;
+                       retired = pThis->retiredBuffers;
+                       pThis->retiredBuffers = 0;
+                       pThis->dispatchQueues.insert(pThis->dispatchQueues.end(),
+                           pThis->newQueues.begin(), pThis->newQueues.end());
+                       pThis->newQueues.clear();
+                       for(DiscardMap::iterator discardIter = pThis->discardMap->begin();
+                           discardIter != pThis->discardMap->end();
+                           discardIter++) {
+                           summaries.push_back(discardIter->second.createEvent(p));
+                       }
+                       pThis->discardMap->clear();
                    }
-                   for(DiscardMap::iterator discardIter = pThis->discardMap->begin();
-                       discardIter != pThis->discardMap->end();
-                       discardIter++) {
-                       events.push_back(discardIter->second.createEvent(p));
-                   }
-                   pThis->buffer.clear();
-                   pThis->discardMap->clear();
-                   pThis->bufferNotFull.signalAll();
             }
+
+            while(retired != 0) {
+                while(retired->poll(events)) {
+                }
+                EventRing* next = retired->next;
+                delete retired;
+                retired = next;
+            }
+            if (current != 0) {
+                current->poll(events);
+                pThis->pollQueues(events);
+                if (apr_atomic_cas32(&pThis->blockedProducers, 0, 0) != 0) {
+                    synchronized sync(pThis->bufferMutex);
+                    pThis->bufferNotFull.signalAll();
+                }
+            }
+            events.insert(events.end(), summaries.begin(), summaries.end());
             
-            for (LoggingEventList::iterator iter = events.begin();
-                 iter != events.end();
-                 iter++) {
+            if (pThis->dispatchLanes) {
+                 pThis->dispatchToLanes(events, p);
+            } else if (!events.empty()) {
+                 //
+                 //   lanes left from before DispatchLanes was
+                 //     turned off finish first to keep the order
+                 //
+                 pThis->closeLanes();
                  synchronized sync(pThis->appenders->getMutex());
-                 pThis->appenders->appendLoopOnAppenders(*iter, p);
+                 pThis->appenders->appendLoopOnAppenders(events, p);
             }
         }
     } catch(InterruptedException& ex) {
@@ -0,0 +1,117 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <log4cxx/helpers/braceformat.h>
+#include <log4cxx/helpers/loglog.h>
+#include <log4cxx/helpers/stringhelper.h>
+#include <log4cxx/helpers/transcoder.h>
+#include <log4cxx/helpers/pool.h>
+#include <vector>
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+
+namespace {
+   /**
+    *  Appends literal text up to the next placeholder, one run of
+    *  characters at a time so the common case is a single copy.
+    */
+   template<class B, class C>
+   bool appendUntilPlaceholder(B& out, const C*& pattern) {
+      const C LBRACE = 0x7B;
+      const C RBRACE = 0x7D;
+      const C* start = pattern;
+      const C* p = pattern;
+      for(; *p != 0; p++) {
+         if (*p == LBRACE && p[1] == RBRACE) {
+            out.append(start, p - start);
+            pattern = p + 2;
+            return true;
+         }
+         if ((*p == LBRACE || *p == RBRACE) && p[1] == *p) {
+            //
+            //   escaped brace, keep one
+            out.append(start, p - start + 1);
+            start = ++p + 1;
+         }
+      }
+      out.append(start, p - start);
+      pattern = p;
+      return false;
+   }
+
+   template<class B, class C>
+   size_t appendPlaceholders(B& out, const C* pattern) {
+      static const C PLACEHOLDER[] = { 0x7B, 0x7D, 0 };
+      size_t count = 0;
+      while (appendUntilPlaceholder(out, pattern)) {
+         out.append(PLACEHOLDER, 2);
+         count++;
+      }
+      return count;
+   }
+
+   void warnMismatch(const LogString& pattern, size_t placeholders, size_t arguments) {
+      Pool p;
+      std::vector<LogString> params(3);
+      params[0] = pattern;
+      StringHelper::toString(placeholders, p, params[1]);
+      StringHelper::toString(arguments, p, params[2]);
+      LogLog::warn(StringHelper::format(
+         LOG4CXX_STR("Pattern \"{0}\" has {1} placeholder(s) for {2} argument(s)."), params));
+   }
+}
+
+
+bool BraceFormat::appendLiteral(CharMessageBuffer& out, const char*& pattern) {
+   return appendUntilPlaceholder(out, pattern);
+}
+
+size_t BraceFormat::appendRemainder(CharMessageBuffer& out, const char* pattern) {
+   return appendPlaceholders(out, pattern);
+}
+
+void BraceFormat::reportMismatch(const char* pattern, size_t placeholders, size_t arguments) {
+   LOG4CXX_DECODE_CHAR(lsPattern, std::string(pattern));
+   warnMismatch(lsPattern, placeholders, arguments);
+}
+
+#if LOG4CXX_WCHAR_T_API
+CharMessageBuffer& BraceFormat::getBuffer(MessageBuffer& buf, const char*) {
+   return buf.cbuf;
+}
+
+WideMessageBuffer& BraceFormat::getBuffer(MessageBuffer& buf, const wchar_t*) {
+   if (buf.wbuf == 0) {
+      buf.wbuf = new WideMessageBuffer();
+   }
+   return *buf.wbuf;
+}
+
+bool BraceFormat::appendLiteral(WideMessageBuffer& out, const wchar_t*& pattern) {
+   return appendUntilPlaceholder(out, pattern);
+}
+
+size_t BraceFormat::appendRemainder(WideMessageBuffer& out, const wchar_t* pattern) {
+   return appendPlaceholders(out, pattern);
+}
+
+void BraceFormat::reportMismatch(const wchar_t* pattern, size_t placeholders, size_t arguments) {
+   LOG4CXX_DECODE_WCHAR(lsPattern, std::wstring(pattern));
+   warnMismatch(lsPattern, placeholders, arguments);
+}
+#endif
@@ -23,6 +23,8 @@
 #include <log4cxx/helpers/pool.h>
 #include <limits>
 #include <log4cxx/helpers/exception.h>
+#include <log4cxx/helpers/threadspecificdata.h>
+#include <apr_atomic.h>
 
 using namespace log4cxx;
 using namespace log4cxx::helpers;
@@ -69,11 +71,8 @@ const logchar CachedDateFormat::zeroString[] = { 0x30, 0x30, 0x30, 0 };
 CachedDateFormat::CachedDateFormat(const DateFormatPtr& dateFormat,
         int expiration1) :
        formatter(dateFormat),
-       millisecondStart(0),
-       slotBegin(std::numeric_limits<log4cxx_time_t>::min()),
-       cache(50, 0x20),
        expiration(expiration1),
-       previousTime(std::numeric_limits<log4cxx_time_t>::min()) {
+       id(nextId()) {
   if (dateFormat == NULL) {
     throw IllegalArgumentException(LOG4CXX_STR("dateFormat cannot be null"));
   }
@@ -162,11 +161,30 @@ int CachedDateFormat::findMillisecondStart(
  */
  void CachedDateFormat::format(LogString& buf, log4cxx_time_t now, Pool& p) const {
 
+  unsigned int currentId = id;
+  ThreadSpecificData::DateCacheEntry* entry = ThreadSpecificData::getDateCache(currentId);
+  if (entry == 0) {
+      formatter->format(buf, now, p);
+      return;
+  }
+  //
+  //   If the entry was last used by another format (or before
+  //      a change of timezone), start over.
+  //
+  if (entry->formatId != currentId) {
+      entry->formatId = currentId;
+      entry->millisecondStart = 0;
+      entry->slotBegin = std::numeric_limits<log4cxx_time_t>::min();
+      entry->previousTime = std::numeric_limits<log4cxx_time_t>::min();
+      entry->cache.erase(entry->cache.begin(), entry->cache.end());
+  }
+  LogString& cache = entry->cache;
+
   //
   // If the current requested time is identical to the previously
   //     requested time, then append the cache contents.
   //
-  if (now == previousTime) {
+  if (now == entry->previousTime) {
        buf.append(cache);
        return;
   }
@@ -175,11 +193,12 @@ int CachedDateFormat::findMillisecondStart(
   //   If millisecond pattern was not unrecognized
   //     (that is if it was found or milliseconds did not appear)
   //
-  if (millisecondStart != UNRECOGNIZED_MILLISECONDS) {
+  if (entry->millisecondStart != UNRECOGNIZED_MILLISECONDS) {
 
       //    Check if the cache is still valid.
       //    If the requested time is within the same integral second
       //       as the last request and a shorter expiration was not requested.
+      log4cxx_time_t slotBegin = entry->slotBegin;
       if (now < slotBegin + expiration
           && now >= slotBegin
           && now < slotBegin + 1000000L) {
@@ -187,13 +206,13 @@ int CachedDateFormat::findMillisecondStart(
           //
           //    if there was a millisecond field then update it
           //
-          if (millisecondStart >= 0 ) {
-              millisecondFormat((int) ((now - slotBegin)/1000), cache, millisecondStart);
+          if (entry->millisecondStart >= 0 ) {
+              millisecondFormat((int) ((now - slotBegin)/1000), cache, entry->millisecondStart);
           }
           //
           //   update the previously requested time
           //      (the slot begin should be unchanged)
-          previousTime = now;
+          entry->previousTime = now;
           buf.append(cache);
           return;
       }
@@ -206,10 +225,10 @@ int CachedDateFormat::findMillisecondStart(
   cache.erase(cache.begin(), cache.end());
   formatter->format(cache, now, p);
   buf.append(cache);
-  previousTime = now;
-  slotBegin = (previousTime / 1000000) * 1000000;
-  if (slotBegin > previousTime) {
-      slotBegin -= 1000000;
+  entry->previousTime = now;
+  entry->slotBegin = (now / 1000000) * 1000000;
+  if (entry->slotBegin > now) {
+      entry->slotBegin -= 1000000;
   }
 
 
@@ -217,8 +236,8 @@ int CachedDateFormat::findMillisecondStart(
   //    if the milliseconds field was previous found
   //       then reevaluate in case it moved.
   //
-  if (millisecondStart >= 0) {
-      millisecondStart = findMillisecondStart(now, cache, formatter, p);
+  if (entry->millisecondStart >= 0) {
+      entry->millisecondStart = findMillisecondStart(now, cache, formatter, p);
   }
 }
 
@@ -247,8 +266,16 @@ void CachedDateFormat::millisecondFormat(int millis,
  */
 void CachedDateFormat::setTimeZone(const TimeZonePtr& timeZone) {
   formatter->setTimeZone(timeZone);
-  previousTime = std::numeric_limits<log4cxx_time_t>::min();
-  slotBegin = std::numeric_limits<log4cxx_time_t>::min();
+  id = nextId();
+}
+
+unsigned int CachedDateFormat::nextId() {
+  static apr_uint32_t volatile lastId = 0;
+  unsigned int newId;
+  do {
+      newId = apr_atomic_inc32(&lastId) + 1;
+  } while (newId == 0);
+  return newId;
 }
 
 
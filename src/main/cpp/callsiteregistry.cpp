@@ -0,0 +1,143 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <log4cxx/logstring.h>
+#include <log4cxx/spi/callsiteregistry.h>
+#include <log4cxx/logger.h>
+#include <log4cxx/helpers/synchronized.h>
+#include <apr_atomic.h>
+
+using namespace log4cxx;
+using namespace log4cxx::spi;
+using namespace log4cxx::filter;
+using namespace log4cxx::helpers;
+
+
+CallSiteRegistry::CallSiteRegistry()
+: pool(), mutex(pool), sites(), filters()
+{
+}
+
+CallSiteRegistry::~CallSiteRegistry()
+{
+}
+
+CallSiteRegistry& CallSiteRegistry::getInstance()
+{
+        static CallSiteRegistry registry;
+        return registry;
+}
+
+int CallSiteRegistry::decide(const CallSite& site) const
+{
+        LocationInfo location(site.fileName, site.methodName, site.lineNumber);
+        for(std::vector<LocationInfoFilterPtr>::const_reverse_iterator it = filters.rbegin();
+            it != filters.rend();
+            it++)
+        {
+                Filter::FilterDecision decision = (*it)->decide(location);
+                if (decision != Filter::NEUTRAL)
+                {
+                        return decision;
+                }
+        }
+        return Filter::NEUTRAL;
+}
+
+void CallSiteRegistry::update()
+{
+        for(std::vector<CallSite*>::iterator it = sites.begin();
+            it != sites.end();
+            it++)
+        {
+                apr_atomic_set32((volatile apr_uint32_t*) &(*it)->decision,
+                        (apr_uint32_t) decide(**it));
+        }
+        //
+        //   invalidate the decisions cached by the call sites
+        //
+        apr_atomic_inc32(&Logger::configurationGeneration);
+}
+
+void CallSiteRegistry::addFilter(const LocationInfoFilterPtr& filter)
+{
+        if (filter != 0)
+        {
+                CallSiteRegistry& registry = getInstance();
+                synchronized sync(registry.mutex);
+                registry.filters.push_back(filter);
+                registry.update();
+        }
+}
+
+void CallSiteRegistry::clearFilters()
+{
+        CallSiteRegistry& registry = getInstance();
+        synchronized sync(registry.mutex);
+        registry.filters.clear();
+        registry.update();
+}
+
+LocationInfoList CallSiteRegistry::getCallSites()
+{
+        CallSiteRegistry& registry = getInstance();
+        synchronized sync(registry.mutex);
+        LocationInfoList locations;
+        for(std::vector<CallSite*>::const_iterator it = registry.sites.begin();
+            it != registry.sites.end();
+            it++)
+        {
+                locations.push_back(LocationInfo((*it)->fileName,
+                        (*it)->methodName, (*it)->lineNumber));
+        }
+        return locations;
+}
+
+void CallSiteRegistry::registerCallSite(CallSite& site)
+{
+        CallSiteRegistry& registry = getInstance();
+        synchronized sync(registry.mutex);
+        if (site.registered == 0)
+        {
+                registry.sites.push_back(&site);
+                apr_atomic_set32((volatile apr_uint32_t*) &site.decision,
+                        (apr_uint32_t) registry.decide(site));
+                apr_atomic_set32(&site.registered, 1);
+        }
+}
+
+void CallSiteRegistry::unregisterCallSites(const void* begin, const void* end)
+{
+        CallSiteRegistry& registry = getInstance();
+        synchronized sync(registry.mutex);
+        std::vector<CallSite*>::iterator kept = registry.sites.begin();
+        for(std::vector<CallSite*>::iterator it = registry.sites.begin();
+            it != registry.sites.end();
+            it++)
+        {
+                const char* address = (const char*) *it;
+                if (address >= (const char*) begin && address < (const char*) end)
+                {
+                        apr_atomic_set32(&(*it)->registered, 0);
+                }
+                else
+                {
+                        *kept++ = *it;
+                }
+        }
+        registry.sites.erase(kept, registry.sites.end());
+}
@@ -55,6 +55,10 @@ ConsoleAppender::~ConsoleAppender()
         finalize();
 }
 
+bool ConsoleAppender::formatsBatches() const {
+  return &getClass() == &ConsoleAppender::getStaticClass();
+}
+
 const LogString& ConsoleAppender::getSystemOut() {
   static const LogString name(LOG4CXX_STR("System.out"));
   return name;
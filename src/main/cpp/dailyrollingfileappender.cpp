@@ -93,6 +93,10 @@ void DailyRollingFileAppender::activateOptions(log4cxx::helpers::Pool& p) {
 }
 
 
+bool DailyRollingFileAppender::formatsBatches() const {
+  return &getClass() == &DailyRollingFileAppender::getStaticClass();
+}
+
 void DailyRollingFileAppender::setOption(const LogString& option,
    const LogString& value) {
      if (StringHelper::equalsIgnoreCase(option,
@@ -0,0 +1,607 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <log4cxx/helpers/deferredlog.h>
+#include <log4cxx/helpers/threadspecificdata.h>
+#include <log4cxx/helpers/thread.h>
+#include <log4cxx/helpers/mutex.h>
+#include <log4cxx/helpers/synchronized.h>
+#include <log4cxx/helpers/condition.h>
+#include <log4cxx/helpers/pool.h>
+#include <log4cxx/helpers/exception.h>
+#include <log4cxx/helpers/loglog.h>
+#include <log4cxx/spi/loggingevent.h>
+#include <apr_atomic.h>
+#include <apr_time.h>
+#include <apr_thread_proc.h>
+#include <apr_portable.h>
+#include <apr_pools.h>
+#include <vector>
+
+using namespace log4cxx;
+using namespace log4cxx::spi;
+using namespace log4cxx::helpers;
+
+IMPLEMENT_LOG4CXX_OBJECT(DeferredBuffer)
+
+namespace {
+    /**
+     *  Fixed part of a record, followed by the encoded arguments
+     *  and the copy of the pattern.  A record with a size of zero
+     *  marks unused space at the end of the ring.
+     */
+    struct RecordHeader {
+        apr_uint32_t size;
+        /**
+         *  End of the arguments and start of the pattern.
+         */
+        apr_uint32_t length;
+        int level;
+        const CallSite* site;
+        /**
+         *  Referenced until the record has been processed.
+         */
+        const Logger* logger;
+        /**
+         *  Referenced until the record has been processed,
+         *  null for a standard level.
+         */
+        const Level* customLevel;
+        log4cxx_time_t timestamp;
+    };
+
+    enum {
+        ALIGNMENT = 8,
+        MASK = DeferredBuffer::CAPACITY - 1
+    };
+
+    /**
+     *  Owns the background thread and the buffers of all threads.
+     */
+    class DeferredDispatcher {
+    public:
+        static DeferredDispatcher* getInstance() {
+            static DeferredDispatcher dispatcher;
+            return destructed ? 0 : &dispatcher;
+        }
+
+        ~DeferredDispatcher() {
+            destructed = true;
+            stop();
+        }
+
+        void add(const DeferredBufferPtr& buffer) {
+            synchronized sync(mutex);
+            buffers.push_back(buffer);
+        }
+
+        /**
+         *  Starts the background thread if not running.
+         *  @return true if running.
+         */
+        bool start() {
+            if (apr_atomic_read32(&running) != 0) {
+                return true;
+            }
+            synchronized sync(lifecycle);
+            if (running == 0 && !destructed) {
+                try {
+                    stopping = 0;
+                    thread.run(dispatch, this);
+                    apr_atomic_set32(&running, 1);
+                } catch(ThreadException& ex) {
+                    LogLog::error(LOG4CXX_STR("Unable to start deferred logging thread"), ex);
+                }
+            }
+            return running != 0;
+        }
+
+        /**
+         *  Stops the background thread and processes the pending records
+         *  in the calling thread, including those committed while stopping.
+         */
+        void stop() {
+            synchronized sync(lifecycle);
+            if (running != 0) {
+                {
+                    synchronized sync(mutex);
+                    apr_atomic_set32(&stopping, 1);
+                    wake.signalAll();
+                }
+                thread.join();
+                drainer = apr_os_thread_current();
+                apr_atomic_xchg32(&draining, 1);
+                //
+                //   a request committed after this sees the thread stopped
+                //   and restarts it once the final pass is complete
+                apr_atomic_xchg32(&running, 0);
+                std::vector<DeferredBuffer*> snapshot;
+                while(drainAll(snapshot)) {
+                }
+                apr_atomic_set32(&draining, 0);
+                synchronized sync(mutex);
+                drained.signalAll();
+            }
+        }
+
+        bool isRunning() const {
+            return apr_atomic_read32(&running) != 0;
+        }
+
+        /**
+         *  Returns true while records are processed, by the thread
+         *  or by stop.
+         */
+        bool isActive() const {
+            return isRunning() || apr_atomic_read32(&draining) != 0;
+        }
+
+        /**
+         *  Returns true if called by the thread processing the records.
+         */
+        bool isDispatchThread() const {
+            if (thread.isCurrentThread()) {
+                return true;
+            }
+            return apr_atomic_read32(&draining) != 0 &&
+                apr_os_thread_equal(drainer, apr_os_thread_current());
+        }
+
+        /**
+         *  Wakes the background thread after a record has been committed,
+         *  restarting it if stopped.
+         */
+        void notify() {
+            if (apr_atomic_read32(&running) == 0) {
+                start();
+            } else if (apr_atomic_read32(&idle) != 0) {
+                synchronized sync(mutex);
+                wake.signalAll();
+            }
+        }
+
+        void flush() {
+            std::vector<DeferredBufferPtr> pending;
+            std::vector<unsigned int> heads;
+            {
+                synchronized sync(mutex);
+                pending = buffers;
+            }
+            for(std::vector<DeferredBufferPtr>::iterator iter = pending.begin();
+                iter != pending.end();
+                iter++) {
+                heads.push_back((*iter)->getHead());
+            }
+            synchronized sync(mutex);
+            apr_atomic_inc32(&flushing);
+            try {
+                for(size_t i = 0; i < pending.size(); i++) {
+                    while(((int) (heads[i] - pending[i]->getTail())) > 0 && isActive()) {
+                        drained.await(mutex);
+                    }
+                }
+            } catch(InterruptedException&) {
+                Thread::currentThreadInterrupt();
+            }
+            apr_atomic_dec32(&flushing);
+        }
+
+    private:
+        DeferredDispatcher() : pool(), mutex(pool), lifecycle(pool), wake(pool), drained(pool),
+            buffers(), thread(), running(0), stopping(0), idle(0), flushing(0),
+            draining(0), drainer() {
+        }
+
+        DeferredDispatcher(const DeferredDispatcher&);
+        DeferredDispatcher& operator=(const DeferredDispatcher&);
+
+        static void* LOG4CXX_THREAD_FUNC dispatch(apr_thread_t* /* thread */, void* data) {
+            DeferredDispatcher* dispatcher = (DeferredDispatcher*) data;
+            std::vector<DeferredBuffer*> snapshot;
+            while(apr_atomic_read32(&dispatcher->stopping) == 0) {
+                if (!dispatcher->drainAll(snapshot)) {
+                    dispatcher->waitForRecords();
+                }
+            }
+            return 0;
+        }
+
+        /**
+         *  Waits until a record is committed or the thread is stopped.
+         */
+        void waitForRecords() {
+            synchronized sync(mutex);
+            //
+            //   a committing thread reads idle after publishing its record,
+            //   so either the record is seen here or wake is signaled
+            apr_atomic_xchg32(&idle, 1);
+            if (stopping == 0 && !hasRecords()) {
+                try {
+                    wake.await(mutex);
+                } catch(InterruptedException&) {
+                }
+            }
+            apr_atomic_set32(&idle, 0);
+        }
+
+        /**
+         *  Returns true if any buffer holds a record.  Requires mutex.
+         */
+        bool hasRecords() const {
+            for(std::vector<DeferredBufferPtr>::const_iterator iter = buffers.begin();
+                iter != buffers.end();
+                iter++) {
+                if ((*iter)->getHead() != (*iter)->getTail()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         *  Processes the records of all buffers, discarding buffers
+         *  released by their thread once empty.
+         *  @return true if any record was processed.
+         */
+        bool drainAll(std::vector<DeferredBuffer*>& snapshot) {
+            snapshot.clear();
+            {
+                synchronized sync(mutex);
+                for(std::vector<DeferredBufferPtr>::iterator iter = buffers.begin();
+                    iter != buffers.end();
+                    iter++) {
+                    snapshot.push_back(*iter);
+                }
+            }
+            bool processed = false;
+            for(std::vector<DeferredBuffer*>::iterator iter = snapshot.begin();
+                iter != snapshot.end();
+                iter++) {
+                bool orphaned = (*iter)->isOrphaned();
+                processed |= drain(*iter);
+                if (orphaned) {
+                    synchronized sync(mutex);
+                    for(std::vector<DeferredBufferPtr>::iterator found = buffers.begin();
+                        found != buffers.end();
+                        found++) {
+                        if (found->operator->() == *iter) {
+                            buffers.erase(found);
+                            break;
+                        }
+                    }
+                }
+            }
+            if (processed && apr_atomic_read32(&flushing) != 0) {
+                synchronized sync(mutex);
+                drained.signalAll();
+            }
+            return processed;
+        }
+
+        bool drain(DeferredBuffer* buffer) {
+            unsigned int head = buffer->getHead();
+            unsigned int tail = buffer->getTail();
+            if (head == tail) {
+                return false;
+            }
+            while(tail != head) {
+                const char* record = buffer->getRecord(tail);
+                apr_uint32_t size = ((const RecordHeader*) record)->size;
+                if (size == 0) {
+                    tail += DeferredBuffer::CAPACITY - (tail & MASK);
+                } else {
+                    DeferredLog::dispatch(*buffer, record);
+                    tail += size;
+                }
+                buffer->setTail(tail);
+            }
+            return true;
+        }
+
+        static bool destructed;
+        Pool pool;
+        /**
+         *  Guards buffers, wake and drained.
+         */
+        Mutex mutex;
+        /**
+         *  Serializes starting and stopping the thread.
+         */
+        Mutex lifecycle;
+        /**
+         *  Signaled when a record is committed while the thread is idle.
+         */
+        Condition wake;
+        /**
+         *  Signaled when records have been processed while flushing.
+         */
+        Condition drained;
+        std::vector<DeferredBufferPtr> buffers;
+        Thread thread;
+        mutable apr_uint32_t volatile running;
+        apr_uint32_t volatile stopping;
+        /**
+         *  Non-zero while the thread waits on wake.
+         */
+        apr_uint32_t volatile idle;
+        /**
+         *  Number of threads waiting on drained.
+         */
+        apr_uint32_t volatile flushing;
+        /**
+         *  Non-zero while stop processes the records in drainer.
+         */
+        mutable apr_uint32_t volatile draining;
+        apr_os_thread_t drainer;
+    };
+
+    bool DeferredDispatcher::destructed = false;
+
+    /**
+     *  Decodes one argument into the message.
+     *  @return start of the next argument.
+     */
+    const char* formatArgument(CharMessageBuffer& out, const char* arg) {
+        switch(*arg) {
+            case DeferredLog::TAG_INTEGER: {
+                log4cxx_int64_t val;
+                memcpy(&val, arg + 1, sizeof(val));
+                if (val == (long) val) {
+                    out << (long) val;
+                } else {
+                    out << val;
+                }
+                return arg + 1 + sizeof(val);
+            }
+            case DeferredLog::TAG_UNSIGNED: {
+                log4cxx_uint64_t val;
+                memcpy(&val, arg + 1, sizeof(val));
+                if (val == (unsigned long) val) {
+                    out << (unsigned long) val;
+                } else {
+                    out << val;
+                }
+                return arg + 1 + sizeof(val);
+            }
+            case DeferredLog::TAG_DOUBLE: {
+                double val;
+                memcpy(&val, arg + 1, sizeof(val));
+                out << val;
+                return arg + 1 + sizeof(val);
+            }
+            case DeferredLog::TAG_CHAR:
+                out << arg[1];
+                return arg + 2;
+            case DeferredLog::TAG_STRING: {
+                size_t len;
+                memcpy(&len, arg + 1, sizeof(len));
+                out.append(arg + 1 + sizeof(len), len);
+                return arg + 1 + sizeof(len) + len;
+            }
+        }
+        return 0;
+    }
+
+    void formatMessage(CharMessageBuffer& out, const char* pattern,
+                       const char* args, const char* end) {
+        const char* arg = args;
+        while(arg != 0 && arg < end && BraceFormat::appendLiteral(out, pattern)) {
+            arg = formatArgument(out, arg);
+        }
+        BraceFormat::appendRemainder(out, pattern);
+    }
+}
+
+
+DeferredBuffer::DeferredBuffer()
+    : data(new char[CAPACITY]), threadName(), head(0), tail(0), cachedTail(0), reserved(0) {
+}
+
+DeferredBuffer::DeferredBuffer(const SharedStringPtr& name)
+    : data(new char[CAPACITY]), threadName(name), head(0), tail(0), cachedTail(0), reserved(0) {
+}
+
+DeferredBuffer::~DeferredBuffer() {
+    delete [] data;
+}
+
+bool DeferredBuffer::canWait() const {
+    //
+    //   the dispatch thread never owns records, so a full buffer
+    //   is only abandoned if the thread cannot be started
+    DeferredDispatcher* dispatcher = DeferredDispatcher::getInstance();
+    return dispatcher != 0 && dispatcher->start();
+}
+
+char* DeferredBuffer::reserve(size_t size) {
+    unsigned int offset = head & MASK;
+    unsigned int contiguous = CAPACITY - offset;
+    unsigned int needed = (unsigned int) size;
+    if (needed > contiguous) {
+        needed += contiguous;
+    }
+    while(CAPACITY - (head - cachedTail) < needed) {
+        cachedTail = apr_atomic_read32(&tail);
+        if (CAPACITY - (head - cachedTail) < needed) {
+            if (!canWait()) {
+                return 0;
+            }
+            apr_thread_yield();
+        }
+    }
+    unsigned int start = head;
+    if (size > contiguous) {
+        ((RecordHeader*) (data + offset))->size = 0;
+        start += contiguous;
+    }
+    reserved = start + (unsigned int) size;
+    return data + (start & MASK);
+}
+
+void DeferredBuffer::commit() {
+    apr_atomic_xchg32(&head, reserved);
+}
+
+bool DeferredBuffer::waitUntilEmpty() {
+    while(apr_atomic_read32(&tail) != head) {
+        if (!canWait()) {
+            return false;
+        }
+        apr_thread_yield();
+    }
+    return true;
+}
+
+unsigned int DeferredBuffer::getHead() const {
+    return apr_atomic_add32(const_cast<unsigned int volatile*>(&head), 0);
+}
+
+unsigned int DeferredBuffer::getTail() const {
+    return apr_atomic_read32(const_cast<unsigned int volatile*>(&tail));
+}
+
+const char* DeferredBuffer::getRecord(unsigned int position) const {
+    return data + (position & MASK);
+}
+
+void DeferredBuffer::setTail(unsigned int position) {
+    apr_atomic_xchg32(&tail, position);
+}
+
+bool DeferredBuffer::isOrphaned() const {
+    return apr_atomic_read32(const_cast<unsigned int volatile*>(&ref)) == 1;
+}
+
+
+DeferredBuffer* DeferredLog::reserve(const Logger* logger, const DeferredLevel& level,
+    const CallSite& site, const char* pattern,
+    size_t argumentSize, char*& args) {
+    DeferredDispatcher* dispatcher = DeferredDispatcher::getInstance();
+    if (dispatcher == 0 || dispatcher->isDispatchThread()) {
+        return 0;
+    }
+    DeferredBufferPtr* slot = ThreadSpecificData::getDeferredBuffer();
+    if (slot == 0) {
+        return 0;
+    }
+    if (*slot == 0) {
+        *slot = new DeferredBuffer(ThreadSpecificData::getThreadName());
+        dispatcher->add(*slot);
+    }
+    DeferredBuffer* buffer = *slot;
+    if (!dispatcher->start()) {
+        return 0;
+    }
+    SharedStringPtr threadName(ThreadSpecificData::getThreadName());
+    if (threadName != buffer->getThreadName() && buffer->waitUntilEmpty()) {
+        buffer->setThreadName(threadName);
+    }
+    size_t length = sizeof(RecordHeader) + argumentSize;
+    size_t patternSize = strlen(pattern) + 1;
+    size_t size = (length + patternSize + ALIGNMENT - 1) & ~((size_t) ALIGNMENT - 1);
+    char* record = 0;
+    if (size <= DeferredBuffer::CAPACITY / 2) {
+        record = buffer->reserve(size);
+    }
+    if (record == 0) {
+        //
+        //   logged immediately after the earlier requests
+        buffer->waitUntilEmpty();
+        return 0;
+    }
+    RecordHeader* header = (RecordHeader*) record;
+    header->size = (apr_uint32_t) size;
+    header->length = (apr_uint32_t) length;
+    header->level = level.value;
+    header->site = &site;
+    header->logger = logger;
+    logger->addRef();
+    header->customLevel = level.level;
+    if (level.level != 0) {
+        level.level->addRef();
+    }
+    header->timestamp = apr_time_now();
+    memcpy(record + length, pattern, patternSize);
+    args = record + sizeof(RecordHeader);
+    return buffer;
+}
+
+void DeferredLog::commit(DeferredBuffer* buffer) {
+    buffer->commit();
+    DeferredDispatcher* dispatcher = DeferredDispatcher::getInstance();
+    if (dispatcher != 0) {
+        dispatcher->notify();
+    }
+}
+
+void DeferredLog::flush() {
+    DeferredDispatcher* dispatcher = DeferredDispatcher::getInstance();
+    if (dispatcher != 0 && !dispatcher->isDispatchThread()) {
+        dispatcher->flush();
+    }
+}
+
+void DeferredLog::shutdown() {
+    DeferredDispatcher* dispatcher = DeferredDispatcher::getInstance();
+    if (dispatcher != 0 && !dispatcher->isDispatchThread()) {
+        dispatcher->stop();
+    }
+}
+
+bool DeferredLog::isDispatchThread() {
+    DeferredDispatcher* dispatcher = DeferredDispatcher::getInstance();
+    return dispatcher != 0 && dispatcher->isDispatchThread();
+}
+
+void DeferredLog::dispatch(const DeferredBuffer& buffer, const char* record) {
+    const RecordHeader* header = (const RecordHeader*) record;
+    //
+    //   take over the references held by the record
+    LoggerPtr logger(const_cast<Logger*>(header->logger));
+    header->logger->releaseRef();
+    LevelPtr level;
+    if (header->customLevel != 0) {
+        level = const_cast<Level*>(header->customLevel);
+        header->customLevel->releaseRef();
+    } else {
+        level = Level::toLevel(header->level);
+    }
+    const CallSite* site = header->site;
+    LoggingEventPtr event(LoggingEvent::obtain(logger->sharedName,
+        level, LogString(),
+        LocationInfo(site->fileName, site->methodName, site->lineNumber)));
+    event->timeStamp = header->timestamp;
+    event->threadName = buffer.getThreadName();
+    //
+    //   the context of the background thread does not apply
+    event->ndcLookupRequired = false;
+    event->mdcCopyLookupRequired = false;
+    {
+        CharMessageBuffer out;
+        formatMessage(out, record + header->length,
+            record + sizeof(RecordHeader), record + header->length);
+        out.extract(event->message);
+    }
+    Pool* borrowed = ThreadSpecificData::borrowPool();
+    if (borrowed != 0) {
+        logger->callAppenders(event, *borrowed);
+        ThreadSpecificData::returnPool(borrowed);
+    } else {
+        Pool p;
+        logger->callAppenders(event, p);
+    }
+}
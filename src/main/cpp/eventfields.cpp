@@ -0,0 +1,264 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#if defined(_MSC_VER)
+#pragma warning ( disable: 4231 4251 4275 4786 )
+#endif
+
+#include <log4cxx/logstring.h>
+#include <log4cxx/spi/eventfields.h>
+#include <log4cxx/helpers/stringhelper.h>
+#include <algorithm>
+
+using namespace log4cxx;
+using namespace log4cxx::spi;
+using namespace log4cxx::helpers;
+
+EventField::EventField() : key(0), type(INTEGER), strings(0) {
+    value.integer = 0;
+}
+
+EventField::EventField(const logchar* key1, log4cxx_int64_t value1)
+    : key(key1), type(INTEGER), strings(0) {
+    value.integer = value1;
+}
+
+EventField::EventField(const logchar* key1, log4cxx_uint64_t value1)
+    : key(key1), type(UNSIGNED), strings(0) {
+    value.unsignedInteger = value1;
+}
+
+EventField::EventField(const logchar* key1, double value1)
+    : key(key1), type(DOUBLE), strings(0) {
+    value.real = value1;
+}
+
+EventField::EventField(const logchar* key1, bool value1)
+    : key(key1), type(BOOLEAN), strings(0) {
+    value.boolean = value1;
+}
+
+LogString EventField::getString() const {
+    if (strings == 0) {
+        return LogString();
+    }
+    return strings->substr(value.text.offset, value.text.length);
+}
+
+void EventField::format(LogString& dest) const {
+    char buf[StringHelper::NUMBER_BUFFER_SIZE];
+    size_t len = 0;
+    switch(type) {
+        case INTEGER:
+            len = StringHelper::formatInteger(value.integer, buf);
+            break;
+        case UNSIGNED:
+            len = StringHelper::formatUnsigned(value.unsignedInteger, buf);
+            break;
+        case DOUBLE:
+            len = StringHelper::formatDouble(value.real, buf);
+            break;
+        case BOOLEAN:
+            StringHelper::toString(value.boolean, dest);
+            return;
+        case STRING:
+            if (strings != 0) {
+                dest.append(*strings, value.text.offset, value.text.length);
+            }
+            return;
+    }
+    dest.append(buf, buf + len);
+}
+
+
+EventFields::EventFields() : count(0), strings(), overflow(0) {
+}
+
+EventFields::EventFields(const EventFields& src)
+    : count(src.count), strings(src.strings), overflow(0) {
+    for(size_t i = 0; i < count && i < INLINE_CAPACITY; i++) {
+        fields[i] = src.fields[i];
+    }
+    if (src.overflow != 0) {
+        overflow = new std::vector<EventField>(*src.overflow);
+    }
+    attachStrings();
+}
+
+EventFields& EventFields::operator=(const EventFields& src) {
+    if (this != &src) {
+        EventFields copy(src);
+        swap(copy);
+    }
+    return *this;
+}
+
+EventFields::~EventFields() {
+    delete overflow;
+}
+
+EventField& EventFields::append() {
+    if (count < INLINE_CAPACITY) {
+        return fields[count++];
+    }
+    if (overflow == 0) {
+        overflow = new std::vector<EventField>();
+    }
+    overflow->push_back(EventField());
+    count++;
+    return overflow->back();
+}
+
+EventField& EventFields::at(size_t index) {
+    if (index < INLINE_CAPACITY) {
+        return fields[index];
+    }
+    return (*overflow)[index - INLINE_CAPACITY];
+}
+
+void EventFields::attachStrings() {
+    for(size_t i = 0; i < count; i++) {
+        EventField& field = at(i);
+        if (field.type == EventField::STRING) {
+            field.strings = &strings;
+        }
+    }
+}
+
+EventFields& EventFields::add(const logchar* key, int value) {
+    return add(key, (log4cxx_int64_t) value);
+}
+
+EventFields& EventFields::add(const logchar* key, long value) {
+    return add(key, (log4cxx_int64_t) value);
+}
+
+EventFields& EventFields::add(const logchar* key, unsigned int value) {
+    return add(key, (log4cxx_uint64_t) value);
+}
+
+EventFields& EventFields::add(const logchar* key, unsigned long value) {
+    return add(key, (log4cxx_uint64_t) value);
+}
+
+EventFields& EventFields::add(const logchar* key, log4cxx_int64_t value) {
+    EventField& field = append();
+    field.key = key;
+    field.type = EventField::INTEGER;
+    field.value.integer = value;
+    return *this;
+}
+
+EventFields& EventFields::add(const logchar* key, log4cxx_uint64_t value) {
+    EventField& field = append();
+    field.key = key;
+    field.type = EventField::UNSIGNED;
+    field.value.unsignedInteger = value;
+    return *this;
+}
+
+EventFields& EventFields::add(const logchar* key, double value) {
+    EventField& field = append();
+    field.key = key;
+    field.type = EventField::DOUBLE;
+    field.value.real = value;
+    return *this;
+}
+
+EventFields& EventFields::add(const logchar* key, bool value) {
+    EventField& field = append();
+    field.key = key;
+    field.type = EventField::BOOLEAN;
+    field.value.boolean = value;
+    return *this;
+}
+
+//
+//   string values are appended to strings, which keeps its
+//      capacity when the fields are cleared
+//
+EventFields& EventFields::add(const logchar* key, const logchar* value) {
+    EventField& field = append();
+    field.key = key;
+    field.type = EventField::STRING;
+    field.value.text.offset = strings.length();
+    strings.append(value);
+    field.value.text.length = strings.length() - field.value.text.offset;
+    field.strings = &strings;
+    return *this;
+}
+
+EventFields& EventFields::add(const logchar* key, const LogString& value) {
+    EventField& field = append();
+    field.key = key;
+    field.type = EventField::STRING;
+    field.value.text.offset = strings.length();
+    field.value.text.length = value.length();
+    strings.append(value);
+    field.strings = &strings;
+    return *this;
+}
+
+EventFields& EventFields::add(const EventField& field) {
+    if (field.type == EventField::STRING) {
+        return add(field.key, field.getString());
+    }
+    EventField& added = append();
+    added = field;
+    added.strings = 0;
+    return *this;
+}
+
+const EventField& EventFields::operator[](size_t index) const {
+    if (index < INLINE_CAPACITY) {
+        return fields[index];
+    }
+    return (*overflow)[index - INLINE_CAPACITY];
+}
+
+const EventField* EventFields::find(const LogString& key) const {
+    for(size_t i = count; i > 0; i--) {
+        const EventField& field = (*this)[i - 1];
+        if (key == field.getKey()) {
+            return &field;
+        }
+    }
+    return 0;
+}
+
+void EventFields::clear() {
+    count = 0;
+    strings.erase();
+    if (overflow != 0) {
+        overflow->clear();
+    }
+}
+
+void EventFields::swap(EventFields& other) {
+    size_t inlineCount = count > other.count ? count : other.count;
+    if (inlineCount > INLINE_CAPACITY) {
+        inlineCount = INLINE_CAPACITY;
+    }
+    for(size_t i = 0; i < inlineCount; i++) {
+        std::swap(fields[i], other.fields[i]);
+    }
+    std::swap(count, other.count);
+    strings.swap(other.strings);
+    std::swap(overflow, other.overflow);
+    attachStrings();
+    other.attachStrings();
+}
@@ -0,0 +1,100 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <log4cxx/logstring.h>
+#include <log4cxx/helpers/eventqueue.h>
+#include <apr_atomic.h>
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+using namespace log4cxx::spi;
+
+IMPLEMENT_LOG4CXX_OBJECT(EventQueue)
+
+EventQueue::EventQueue(unsigned int ownerId1, int size)
+    : ownerId(ownerId1), mask(1), events(0), detached(0),
+      head(0), cachedTail(0), offering(0), tail(0) {
+    while((int) mask < size - 1) {
+        mask = (mask << 1) | 1;
+    }
+    events = new LoggingEventPtr[mask + 1];
+}
+
+EventQueue::~EventQueue() {
+    delete [] events;
+}
+
+bool EventQueue::offer(const LoggingEventPtr& event, int limit) {
+    if (limit > (int) mask + 1) {
+        limit = mask + 1;
+    }
+    if ((int) (head - cachedTail) >= limit) {
+        cachedTail = apr_atomic_read32(&tail);
+        if ((int) (head - cachedTail) >= limit) {
+            return false;
+        }
+    }
+    events[head & mask] = event;
+    apr_atomic_xchg32(&head, head + 1);
+    return true;
+}
+
+void EventQueue::beginOffer() {
+    //
+    //   cas32 is a full barrier between setting the mark
+    //     and the owner's following read of the appender's state
+    //
+    apr_atomic_cas32(&offering, 1, 0);
+}
+
+void EventQueue::endOffer() {
+    apr_atomic_set32(&offering, 0);
+}
+
+bool EventQueue::isOffering() const {
+    return apr_atomic_read32(const_cast<unsigned int volatile*>(&offering)) != 0;
+}
+
+bool EventQueue::poll(LoggingEventList& dest) {
+    unsigned int end = apr_atomic_read32(&head);
+    unsigned int position = tail;
+    if (position == end) {
+        return false;
+    }
+    for(; position != end; position++) {
+        dest.push_back(events[position & mask]);
+        events[position & mask] = 0;
+    }
+    apr_atomic_xchg32(&tail, end);
+    return true;
+}
+
+bool EventQueue::isEmpty() const {
+    return apr_atomic_read32(const_cast<unsigned int volatile*>(&head)) == tail;
+}
+
+bool EventQueue::isOrphaned() const {
+    return apr_atomic_read32(const_cast<unsigned int volatile*>(&ref)) == 1;
+}
+
+void EventQueue::detach() {
+    apr_atomic_set32(&detached, 1);
+}
+
+bool EventQueue::isDetached() const {
+    return apr_atomic_read32(const_cast<unsigned int volatile*>(&detached)) != 0;
+}
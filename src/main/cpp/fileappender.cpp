@@ -88,6 +88,10 @@ FileAppender::~FileAppender()
     finalize();
 }
 
+bool FileAppender::formatsBatches() const {
+  return &getClass() == &FileAppender::getStaticClass();
+}
+
 void FileAppender::setAppend(bool fileAppend1) { 
     synchronized sync(mutex);
     this->fileAppend = fileAppend1; 
@@ -32,6 +32,7 @@
 #include <log4cxx/helpers/synchronized.h>
 #include <log4cxx/logstring.h>
 #include <log4cxx/helpers/stringhelper.h>
+#include <log4cxx/helpers/deferredlog.h>
 #if !defined(LOG4CXX)
 #define LOG4CXX 1
 #endif
@@ -48,27 +49,311 @@ using namespace log4cxx::helpers;
 
 IMPLEMENT_LOG4CXX_OBJECT(Hierarchy)
 
+/**
+ *   Node for a logger name.  Nodes are created for the ancestor
+ *   names of each logger as well, so that the parent and children
+ *   of a new logger are found by following the links.
+ */
+class Hierarchy::LoggerNode
+{
+public:
+        typedef std::vector<LoggerNode*> ChildList;
+
+        LoggerNode(const LogString& name1, unsigned int hash1, LoggerNode* parent1)
+            : name(name1), hash(hash1), parent(parent1), logger(), published(0), children()
+        {
+        }
+
+        const LogString name;
+        const unsigned int hash;
+        LoggerNode* const parent;
+
+        /**
+         *   Logger of the name, null for an ancestor name
+         *   without a logger.  Read while holding the lock.
+         */
+        LoggerPtr logger;
+
+        /**
+         *   Copy of logger for lookups without the lock,
+         *   set once the logger is linked to its parent.
+         */
+        Logger* volatile published;
+
+        ChildList children;
+
+private:
+        LoggerNode(const LoggerNode&);
+        LoggerNode& operator=(const LoggerNode&);
+};
+
+/**
+ *   Open addressing hash table of the nodes by name.  Readers probe
+ *   the slots without locking or counting themselves.  Growing or
+ *   clearing the index publishes a new table, the tables and nodes
+ *   it replaces are kept until the index is destroyed since a reader
+ *   may still be probing them.  Writers must be serialized by the caller.
+ */
+class Hierarchy::LoggerIndex
+{
+public:
+        LoggerIndex() : current(new Table(INITIAL_SIZE)), nodes(),
+            retiredTables(), retiredNodes()
+        {
+        }
+
+        ~LoggerIndex()
+        {
+                delete current;
+                for(std::vector<Table*>::iterator it = retiredTables.begin();
+                    it != retiredTables.end();
+                    it++)
+                {
+                        delete *it;
+                }
+                deleteNodes(nodes);
+                deleteNodes(retiredNodes);
+        }
+
+        LoggerPtr find(const LogString& name) const
+        {
+                LoggerPtr logger;
+                const LoggerNode* node = current->find(name, hashCode(name));
+                if (node != 0)
+                {
+                        logger = node->published;
+                }
+                return logger;
+        }
+
+        /**
+         *   Get the node for a name, creating the missing
+         *   nodes of the name and its ancestors.
+         */
+        LoggerNode* getNode(const LogString& name)
+        {
+                unsigned int hash = hashCode(name);
+                LoggerNode* node = current->find(name, hash);
+                if (node == 0)
+                {
+                        LoggerNode* parent = 0;
+                        size_t dot = name.find_last_of(0x2E /* '.' */);
+                        if (dot != LogString::npos)
+                        {
+                                parent = getNode(name.substr(0, dot));
+                        }
+                        node = new LoggerNode(name, hash, parent);
+                        nodes.push_back(node);
+                        if (parent != 0)
+                        {
+                                parent->children.push_back(node);
+                        }
+                        insert(node);
+                }
+                return node;
+        }
+
+        /**
+         *   Makes the logger of a node visible to find.
+         */
+        void publish(LoggerNode* node)
+        {
+                //
+                //   casptr provides the barrier that makes the
+                //   linked logger complete before readers can reach it.
+                //
+                apr_atomic_casptr((volatile void**) &node->published,
+                        (Logger*) node->logger, node->published);
+        }
+
+        /**
+         *   Add the loggers in name order.
+         */
+        void getLoggers(LoggerList& list) const
+        {
+                std::vector<const LoggerNode*> named;
+                for(std::vector<LoggerNode*>::const_iterator it = nodes.begin();
+                    it != nodes.end();
+                    it++)
+                {
+                        if ((*it)->logger != 0)
+                        {
+                                named.push_back(*it);
+                        }
+                }
+                std::sort(named.begin(), named.end(), isBefore);
+                for(std::vector<const LoggerNode*>::const_iterator it = named.begin();
+                    it != named.end();
+                    it++)
+                {
+                        list.push_back((*it)->logger);
+                }
+        }
+
+        void clear()
+        {
+                replace(new Table(INITIAL_SIZE));
+                //
+                //   the nodes keep their loggers for readers
+                //     that reached them before the replacement
+                //
+                retiredNodes.insert(retiredNodes.end(), nodes.begin(), nodes.end());
+                nodes.clear();
+        }
+
+private:
+        enum { INITIAL_SIZE = 64 };
+
+        struct Table
+        {
+                Table(size_t size1) : size(size1), count(0),
+                     slots(new LoggerNode* volatile[size1])
+                {
+                        for(size_t i = 0; i < size; i++)
+                        {
+                                slots[i] = 0;
+                        }
+                }
+                ~Table()
+                {
+                        delete [] slots;
+                }
+
+                LoggerNode* find(const LogString& name, unsigned int hash) const
+                {
+                        for(size_t i = hash & (size - 1); ; i = (i + 1) & (size - 1))
+                        {
+                                LoggerNode* node = slots[i];
+                                if (node == 0 || (node->hash == hash && node->name == name))
+                                {
+                                        return node;
+                                }
+                        }
+                }
+
+                void add(LoggerNode* node)
+                {
+                        size_t i = node->hash & (size - 1);
+                        while(slots[i] != 0)
+                        {
+                                i = (i + 1) & (size - 1);
+                        }
+                        //
+                        //   casptr provides the barrier that makes the node
+                        //   complete before readers can reach it.
+                        //
+                        apr_atomic_casptr((volatile void**) &slots[i], node, 0);
+                        count++;
+                }
+
+                const size_t size;
+                size_t count;
+                LoggerNode* volatile* const slots;
+
+        private:
+                Table(const Table&);
+                Table& operator=(const Table&);
+        };
+
+        static bool isBefore(const LoggerNode* node1, const LoggerNode* node2)
+        {
+                return node1->name < node2->name;
+        }
+
+        static unsigned int hashCode(const LogString& name)
+        {
+                // FNV-1a
+                unsigned int hash = 2166136261U;
+                for(LogString::const_iterator it = name.begin();
+                    it != name.end();
+                    it++)
+                {
+                        hash = (hash ^ (unsigned int) *it) * 16777619U;
+                }
+                return hash;
+        }
+
+        void insert(LoggerNode* node)
+        {
+                //
+                //   keep at least half of the slots free
+                //     so that probe sequences stay short
+                //
+                if ((current->count + 1) * 2 > current->size)
+                {
+                        Table* larger = new Table(current->size * 2);
+                        for(size_t i = 0; i < current->size; i++)
+                        {
+                                if (current->slots[i] != 0)
+                                {
+                                        larger->add(current->slots[i]);
+                                }
+                        }
+                        replace(larger);
+                }
+                current->add(node);
+        }
+
+        void replace(Table* table)
+        {
+                //
+                //   xchgptr makes the new table complete before
+                //     readers can reach it, a reader in find
+                //     may still be probing the previous one.
+                //
+                Table* previous = (Table*) apr_atomic_xchgptr((volatile void**) &current, table);
+                retiredTables.push_back(previous);
+        }
+
+        static void deleteNodes(std::vector<LoggerNode*>& list)
+        {
+                for(std::vector<LoggerNode*>::iterator it = list.begin();
+                    it != list.end();
+                    it++)
+                {
+                        delete *it;
+                }
+                list.clear();
+        }
+
+        Table* volatile current;
+        /**
+         *   All nodes in order of creation.
+         */
+        std::vector<LoggerNode*> nodes;
+        /**
+         *   Tables and nodes replaced by growing or clearing the index.
+         *   The tables replaced by growing hold fewer slots than the
+         *   current one in total.
+         */
+        std::vector<Table*> retiredTables;
+        std::vector<LoggerNode*> retiredNodes;
+
+        LoggerIndex(const LoggerIndex&);
+        LoggerIndex& operator=(const LoggerIndex&);
+};
+
 Hierarchy::Hierarchy() : 
 pool(),
 mutex(pool),
-loggers(new LoggerMap()),
-provisionNodes(new ProvisionNodeMap())
+index(new LoggerIndex()),
+generation(1)
 {
         synchronized sync(mutex);
         root = new RootLogger(pool, Level::getDebug());
         root->setHierarchy(this);
+        root->generation = &generation;
         defaultFactory = new DefaultLoggerFactory();
-        emittedNoAppenderWarning = false;
-        configured = false;
-        thresholdInt = Level::ALL_INT;
+        emittedNoAppenderWarning = 0;
+        configured = 0;
+        thresholdInt = (unsigned int) Level::ALL_INT;
         threshold = Level::getAll();
         emittedNoResourceBundleWarning = false;
 }
 
 Hierarchy::~Hierarchy()
 {
-    delete loggers;
-    delete provisionNodes;
+    delete index;
 }
 
 void Hierarchy::addRef() const {
@@ -95,20 +380,14 @@ void Hierarchy::addHierarchyEventListener(const spi::HierarchyEventListenerPtr&
 void Hierarchy::clear()
 {
         synchronized sync(mutex);
-        loggers->clear();
+        index->clear();
 }
 
 void Hierarchy::emitNoAppenderWarning(const LoggerPtr& logger)
 {
-       bool emitWarning = false;
-       { 
-           synchronized sync(mutex);
-           emitWarning = !emittedNoAppenderWarning;
-           emittedNoAppenderWarning = true;
-       }
-          
         // No appender in hierarchy, warn user only once.
-        if(emitWarning)
+        if(apr_atomic_read32(&emittedNoAppenderWarning) == 0 &&
+           apr_atomic_xchg32(&emittedNoAppenderWarning, 1) == 0)
         {
                 LogLog::warn(((LogString) LOG4CXX_STR("No appender could be found for logger ("))
                    + logger->getName() + LOG4CXX_STR(")."));
@@ -119,17 +398,7 @@ void Hierarchy::emitNoAppenderWarning(const LoggerPtr& logger)
 
 LoggerPtr Hierarchy::exists(const LogString& name)
 {
-        synchronized sync(mutex);
-
-        LoggerPtr logger;
-        LoggerMap::iterator it = loggers->find(name);
-        if (it != loggers->end())
-        {
-                logger = it->second;
-        }
-
-
-        return logger;
+        return index->find(name);
 }
 
 void Hierarchy::setThreshold(const LevelPtr& l)
@@ -137,9 +406,10 @@ void Hierarchy::setThreshold(const LevelPtr& l)
         if (l != 0)
         {
             synchronized sync(mutex);
-            thresholdInt = l->toInt();
             threshold = l;
-            if (thresholdInt != Level::ALL_INT) {
+            apr_atomic_set32(&thresholdInt, (unsigned int) l->toInt());
+            updateGeneration();
+            if (l->toInt() != Level::ALL_INT) {
                setConfigured(true);
             }
         }
@@ -209,28 +479,36 @@ LoggerPtr Hierarchy::getLogger(const LogString& name)
 LoggerPtr Hierarchy::getLogger(const LogString& name,
      const spi::LoggerFactoryPtr& factory)
 {
+        //
+        //   existing loggers are found without taking the lock
+        //
+        LoggerPtr existing(index->find(name));
+        if (existing != 0)
+        {
+                return existing;
+        }
+
         synchronized sync(mutex);
 
-        LoggerMap::iterator it = loggers->find(name);
+        LoggerNode* node = index->getNode(name);
 
-        if (it != loggers->end())
+        if (node->logger != 0)
         {
-                return it->second;
+                return node->logger;
         }
         else
         {
                 LoggerPtr logger(factory->makeNewLoggerInstance(pool, name));
                 logger->setHierarchy(this);
-                loggers->insert(LoggerMap::value_type(name, logger));
-
-                ProvisionNodeMap::iterator it2 = provisionNodes->find(name);
-                if (it2 != provisionNodes->end())
-                {
-                        updateChildren(it2->second, logger);
-                        provisionNodes->erase(it2);
-                }
-
-                updateParents(logger);
+                logger->generation = &generation;
+                node->logger = logger;
+
+                updateChildren(node, logger);
+                updateParents(node, logger);
+                //
+                //   only visible to lock-free lookups once its parent is set
+                //
+                index->publish(node);
                 return logger;
         }
 
@@ -241,13 +519,7 @@ LoggerList Hierarchy::getCurrentLoggers() const
         synchronized sync(mutex);
 
         LoggerList v;
-        LoggerMap::const_iterator it, itEnd = loggers->end();
-
-        for (it = loggers->begin(); it != itEnd; it++)
-        {
-                v.push_back(it->second);
-        }
-
+        index->getLoggers(v);
 
         return v;
 }
@@ -259,15 +531,20 @@ LoggerPtr Hierarchy::getRootLogger() const
 
 bool Hierarchy::isDisabled(int level) const
 {
-   if(!configured) {
+   //
+   //   DefaultConfigurator marks the hierarchy as configured before
+   //   looking for a configuration file, so automatic configuration
+   //   is attempted once and later calls never take the lock.
+   //
+   if(apr_atomic_read32(&configured) == 0) {
       synchronized sync(mutex);
-      if (!configured) {
+      if (apr_atomic_read32(&configured) == 0) {
         DefaultConfigurator::configure(
             const_cast<Hierarchy*>(this));
       }
    }
 
-   return thresholdInt > level;
+   return (int) apr_atomic_read32(&thresholdInt) > level;
 }
 
 
@@ -292,11 +569,16 @@ void Hierarchy::resetConfiguration()
                 logger->setResourceBundle(0);
         }
 
+        updateGeneration();
         //rendererMap.clear();
 }
 
 void Hierarchy::shutdown()
 {
+      //
+      //   deliver deferred requests before closing the appenders
+      DeferredLog::shutdown();
+
       synchronized sync(mutex);
 
       setConfigured(false);
@@ -325,75 +607,56 @@ void Hierarchy::shutdown()
 }
 
 
-void Hierarchy::updateParents(LoggerPtr logger)
+void Hierarchy::updateParents(LoggerNode* node, const LoggerPtr& logger)
 {
-        synchronized sync(mutex);
-        const LogString name(logger->getName());
-        int length = name.size();
-        bool parentFound = false;
-
-
-        // if name = "w.x.y.z", loop thourgh "w.x.y", "w.x" and "w", but not "w.x.y.z"
-        for(size_t i = name.find_last_of(0x2E /* '.' */, length-1);
-            i != LogString::npos;
-            i = name.find_last_of(0x2E /* '.' */, i-1))
+        LoggerNode* ancestor = node->parent;
+        while(ancestor != 0 && ancestor->logger == 0)
         {
-                LogString substr = name.substr(0, i);
-
-                LoggerMap::iterator it = loggers->find(substr);
-                if(it != loggers->end())
-                {
-                        parentFound = true;
-                        logger->parent = it->second;
-                        break; // no need to update the ancestors of the closest ancestor
-                }
-                else
-                {
-                        ProvisionNodeMap::iterator it2 = provisionNodes->find(substr);
-                        if (it2 != provisionNodes->end())
-                        {
-                                it2->second.push_back(logger);
-                        }
-                        else
-                        {
-                                ProvisionNode node(1, logger);
-                                provisionNodes->insert(
-                                        ProvisionNodeMap::value_type(substr, node));
-                        }
-                }
+                ancestor = ancestor->parent;
         }
 
         // If we could not find any existing parents, then link with root.
-        if(!parentFound)
+        if (ancestor != 0)
+        {
+                logger->parent = ancestor->logger;
+        }
+        else
         {
                 logger->parent = root;
         }
+
+        updateGeneration();
 }
 
-void Hierarchy::updateChildren(ProvisionNode& pn, LoggerPtr logger)
+void Hierarchy::updateChildren(LoggerNode* node, const LoggerPtr& logger)
 {
+        LoggerNode::ChildList::iterator it, itEnd = node->children.end();
 
-        ProvisionNode::iterator it, itEnd = pn.end();
-
-        for(it = pn.begin(); it != itEnd; it++)
+        for(it = node->children.begin(); it != itEnd; it++)
         {
-                LoggerPtr& l = *it;
-
-                // Unless this child already points to a correct (lower) parent,
-                // make cat.parent point to l.parent and l.parent to cat.
-                if(!StringHelper::startsWith(l->parent->name, logger->name))
+                LoggerNode* child = *it;
+                if (child->logger != 0)
+                {
+                        child->logger->parent = logger;
+                }
+                else
                 {
-                        logger->parent = l->parent;
-                        l->parent = logger;
+                        updateChildren(child, logger);
                 }
         }
 }
 
 void Hierarchy::setConfigured(bool newValue) {
     synchronized sync(mutex);
-    configured = newValue;
+    apr_atomic_set32(&configured, newValue ? 1 : 0);
+    updateGeneration();
+}
+
+void Hierarchy::updateGeneration() {
+    apr_atomic_inc32(&generation);
+    apr_atomic_inc32(&Logger::configurationGeneration);
 }
 
 bool Hierarchy::isConfigured() {
-    return configured;
+    return apr_atomic_read32(&configured) != 0;
 }
@@ -0,0 +1,137 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <log4cxx/logstring.h>
+#include <log4cxx/filter/locationinfofilter.h>
+#include <log4cxx/spi/loggingevent.h>
+#include <log4cxx/helpers/stringhelper.h>
+#include <log4cxx/helpers/optionconverter.h>
+#include <log4cxx/helpers/transcoder.h>
+
+using namespace log4cxx;
+using namespace log4cxx::filter;
+using namespace log4cxx::spi;
+using namespace log4cxx::helpers;
+
+IMPLEMENT_LOG4CXX_OBJECT(LocationInfoFilter)
+
+
+LocationInfoFilter::LocationInfoFilter()
+: acceptOnMatch(true), fileName(), methodName(), lineNumber(-1)
+{
+}
+
+void LocationInfoFilter::setFileName(const LogString& value) {
+    fileName.erase();
+    Transcoder::encode(value, fileName);
+}
+
+LogString LocationInfoFilter::getFileName() const {
+    LOG4CXX_DECODE_CHAR(value, fileName);
+    return value;
+}
+
+void LocationInfoFilter::setMethodName(const LogString& value) {
+    methodName.erase();
+    Transcoder::encode(value, methodName);
+}
+
+LogString LocationInfoFilter::getMethodName() const {
+    LOG4CXX_DECODE_CHAR(value, methodName);
+    return value;
+}
+
+void LocationInfoFilter::setOption(const LogString& option,
+   const LogString& value)
+{
+
+   if (StringHelper::equalsIgnoreCase(option,
+                 LOG4CXX_STR("FILENAME"), LOG4CXX_STR("filename")))
+   {
+      setFileName(value);
+   }
+   else if (StringHelper::equalsIgnoreCase(option,
+                 LOG4CXX_STR("METHODNAME"), LOG4CXX_STR("methodname")))
+   {
+      setMethodName(value);
+   }
+   else if (StringHelper::equalsIgnoreCase(option,
+                 LOG4CXX_STR("LINENUMBER"), LOG4CXX_STR("linenumber")))
+   {
+      lineNumber = OptionConverter::toInt(value, lineNumber);
+   }
+   else if (StringHelper::equalsIgnoreCase(option,
+                LOG4CXX_STR("ACCEPTONMATCH"), LOG4CXX_STR("acceptonmatch")))
+   {
+      acceptOnMatch = OptionConverter::toBoolean(value, acceptOnMatch);
+   }
+}
+
+bool LocationInfoFilter::matches(const LocationInfo& location) const
+{
+    if (lineNumber != -1 && lineNumber != location.getLineNumber()) {
+      return false;
+    }
+    if (!fileName.empty()) {
+      const char* file = location.getFileName();
+      if (file == 0) {
+        return false;
+      }
+      std::string name(file);
+      if (name.size() < fileName.size() ||
+          name.compare(name.size() - fileName.size(), fileName.size(), fileName) != 0) {
+        return false;
+      }
+      //
+      //   only match whole path components
+      //
+      if (name.size() > fileName.size()) {
+        char separator = name[name.size() - fileName.size() - 1];
+        if (separator != '/' && separator != '\\') {
+          return false;
+        }
+      }
+    }
+    if (!methodName.empty()) {
+      std::string method(location.getMethodName());
+      if (method != methodName &&
+          location.getClassName() + "::" + method != methodName) {
+        return false;
+      }
+    }
+    return true;
+}
+
+Filter::FilterDecision LocationInfoFilter::decide(
+   const LocationInfo& location) const
+{
+    if (matches(location)) {
+      if (acceptOnMatch) {
+        return Filter::ACCEPT;
+      } else {
+        return Filter::DENY;
+      }
+    } else {
+      return Filter::NEUTRAL;
+    }
+}
+
+Filter::FilterDecision LocationInfoFilter::decide(
+   const spi::LoggingEventPtr& event) const
+{
+    return decide(event->getLocationInformation());
+}
@@ -29,11 +29,15 @@
 #include <log4cxx/helpers/transcoder.h>
 #include <log4cxx/helpers/appenderattachableimpl.h>
 #include <log4cxx/helpers/exception.h>
+#include <log4cxx/spi/callsiteregistry.h>
+#include <log4cxx/helpers/threadspecificdata.h>
 #if !defined(LOG4CXX)
 #define LOG4CXX 1
 #endif
 #include <log4cxx/private/log4cxx_private.h>
 #include <log4cxx/helpers/aprinitializer.h>
+#include <apr_atomic.h>
+#include <algorithm>
 
 using namespace log4cxx;
 using namespace log4cxx::helpers;
@@ -41,12 +45,48 @@ using namespace log4cxx::spi;
 
 IMPLEMENT_LOG4CXX_OBJECT(Logger)
 
+namespace {
+    /**
+     *  Pool for a single logging request, the calling thread's
+     *  reusable pool unless that is already in use by an enclosing request.
+     */
+    class RequestPool {
+    public:
+        RequestPool() : borrowed(ThreadSpecificData::borrowPool()), owned(0) {
+            if (borrowed == 0) {
+                owned = new Pool();
+            }
+        }
+
+        ~RequestPool() {
+            if (borrowed != 0) {
+                ThreadSpecificData::returnPool(borrowed);
+            }
+            delete owned;
+        }
+
+        operator Pool&() {
+            return borrowed != 0 ? *borrowed : *owned;
+        }
+
+    private:
+        Pool* borrowed;
+        Pool* owned;
+        RequestPool(const RequestPool&);
+        RequestPool& operator=(const RequestPool&);
+    };
+}
+
+unsigned int volatile Logger::configurationGeneration = 1;
+
 Logger::Logger(Pool& p, const LogString& name1)
-: pool(&p), name(), level(), parent(), resourceBundle(),
-repository(), aai(), mutex(p)
+: pool(&p), name(name1), level(), parent(), resourceBundle(),
+repository(), aai(), mutex(p),
+generation(0), enabledGeneration(0), enabledLevelInt(Level::OFF_INT),
+route(), routeGeneration(0), retiredAppenders(),
+sharedName(new SharedString(name1))
 {
     synchronized sync(mutex);
-    name = name1;
     additive = true;
 }
 
@@ -68,11 +108,13 @@ void Logger::addAppender(const AppenderPtr& newAppender)
    {
         synchronized sync(mutex);
 
-        if (aai == 0)
+        if (newAppender != 0 && (aai == 0 || !aai->isAttached(newAppender)))
         {
-                  aai = new AppenderAttachableImpl(*pool);
+                AppenderAttachableImplPtr snapshot(copyAppenders(aai, *pool));
+                snapshot->addAppender(newAppender);
+                setAppenderSnapshot(aai, snapshot);
+                updateGeneration();
         }
-        aai->addAppender(newAppender);
         rep = repository;
    }
    if (rep != 0) {
@@ -80,21 +122,74 @@ void Logger::addAppender(const AppenderPtr& newAppender)
    }
 }
 
+AppenderAttachableImplPtr Logger::copyAppenders(
+        const AppenderAttachableImplPtr& src, Pool& p)
+{
+        AppenderAttachableImplPtr copy(new AppenderAttachableImpl(p));
+        if (src != 0)
+        {
+                AppenderList appenders(src->getAllAppenders());
+                for(AppenderList::iterator it = appenders.begin();
+                    it != appenders.end();
+                    it++)
+                {
+                        copy->addAppender(*it);
+                }
+        }
+        return copy;
+}
 
-void Logger::callAppenders(const spi::LoggingEventPtr& event, Pool& p) const
+AppenderAttachableImplPtr Logger::getAppenderSnapshot(
+        const AppenderAttachableImplPtr& slot) const
 {
-        int writes = 0;
+        //
+        //   the snapshot read here is not released before the logger
+        //   even if the slot is replaced before its reference is taken.
+        //
+        return slot;
+}
+
+void Logger::setAppenderSnapshot(AppenderAttachableImplPtr& slot,
+        const AppenderAttachableImplPtr& snapshot) const
+{
+        if (slot != 0)
+        {
+                retiredAppenders.push_back(slot);
+        }
+        slot = snapshot;
+}
 
-        for(LoggerPtr logger(const_cast<Logger*>(this)); 
-          logger != 0; 
+
+AppenderList Logger::resolveAppenders() const
+{
+        AppenderList appenders;
+
+        //
+        //   ancestors are held by the repository, walking raw pointers
+        //   avoids reference counting every ancestor.
+        //
+        for(const Logger* logger = this;
+          logger != 0;
          logger = logger->parent)
         {
-                // Protected against simultaneous call to addAppender, removeAppender,...
-                synchronized sync(logger->mutex);
+                // Snapshot is never modified, addAppender, removeAppender,...
+                // replace it instead.
+                AppenderAttachableImplPtr attached(
+                        logger->getAppenderSnapshot(logger->aai));
 
-                if (logger->aai != 0)
+                if (attached != 0)
                 {
-                        writes += logger->aai->appendLoopOnAppenders(event, p);
+                        AppenderList list(attached->getAllAppenders());
+                        for(AppenderList::iterator it = list.begin();
+                            it != list.end();
+                            it++)
+                        {
+                                if (std::find(appenders.begin(), appenders.end(), *it)
+                                    == appenders.end())
+                                {
+                                        appenders.push_back(*it);
+                                }
+                        }
                 }
 
                 if(!logger->additive)
@@ -103,6 +198,91 @@ void Logger::callAppenders(const spi::LoggingEventPtr& event, Pool& p) const
                 }
         }
 
+        return appenders;
+}
+
+AppenderAttachableImplPtr Logger::getRoute() const
+{
+        //
+        //   routeGeneration is zero while route is being replaced,
+        //   reading it again after taking the reference detects a
+        //   replacement that overlapped the read.
+        //
+        unsigned int cached = apr_atomic_read32(&routeGeneration);
+        if (cached != 0 && cached == apr_atomic_read32(generation))
+        {
+                AppenderAttachableImplPtr snapshot(getAppenderSnapshot(route));
+                if (apr_atomic_read32(&routeGeneration) == cached)
+                {
+                        return snapshot;
+                }
+        }
+
+        return updateRoute();
+}
+
+AppenderAttachableImplPtr Logger::updateRoute() const
+{
+        //
+        //   read the generation before resolving so that a concurrent
+        //   change leaves the route stale instead of wrong.
+        //
+        unsigned int current = apr_atomic_read32(generation);
+        AppenderList appenders(resolveAppenders());
+
+        synchronized sync(mutex);
+        //
+        //   only replace the route when it differs, changes to levels
+        //   and the threshold also advance the generation.
+        //
+        bool unchanged = (route == 0) ?
+             appenders.empty() : (route->getAllAppenders() == appenders);
+        if (!unchanged)
+        {
+                AppenderAttachableImplPtr snapshot;
+                if (!appenders.empty())
+                {
+                        snapshot = new AppenderAttachableImpl(*pool);
+                        for(AppenderList::iterator it = appenders.begin();
+                            it != appenders.end();
+                            it++)
+                        {
+                                snapshot->addAppender(*it);
+                        }
+                }
+                apr_atomic_xchg32(&routeGeneration, 0);
+                setAppenderSnapshot(route, snapshot);
+        }
+        apr_atomic_xchg32(&routeGeneration, current);
+        return route;
+}
+
+
+void Logger::callAppenders(const spi::LoggingEventPtr& event, Pool& p) const
+{
+        int writes = 0;
+
+        if (generation != 0)
+        {
+                AppenderAttachableImplPtr appenders(getRoute());
+
+                if (appenders != 0)
+                {
+                        writes = appenders->appendLoopOnAppenders(event, p);
+                }
+        }
+        else
+        {
+                AppenderList appenders(resolveAppenders());
+                for(AppenderList::iterator it = appenders.begin();
+                    it != appenders.end();
+                    it++)
+                {
+                        (*it)->doAppend(event, p);
+                }
+                writes = appenders.size();
+        }
+
         if(writes == 0 && repository != 0)
         {
                 repository->emitNoAppenderWarning(const_cast<Logger*>(this));
@@ -122,18 +302,18 @@ void Logger::closeNestedAppenders()
 void Logger::forcedLog(const LevelPtr& level1, const std::string& message,
         const LocationInfo& location) const
 {
-        Pool p;
+        RequestPool p;
         LOG4CXX_DECODE_CHAR(msg, message);
-        LoggingEventPtr event(new LoggingEvent(name, level1, msg, location));
+        LoggingEventPtr event(LoggingEvent::obtain(sharedName, level1, msg, location));
         callAppenders(event, p);
 }
 
 
 void Logger::forcedLog(const LevelPtr& level1, const std::string& message) const
 {
-        Pool p;
+        RequestPool p;
         LOG4CXX_DECODE_CHAR(msg, message);
-        LoggingEventPtr event(new LoggingEvent(name, level1, msg,
+        LoggingEventPtr event(LoggingEvent::obtain(sharedName, level1, msg,
               LocationInfo::getLocationUnavailable()));
         callAppenders(event, p);
 }
@@ -141,11 +321,95 @@ void Logger::forcedLog(const LevelPtr& level1, const std::string& message) const
 void Logger::forcedLogLS(const LevelPtr& level1, const LogString& message,
         const LocationInfo& location) const
 {
-        Pool p;
-        LoggingEventPtr event(new LoggingEvent(name, level1, message, location));
+        RequestPool p;
+        LoggingEventPtr event(LoggingEvent::obtain(sharedName, level1, message, location));
         callAppenders(event, p);
 }
 
+void Logger::forcedLog(const LevelPtr& level1, MessageBuffer& message,
+        const LocationInfo& location) const
+{
+        RequestPool p;
+        LoggingEventPtr event(LoggingEvent::obtain(sharedName, level1, LogString(), location));
+        message.extract(event->message);
+        callAppenders(event, p);
+}
+
+#if LOG4CXX_WCHAR_T_API
+void Logger::forcedLog(const LevelPtr& level1, CharMessageBuffer& message,
+        const LocationInfo& location) const
+{
+        RequestPool p;
+        LoggingEventPtr event(LoggingEvent::obtain(sharedName, level1, LogString(), location));
+        message.extract(event->message);
+        callAppenders(event, p);
+}
+
+void Logger::forcedLog(const LevelPtr& level1, WideMessageBuffer& message,
+        const LocationInfo& location) const
+{
+        RequestPool p;
+        LoggingEventPtr event(LoggingEvent::obtain(sharedName, level1, LogString(), location));
+        message.extract(event->message);
+        callAppenders(event, p);
+}
+#endif
+
+#if LOG4CXX_UNICHAR_API || LOG4CXX_CFSTRING_API || LOG4CXX_LOGCHAR_IS_UNICHAR
+void Logger::forcedLog(const LevelPtr& level1, UniCharMessageBuffer& message,
+        const LocationInfo& location) const
+{
+        RequestPool p;
+        LoggingEventPtr event(LoggingEvent::obtain(sharedName, level1, LogString(), location));
+        message.extract(event->message);
+        callAppenders(event, p);
+}
+#endif
+
+void Logger::forcedLog(const LevelPtr& level1, MessageBuffer& message,
+        EventFields& fields, const LocationInfo& location) const
+{
+        RequestPool p;
+        LoggingEventPtr event(LoggingEvent::obtain(sharedName, level1, LogString(), location));
+        message.extract(event->message);
+        event->swapFields(fields);
+        callAppenders(event, p);
+}
+
+#if LOG4CXX_WCHAR_T_API
+void Logger::forcedLog(const LevelPtr& level1, CharMessageBuffer& message,
+        EventFields& fields, const LocationInfo& location) const
+{
+        RequestPool p;
+        LoggingEventPtr event(LoggingEvent::obtain(sharedName, level1, LogString(), location));
+        message.extract(event->message);
+        event->swapFields(fields);
+        callAppenders(event, p);
+}
+
+void Logger::forcedLog(const LevelPtr& level1, WideMessageBuffer& message,
+        EventFields& fields, const LocationInfo& location) const
+{
+        RequestPool p;
+        LoggingEventPtr event(LoggingEvent::obtain(sharedName, level1, LogString(), location));
+        message.extract(event->message);
+        event->swapFields(fields);
+        callAppenders(event, p);
+}
+#endif
+
+#if LOG4CXX_UNICHAR_API || LOG4CXX_CFSTRING_API || LOG4CXX_LOGCHAR_IS_UNICHAR
+void Logger::forcedLog(const LevelPtr& level1, UniCharMessageBuffer& message,
+        EventFields& fields, const LocationInfo& location) const
+{
+        RequestPool p;
+        LoggingEventPtr event(LoggingEvent::obtain(sharedName, level1, LogString(), location));
+        message.extract(event->message);
+        event->swapFields(fields);
+        callAppenders(event, p);
+}
+#endif
+
 
 bool Logger::getAdditivity() const
 {
@@ -268,73 +532,92 @@ bool Logger::isAttached(const AppenderPtr& appender) const
 
 bool Logger::isTraceEnabled() const
 {
-        if(repository == 0 || repository->isDisabled(Level::TRACE_INT))
-        {
-                return false;
-        }
-
-        return getEffectiveLevel()->toInt() <= Level::TRACE_INT;
+        return isEnabled(Level::TRACE_INT);
 }
 
 bool Logger::isDebugEnabled() const
 {
-        if(repository == 0 || repository->isDisabled(Level::DEBUG_INT))
+        return isEnabled(Level::DEBUG_INT);
+}
+
+bool Logger::isEnabledFor(const LevelPtr& level1) const
+{
+        return isEnabled(level1->toInt());
+}
+
+bool Logger::isEnabled(int level1) const
+{
+        if (generation != 0)
         {
-                return false;
+                //
+                //   enabledGeneration is zero while enabledLevelInt is
+                //   being replaced, reading it again after the level
+                //   detects a replacement that overlapped the read.
+                //
+                unsigned int cached = apr_atomic_read32(&enabledGeneration);
+                if (cached != 0 && cached == apr_atomic_read32(generation))
+                {
+                        int enabled = enabledLevelInt;
+                        if (apr_atomic_read32(&enabledGeneration) == cached)
+                        {
+                                return level1 >= enabled;
+                        }
+                }
         }
 
-        return getEffectiveLevel()->toInt() <= Level::DEBUG_INT;
+        return updateEnabledLevel(level1);
 }
 
-bool Logger::isEnabledFor(const LevelPtr& level1) const
+bool Logger::updateEnabledLevel(int level1) const
 {
-        if(repository == 0 || repository->isDisabled(level1->toInt()))
+        if (repository == 0)
         {
                 return false;
         }
 
-        return level1->isGreaterOrEqual(getEffectiveLevel());
+        //
+        //   read the generation before evaluating so that a concurrent
+        //   change leaves the cache stale instead of wrong.
+        //
+        unsigned int current = (generation == 0) ? 0 : apr_atomic_read32(generation);
+        bool disabled = repository->isDisabled(level1);
+        int effective = getEffectiveLevel()->toInt();
+
+        //
+        //   isDisabled() retries auto-configuration until the repository
+        //   is configured, don't bypass it before then.
+        //
+        if (generation != 0 && repository->isConfigured())
+        {
+                int threshold = repository->getThreshold()->toInt();
+                synchronized sync(mutex);
+                apr_atomic_xchg32(&enabledGeneration, 0);
+                enabledLevelInt = (threshold > effective) ? threshold : effective;
+                apr_atomic_xchg32(&enabledGeneration, current);
+        }
+
+        return !disabled && level1 >= effective;
 }
 
 
 bool Logger::isInfoEnabled() const
 {
-        if(repository == 0 || repository->isDisabled(Level::INFO_INT))
-        {
-                return false;
-        }
-
-        return getEffectiveLevel()->toInt() <= Level::INFO_INT;
+        return isEnabled(Level::INFO_INT);
 }
 
 bool Logger::isErrorEnabled() const
 {
-        if(repository == 0 || repository->isDisabled(Level::ERROR_INT))
-        {
-                return false;
-        }
-
-        return getEffectiveLevel()->toInt() <= Level::ERROR_INT;
+        return isEnabled(Level::ERROR_INT);
 }
 
 bool Logger::isWarnEnabled() const
 {
-        if(repository == 0 || repository->isDisabled(Level::WARN_INT))
-        {
-                return false;
-        }
-
-        return getEffectiveLevel()->toInt() <= Level::WARN_INT;
+        return isEnabled(Level::WARN_INT);
 }
 
 bool Logger::isFatalEnabled() const
 {
-        if(repository == 0 || repository->isDisabled(Level::FATAL_INT))
-        {
-                return false;
-        }
-
-        return getEffectiveLevel()->toInt() <= Level::FATAL_INT;
+        return isEnabled(Level::FATAL_INT);
 }
 
 /*void Logger::l7dlog(const LevelPtr& level, const String& key,
@@ -365,12 +648,7 @@ bool Logger::isFatalEnabled() const
 void Logger::l7dlog(const LevelPtr& level1, const LogString& key,
                     const LocationInfo& location, const std::vector<LogString>& params) const
 {
-        if (repository == 0 || repository->isDisabled(level1->toInt()))
-        {
-                return;
-        }
-
-        if (level1->isGreaterOrEqual(getEffectiveLevel()))
+        if (isEnabled(level1->toInt()))
         {
                 LogString pattern = getResourceBundleString(key);
                 LogString msg;
@@ -442,8 +720,17 @@ void Logger::removeAllAppenders()
 
         if(aai != 0)
         {
-                aai->removeAllAppenders();
-                aai = 0;
+                AppenderList appenders(aai->getAllAppenders());
+                setAppenderSnapshot(aai, 0);
+                apr_atomic_xchg32(&routeGeneration, 0);
+                setAppenderSnapshot(route, 0);
+                updateGeneration();
+                for(AppenderList::iterator it = appenders.begin();
+                    it != appenders.end();
+                    it++)
+                {
+                        (*it)->close();
+                }
         }
 }
 
@@ -451,30 +738,37 @@ void Logger::removeAppender(const AppenderPtr& appender)
 {
         synchronized sync(mutex);
 
-        if(appender == 0 || aai == 0)
+        if(appender == 0 || aai == 0 || !aai->isAttached(appender))
         {
                 return;
         }
 
-        aai->removeAppender(appender);
+        AppenderAttachableImplPtr snapshot(copyAppenders(aai, *pool));
+        snapshot->removeAppender(appender);
+        setAppenderSnapshot(aai, snapshot);
+        updateGeneration();
 }
 
 void Logger::removeAppender(const LogString& name1)
 {
         synchronized sync(mutex);
 
-        if(name1.empty() || aai == 0)
+        if(name1.empty() || aai == 0 || aai->getAppender(name1) == 0)
         {
                 return;
         }
 
-        aai->removeAppender(name1);
+        AppenderAttachableImplPtr snapshot(copyAppenders(aai, *pool));
+        snapshot->removeAppender(name1);
+        setAppenderSnapshot(aai, snapshot);
+        updateGeneration();
 }
 
 void Logger::setAdditivity(bool additive1)
 {
         synchronized sync(mutex);
         this->additive = additive1;
+        updateGeneration();
 }
 
 void Logger::setHierarchy(spi::LoggerRepository * repository1)
@@ -485,6 +779,56 @@ void Logger::setHierarchy(spi::LoggerRepository * repository1)
 void Logger::setLevel(const LevelPtr& level1)
 {
         this->level = level1;
+        updateGeneration();
+}
+
+void Logger::updateGeneration()
+{
+        if (generation != 0)
+        {
+                apr_atomic_inc32(generation);
+                apr_atomic_inc32(&configurationGeneration);
+        }
+}
+
+bool Logger::updateCallSite(spi::CallSite& site, int level1) const
+{
+        //
+        //   read the generation before evaluating so that a concurrent
+        //   change leaves the call site stale instead of wrong.
+        //
+        unsigned int current = apr_atomic_read32(&configurationGeneration);
+        if (apr_atomic_read32(&site.registered) == 0)
+        {
+                CallSiteRegistry::registerCallSite(site);
+        }
+        int decision = (int) apr_atomic_read32((volatile apr_uint32_t*) &site.decision);
+        bool enabled;
+        if (decision == Filter::NEUTRAL)
+        {
+                enabled = isEnabled(level1);
+        }
+        else
+        {
+                enabled = (decision == Filter::ACCEPT);
+        }
+
+        //
+        //   only cache where the level is cached, see updateEnabledLevel.
+        //
+        if (generation != 0 && repository != 0 && repository->isConfigured())
+        {
+                if (site.logger == 0)
+                {
+                        apr_atomic_casptr((volatile void**) &site.logger,
+                                const_cast<Logger*>(this), 0);
+                }
+                if (site.logger == this)
+                {
+                        apr_atomic_set32(&site.state, (current << 1) | (enabled ? 1 : 0));
+                }
+        }
+        return enabled;
 }
 
 
@@ -623,17 +967,17 @@ LoggerPtr Logger::getLoggerLS(const LogString& name) {
 void Logger::forcedLog(const LevelPtr& level1, const std::wstring& message,
         const LocationInfo& location) const
 {
-        Pool p;
+        RequestPool p;
         LOG4CXX_DECODE_WCHAR(msg, message);
-        LoggingEventPtr event(new LoggingEvent(name, level1, msg, location));
+        LoggingEventPtr event(LoggingEvent::obtain(sharedName, level1, msg, location));
         callAppenders(event, p);
 }
 
 void Logger::forcedLog(const LevelPtr& level1, const std::wstring& message) const
 {
-        Pool p;
+        RequestPool p;
         LOG4CXX_DECODE_WCHAR(msg, message);
-        LoggingEventPtr event(new LoggingEvent(name, level1, msg,
+        LoggingEventPtr event(LoggingEvent::obtain(sharedName, level1, msg,
            LocationInfo::getLocationUnavailable()));
         callAppenders(event, p);
 }
@@ -745,17 +1089,17 @@ void Logger::warn(const std::wstring& msg) const {
 void Logger::forcedLog(const LevelPtr& level1, const std::basic_string<UniChar>& message,
         const LocationInfo& location) const
 {
-        Pool p;
+        RequestPool p;
         LOG4CXX_DECODE_UNICHAR(msg, message);
-        LoggingEventPtr event(new LoggingEvent(name, level1, msg, location));
+        LoggingEventPtr event(LoggingEvent::obtain(sharedName, level1, msg, location));
         callAppenders(event, p);
 }
 
 void Logger::forcedLog(const LevelPtr& level1, const std::basic_string<UniChar>& message) const
 {
-        Pool p;
+        RequestPool p;
         LOG4CXX_DECODE_UNICHAR(msg, message);
-        LoggingEventPtr event(new LoggingEvent(name, level1, msg,
+        LoggingEventPtr event(LoggingEvent::obtain(sharedName, level1, msg,
            LocationInfo::getLocationUnavailable()));
         callAppenders(event, p);
 }
@@ -864,17 +1208,17 @@ void Logger::warn(const std::basic_string<UniChar>& msg) const {
 void Logger::forcedLog(const LevelPtr& level1, const CFStringRef& message,
         const LocationInfo& location) const
 {
-        Pool p;
+        RequestPool p;
         LOG4CXX_DECODE_CFSTRING(msg, message);
-        LoggingEventPtr event(new LoggingEvent(name, level1, msg, location));
+        LoggingEventPtr event(LoggingEvent::obtain(sharedName, level1, msg, location));
         callAppenders(event, p);
 }
 
 void Logger::forcedLog(const LevelPtr& level1, const CFStringRef& message) const
 {
-        Pool p;
+        RequestPool p;
         LOG4CXX_DECODE_CFSTRING(msg, message);
-        LoggingEventPtr event(new LoggingEvent(name, level1, msg,
+        LoggingEventPtr event(LoggingEvent::obtain(sharedName, level1, msg,
            LocationInfo::getLocationUnavailable()));
         callAppenders(event, p);
 }
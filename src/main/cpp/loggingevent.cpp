@@ -37,6 +37,9 @@
 #include <log4cxx/helpers/bytebuffer.h>
 #include <log4cxx/logger.h>
 #include <log4cxx/private/log4cxx_private.h>
+#include <log4cxx/helpers/synchronized.h>
+#include <log4cxx/helpers/mutex.h>
+#include <apr_atomic.h>
 
 using namespace log4cxx;
 using namespace log4cxx::spi;
@@ -44,6 +47,82 @@ using namespace log4cxx::helpers;
 
 IMPLEMENT_LOG4CXX_OBJECT(LoggingEvent)
 
+namespace {
+    /**
+     *  Recycled events shared between threads.  Threads keep a small
+     *  cache of their own and exchange events with this list in batches,
+     *  so events released on one thread, such as the AsyncAppender
+     *  dispatcher, become available to the threads that log.
+     */
+    class LoggingEventRecycler {
+    public:
+        static const size_t THREAD_CACHE_SIZE = 64;
+        static const size_t TRANSFER_SIZE = 32;
+        static const size_t SHARED_SIZE = 1024;
+
+        static LoggingEventRecycler* getInstance() {
+            static LoggingEventRecycler recycler;
+            return destructed ? 0 : &recycler;
+        }
+
+        ~LoggingEventRecycler() {
+            destructed = true;
+            deleteAll(events);
+        }
+
+        /**
+         *  Moves up to TRANSFER_SIZE events to the thread cache.
+         */
+        void take(ThreadSpecificData::EventCache& cache) {
+            synchronized sync(mutex);
+            size_t count = events.size() < TRANSFER_SIZE ? events.size() : TRANSFER_SIZE;
+            cache.insert(cache.end(), events.end() - count, events.end());
+            events.resize(events.size() - count);
+        }
+
+        /**
+         *  Moves TRANSFER_SIZE events from the thread cache,
+         *  deleting those that do not fit.
+         */
+        void give(ThreadSpecificData::EventCache& cache) {
+            ThreadSpecificData::EventCache::iterator first = cache.end() - TRANSFER_SIZE;
+            {
+                synchronized sync(mutex);
+                size_t count = SHARED_SIZE - events.size();
+                if (count > TRANSFER_SIZE) {
+                    count = TRANSFER_SIZE;
+                }
+                events.insert(events.end(), first, first + count);
+                first += count;
+            }
+            ThreadSpecificData::EventCache excess(first, cache.end());
+            cache.resize(cache.size() - TRANSFER_SIZE);
+            deleteAll(excess);
+        }
+
+    private:
+        LoggingEventRecycler() : pool(), mutex(pool), events() {
+            events.reserve(SHARED_SIZE);
+        }
+
+        static void deleteAll(ThreadSpecificData::EventCache& list) {
+            for(ThreadSpecificData::EventCache::iterator iter = list.begin();
+                iter != list.end();
+                iter++) {
+                delete *iter;
+            }
+            list.clear();
+        }
+
+        static bool destructed;
+        Pool pool;
+        Mutex mutex;
+        ThreadSpecificData::EventCache events;
+    };
+
+    bool LoggingEventRecycler::destructed = false;
+}
+
 
 //
 //   Accessor for start time.
@@ -53,29 +132,53 @@ log4cxx_time_t LoggingEvent::getStartTime() {
 }
 
 LoggingEvent::LoggingEvent() :
+   logger(new SharedString()),
    ndc(0),
    mdcCopy(0),
    properties(0),
+   fields(0),
    ndcLookupRequired(true),
    mdcCopyLookupRequired(true),
    timeStamp(0),
-   locationInfo() {
+   locationInfo(),
+   threadName(new SharedString()),
+   recyclable(false) {
 }
 
 LoggingEvent::LoggingEvent(
         const LogString& logger1, const LevelPtr& level1,
         const LogString& message1, const LocationInfo& locationInfo1) :
+   logger(new SharedString(logger1)),
+   level(level1),
+   ndc(0),
+   mdcCopy(0),
+   properties(0),
+   fields(0),
+   ndcLookupRequired(true),
+   mdcCopyLookupRequired(true),
+   message(message1),
+   timeStamp(apr_time_now()),
+   locationInfo(locationInfo1),
+   threadName(ThreadSpecificData::getThreadName()),
+   recyclable(false) {
+}
+
+LoggingEvent::LoggingEvent(
+        const SharedStringPtr& logger1, const LevelPtr& level1,
+        const LogString& message1, const LocationInfo& locationInfo1) :
    logger(logger1),
    level(level1),
    ndc(0),
    mdcCopy(0),
    properties(0),
+   fields(0),
    ndcLookupRequired(true),
    mdcCopyLookupRequired(true),
    message(message1),
    timeStamp(apr_time_now()),
    locationInfo(locationInfo1),
-   threadName(getCurrentThreadName()) {
+   threadName(ThreadSpecificData::getThreadName()),
+   recyclable(false) {
 }
 
 LoggingEvent::~LoggingEvent()
@@ -83,6 +186,113 @@ LoggingEvent::~LoggingEvent()
         delete ndc;
         delete mdcCopy;
         delete properties;
+        delete fields;
+}
+
+LoggingEvent* LoggingEvent::obtain(
+        const LogString& logger1, const LevelPtr& level1,
+        const LogString& message1, const LocationInfo& locationInfo1)
+{
+        return obtain(SharedStringPtr(new SharedString(logger1)),
+            level1, message1, locationInfo1);
+}
+
+LoggingEvent* LoggingEvent::obtain(
+        const SharedStringPtr& logger1, const LevelPtr& level1,
+        const LogString& message1, const LocationInfo& locationInfo1)
+{
+        LoggingEvent* event = takeRecycled();
+        if (event == 0) {
+            event = new LoggingEvent(logger1, level1, message1, locationInfo1);
+            event->recyclable = true;
+        } else {
+            event->reset(logger1, level1, message1, locationInfo1);
+        }
+        return event;
+}
+
+LoggingEvent* LoggingEvent::takeRecycled()
+{
+        ThreadSpecificData::EventCache* cache = ThreadSpecificData::getEventCache();
+        if (cache == 0) {
+            return 0;
+        }
+        if (cache->empty()) {
+            LoggingEventRecycler* recycler = LoggingEventRecycler::getInstance();
+            if (recycler != 0) {
+                recycler->take(*cache);
+            }
+            if (cache->empty()) {
+                return 0;
+            }
+        }
+        LoggingEvent* event = cache->back();
+        cache->pop_back();
+        return event;
+}
+
+void LoggingEvent::releaseRef() const
+{
+        if (apr_atomic_dec32(&ref) == 0)
+        {
+                if (recyclable && !APRInitializer::isDestructed)
+                {
+                        const_cast<LoggingEvent*>(this)->recycle();
+                }
+                else
+                {
+                        delete this;
+                }
+        }
+}
+
+void LoggingEvent::reset(
+        const SharedStringPtr& logger1, const LevelPtr& level1,
+        const LogString& message1, const LocationInfo& locationInfo1)
+{
+        logger = logger1;
+        level = level1;
+        message = message1;
+        timeStamp = apr_time_now();
+        locationInfo = locationInfo1;
+        threadName = ThreadSpecificData::getThreadName();
+}
+
+void LoggingEvent::recycle()
+{
+        ThreadSpecificData::EventCache* cache = ThreadSpecificData::getEventCache();
+        if (cache == 0) {
+            delete this;
+            return;
+        }
+        logger = 0;
+        level = 0;
+        delete ndc;
+        ndc = 0;
+        delete mdcCopy;
+        mdcCopy = 0;
+        delete properties;
+        properties = 0;
+        if (fields != 0) {
+            fields->clear();
+        }
+        ndcLookupRequired = true;
+        mdcCopyLookupRequired = true;
+        //
+        //   the message is erased rather than released
+        //      so its capacity is reused by the next event
+        message.erase();
+        threadName = 0;
+        locationInfo.clear();
+        if (cache->size() >= LoggingEventRecycler::THREAD_CACHE_SIZE) {
+            LoggingEventRecycler* recycler = LoggingEventRecycler::getInstance();
+            if (recycler == 0) {
+                delete this;
+                return;
+            }
+            recycler->give(*cache);
+        }
+        cache->push_back(this);
 }
 
 bool LoggingEvent::getNDC(LogString& dest) const
@@ -202,27 +412,6 @@ LoggingEvent::KeySet LoggingEvent::getPropertyKeySet() const
 }
 
 
-const LogString LoggingEvent::getCurrentThreadName() {
-#if APR_HAS_THREADS
-#if defined(_WIN32)
-   char result[20];
-   DWORD threadId = GetCurrentThreadId();
-   apr_snprintf(result, sizeof(result), LOG4CXX_WIN32_THREAD_FMTSPEC, threadId);
-#else
-   // apr_os_thread_t encoded in HEX takes needs as many characters
-   // as two times the size of the type, plus an additional null byte.
-   char result[sizeof(apr_os_thread_t) * 3 + 10];
-   apr_os_thread_t threadId = apr_os_thread_current();
-   apr_snprintf(result, sizeof(result), LOG4CXX_APR_THREAD_FMTSPEC, (void*) &threadId);
-#endif
-   LOG4CXX_DECODE_CHAR(str, (const char*) result);
-   return str;
-#else
-   return LOG4CXX_STR("0x00000000");
-#endif
-}
-
-
 void LoggingEvent::setProperty(const LogString& key, const LogString& value)
 {
         if (properties == 0)
@@ -233,6 +422,55 @@ void LoggingEvent::setProperty(const LogString& key, const LogString& value)
         (*properties)[key] = value;
 }
 
+void LoggingEvent::setFields(const EventFields& fields1)
+{
+        if (fields == 0)
+        {
+                fields = new EventFields(fields1);
+        }
+        else
+        {
+                *fields = fields1;
+        }
+}
+
+void LoggingEvent::swapFields(EventFields& fields1)
+{
+        if (fields == 0)
+        {
+                fields = new EventFields();
+        }
+        fields->swap(fields1);
+}
+
+size_t LoggingEvent::getFieldCount() const
+{
+        return fields == 0 ? 0 : fields->size();
+}
+
+const EventField& LoggingEvent::getField(size_t index) const
+{
+        return (*fields)[index];
+}
+
+bool LoggingEvent::getField(const LogString& key, LogString& dest) const
+{
+        if (fields == 0)
+        {
+                return false;
+        }
+
+        const EventField* field = fields->find(key);
+
+        if (field != 0)
+        {
+                field->format(dest);
+                return true;
+        }
+
+        return false;
+}
+
 
 
 void LoggingEvent::writeProlog(ObjectOutputStream& os, Pool& p)  {
@@ -17,13 +17,202 @@
 
 #include <log4cxx/helpers/messagebuffer.h>
 #include <log4cxx/helpers/transcoder.h>
+#if !defined(LOG4CXX)
+#define LOG4CXX 1
+#endif
+#include <log4cxx/private/log4cxx_private.h>
+#include <log4cxx/helpers/threadspecificdata.h>
+#include <log4cxx/helpers/stringhelper.h>
+#include <locale>
 
 using namespace log4cxx::helpers;
 
-CharMessageBuffer::CharMessageBuffer() : stream(0) {}
+namespace {
+   /**
+    *  Largest buffer kept for reuse by a thread.
+    */
+   enum { MAX_CACHED_CAPACITY = 64 * 1024 };
+
+   /**
+    *  Stream buffer that appends to the string of a message buffer,
+    *  so content written to the stream is never copied back.
+    */
+   template<class T>
+   class StringAppender : public std::basic_streambuf<T> {
+   public:
+      typedef typename std::basic_streambuf<T>::int_type int_type;
+      typedef typename std::basic_streambuf<T>::traits_type traits_type;
+
+      StringAppender() : target(0), classic(this->getloc() == std::locale::classic()) {
+      }
+
+      void setTarget(std::basic_string<T>* dst) {
+         target = dst;
+      }
+
+      /**
+       *  True if the imbued locale is "C", decided when imbued.
+       */
+      bool isClassic() const {
+         return classic;
+      }
+
+   protected:
+      void imbue(const std::locale& loc) {
+         classic = (loc == std::locale::classic());
+      }
+
+      int_type overflow(int_type c) {
+         if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            target->append(1, traits_type::to_char_type(c));
+         }
+         return traits_type::not_eof(c);
+      }
+
+      std::streamsize xsputn(const T* s, std::streamsize n) {
+         target->append(s, (size_t) n);
+         return n;
+      }
+
+   private:
+      std::basic_string<T>* target;
+      bool classic;
+   };
+
+   template<class T>
+   class MessageStream : public std::basic_ostream<T> {
+   public:
+      MessageStream() : std::basic_ostream<T>(0), appender() {
+         this->rdbuf(&appender);
+      }
+
+      StringAppender<T> appender;
+   };
+
+   /**
+    *  Takes the thread's cached stream, or creates one, and directs
+    *  it to the buffer.  The global locale is compared once here,
+    *  so a locale imbued by an earlier message does not persist.
+    */
+   template<class T>
+   std::basic_ostream<T>* takeStream(std::basic_ostream<T>** slot, std::basic_string<T>& buf) {
+      MessageStream<T>* stream;
+      if (slot != 0 && *slot != 0) {
+         stream = static_cast<MessageStream<T>*>(*slot);
+         *slot = 0;
+         std::locale global;
+         if (stream->getloc() != global) {
+            stream->imbue(global);
+         }
+      } else {
+         stream = new MessageStream<T>();
+      }
+      stream->appender.setTarget(&buf);
+      return stream;
+   }
+
+   /**
+    *  Returns a stream to the thread's cache in its initial state,
+    *  deleting it if the cache already holds one.
+    */
+   template<class T>
+   void releaseStream(std::basic_ostream<T>** slot, std::basic_ostream<T>* stream) {
+      static_cast<MessageStream<T>*>(stream)->appender.setTarget(0);
+      if (slot != 0 && *slot == 0) {
+         stream->clear();
+         stream->flags(std::ios_base::skipws | std::ios_base::dec);
+         stream->precision(6);
+         stream->width(0);
+         stream->fill((T) 0x20);
+         *slot = stream;
+      } else {
+         delete stream;
+      }
+   }
+
+   template<class T>
+   void takeBuffer(std::basic_string<T>* slot, std::basic_string<T>& buf) {
+      if (slot != 0) {
+         buf.swap(*slot);
+      }
+   }
+
+   /**
+    *  Returns a buffer's storage to the thread's cache
+    *  if larger than what the cache holds.
+    */
+   template<class T>
+   void releaseBuffer(std::basic_string<T>* slot, std::basic_string<T>& buf) {
+      if (slot != 0 && buf.capacity() > slot->capacity()
+          && buf.capacity() <= (size_t) MAX_CACHED_CAPACITY) {
+         buf.erase();
+         buf.swap(*slot);
+      }
+   }
+
+   /**
+    *  Numbers are appended without num_put when the stream
+    *  has its initial formatting state and the "C" locale.
+    */
+   template<class T>
+   bool formatsDirectly(std::basic_ostream<T>& stream) {
+      return stream.flags() == (std::ios_base::skipws | std::ios_base::dec)
+         && stream.width() == 0 && stream.good()
+         && static_cast<MessageStream<T>&>(stream).appender.isClassic();
+   }
+
+   template<class T>
+   bool appendInteger(std::basic_ostream<T>& stream,
+                      std::basic_string<T>& buf, log4cxx_int64_t val) {
+      if (formatsDirectly(stream)) {
+         char digits[StringHelper::NUMBER_BUFFER_SIZE];
+         size_t len = StringHelper::formatInteger(val, digits);
+         buf.append(digits, digits + len);
+         return true;
+      }
+      return false;
+   }
+
+   template<class T>
+   bool appendUnsigned(std::basic_ostream<T>& stream,
+                       std::basic_string<T>& buf, unsigned long val) {
+      if (formatsDirectly(stream)) {
+         char digits[StringHelper::NUMBER_BUFFER_SIZE];
+         size_t len = StringHelper::formatUnsigned(val, digits);
+         buf.append(digits, digits + len);
+         return true;
+      }
+      return false;
+   }
+
+   template<class T>
+   bool appendDouble(std::basic_ostream<T>& stream,
+                     std::basic_string<T>& buf, double val) {
+      if (stream.precision() == 6 && formatsDirectly(stream)) {
+         char digits[StringHelper::NUMBER_BUFFER_SIZE];
+         size_t len = StringHelper::formatDouble(val, digits);
+         buf.append(digits, digits + len);
+         return true;
+      }
+      return false;
+   }
+}
+
+CharMessageBuffer::CharMessageBuffer() : stream(0) {
+   ThreadSpecificData::MessageBufferCache* cache = ThreadSpecificData::getMessageBufferCache();
+   if (cache != 0) {
+      takeBuffer(&cache->charBuffer, buf);
+   }
+}
 
 CharMessageBuffer::~CharMessageBuffer() {
-   delete stream;
+   ThreadSpecificData::MessageBufferCache* cache = ThreadSpecificData::getMessageBufferCache();
+   if (stream != 0) {
+      releaseStream(cache != 0 ? &cache->charStream : 0, stream);
+   }
+   if (cache != 0) {
+      releaseBuffer(&cache->charBuffer, buf);
+   }
 }
 
 CharMessageBuffer& CharMessageBuffer::operator<<(const std::basic_string<char>& msg) {
@@ -55,24 +244,29 @@ CharMessageBuffer& CharMessageBuffer::operator<<(const char msg) {
    if (stream == 0) {
       buf.append(1, msg);
    } else {
-      buf.assign(1, msg);
-      *stream << buf;
+      *stream << msg;
+   }
+   return *this;
+}
+
+CharMessageBuffer& CharMessageBuffer::append(const char* msg, size_t len) {
+   if (stream == 0) {
+      buf.append(msg, len);
+   } else {
+      stream->write(msg, len);
    }
    return *this;
 }
 
 CharMessageBuffer::operator std::basic_ostream<char>&() {
    if (stream == 0) {
-     stream = new std::basic_ostringstream<char>();
-     if (!buf.empty()) {
-        *stream << buf;
-     }
+     ThreadSpecificData::MessageBufferCache* cache = ThreadSpecificData::getMessageBufferCache();
+     stream = takeStream(cache != 0 ? &cache->charStream : 0, buf);
    }
    return *stream;
 }
 
 const std::basic_string<char>& CharMessageBuffer::str(std::basic_ostream<char>&) {
-   buf = stream->str();
    return buf;
 }
 
@@ -84,29 +278,123 @@ bool CharMessageBuffer::hasStream() const {
     return (stream != 0);
 }
 
+void CharMessageBuffer::extract(LogString& dst) {
+#if LOG4CXX_LOGCHAR_IS_UTF8
+#if LOG4CXX_CHARSET_UTF8
+   dst.swap(buf);
+   return;
+#elif !LOG4CXX_CHARSET_EBCDIC
+   //
+   //   ASCII content decodes to itself
+   std::string::const_iterator iter = buf.begin();
+   while(iter != buf.end() && ((unsigned char) *iter) < 0x80) {
+      iter++;
+   }
+   if (iter == buf.end()) {
+      dst.swap(buf);
+      return;
+   }
+#endif
+#endif
+   Transcoder::decode(buf, dst);
+}
+
 std::ostream& CharMessageBuffer::operator<<(ios_base_manip manip) {
    std::ostream& s = *this;
    (*manip)(s);
    return s;
 }
 
-std::ostream& CharMessageBuffer::operator<<(bool val) { return ((std::ostream&) *this).operator<<(val); }
-std::ostream& CharMessageBuffer::operator<<(short val) { return ((std::ostream&) *this).operator<<(val); }
-std::ostream& CharMessageBuffer::operator<<(int val) { return ((std::ostream&) *this).operator<<(val); }
-std::ostream& CharMessageBuffer::operator<<(unsigned int val) { return ((std::ostream&) *this).operator<<(val); }
-std::ostream& CharMessageBuffer::operator<<(long val) { return ((std::ostream&) *this).operator<<(val); }
-std::ostream& CharMessageBuffer::operator<<(unsigned long val) { return ((std::ostream&) *this).operator<<(val); }
-std::ostream& CharMessageBuffer::operator<<(float val) { return ((std::ostream&) *this).operator<<(val); }
-std::ostream& CharMessageBuffer::operator<<(double val) { return ((std::ostream&) *this).operator<<(val); }
+std::ostream& CharMessageBuffer::operator<<(std::ostream& (*manip)(std::ostream&)) {
+   std::ostream& s = *this;
+   (*manip)(s);
+   return s;
+}
+
+std::ostream& CharMessageBuffer::operator<<(bool val) {
+   std::ostream& s = *this;
+   if (!appendInteger(s, buf, val ? 1 : 0)) {
+      s << val;
+   }
+   return s;
+}
+
+std::ostream& CharMessageBuffer::operator<<(short val) {
+   std::ostream& s = *this;
+   if (!appendInteger(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
+std::ostream& CharMessageBuffer::operator<<(int val) {
+   std::ostream& s = *this;
+   if (!appendInteger(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
+std::ostream& CharMessageBuffer::operator<<(unsigned int val) {
+   std::ostream& s = *this;
+   if (!appendUnsigned(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
+std::ostream& CharMessageBuffer::operator<<(long val) {
+   std::ostream& s = *this;
+   if (!appendInteger(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
+std::ostream& CharMessageBuffer::operator<<(unsigned long val) {
+   std::ostream& s = *this;
+   if (!appendUnsigned(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
+std::ostream& CharMessageBuffer::operator<<(float val) {
+   std::ostream& s = *this;
+   if (!appendDouble(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
+std::ostream& CharMessageBuffer::operator<<(double val) {
+   std::ostream& s = *this;
+   if (!appendDouble(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
 std::ostream& CharMessageBuffer::operator<<(long double val) { return ((std::ostream&) *this).operator<<(val); }
 std::ostream& CharMessageBuffer::operator<<(void* val) { return ((std::ostream&) *this).operator<<(val); }
 
 
 #if LOG4CXX_WCHAR_T_API
-WideMessageBuffer::WideMessageBuffer() : stream(0) {}
+WideMessageBuffer::WideMessageBuffer() : stream(0) {
+   ThreadSpecificData::MessageBufferCache* cache = ThreadSpecificData::getMessageBufferCache();
+   if (cache != 0) {
+      takeBuffer(&cache->wideBuffer, buf);
+   }
+}
 
 WideMessageBuffer::~WideMessageBuffer() {
-   delete stream;
+   ThreadSpecificData::MessageBufferCache* cache = ThreadSpecificData::getMessageBufferCache();
+   if (stream != 0) {
+      releaseStream(cache != 0 ? &cache->wideStream : 0, stream);
+   }
+   if (cache != 0) {
+      releaseBuffer(&cache->wideBuffer, buf);
+   }
 }
 
 WideMessageBuffer& WideMessageBuffer::operator<<(const std::basic_string<wchar_t>& msg) {
@@ -139,24 +427,29 @@ WideMessageBuffer& WideMessageBuffer::operator<<(const wchar_t msg) {
    if (stream == 0) {
       buf.append(1, msg);
    } else {
-      buf.assign(1, msg);
-      *stream << buf;
+      *stream << msg;
+   }
+   return *this;
+}
+
+WideMessageBuffer& WideMessageBuffer::append(const wchar_t* msg, size_t len) {
+   if (stream == 0) {
+      buf.append(msg, len);
+   } else {
+      stream->write(msg, len);
    }
    return *this;
 }
 
 WideMessageBuffer::operator std::basic_ostream<wchar_t>&() {
    if (stream == 0) {
-     stream = new std::basic_ostringstream<wchar_t>();
-     if (!buf.empty()) {
-        *stream << buf;
-     }
+     ThreadSpecificData::MessageBufferCache* cache = ThreadSpecificData::getMessageBufferCache();
+     stream = takeStream(cache != 0 ? &cache->wideStream : 0, buf);
    }
    return *stream;
 }
 
 const std::basic_string<wchar_t>& WideMessageBuffer::str(std::basic_ostream<wchar_t>&) {
-   buf = stream->str();
    return buf;
 }
 
@@ -168,20 +461,90 @@ bool WideMessageBuffer::hasStream() const {
     return (stream != 0);
 }
 
+void WideMessageBuffer::extract(LogString& dst) {
+#if LOG4CXX_LOGCHAR_IS_WCHAR
+   dst.swap(buf);
+#else
+   Transcoder::decode(buf, dst);
+#endif
+}
+
 std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(ios_base_manip manip) {
    std::basic_ostream<wchar_t>& s = *this;
    (*manip)(s);
    return s;
 }
 
-std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(bool val) { return ((std::basic_ostream<wchar_t>&) *this).operator<<(val); }
-std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(short val) { return ((std::basic_ostream<wchar_t>&) *this).operator<<(val); }
-std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(int val) { return ((std::basic_ostream<wchar_t>&) *this).operator<<(val); }
-std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(unsigned int val) { return ((std::basic_ostream<wchar_t>&) *this).operator<<(val); }
-std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(long val) { return ((std::basic_ostream<wchar_t>&) *this).operator<<(val); }
-std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(unsigned long val) { return ((std::basic_ostream<wchar_t>&) *this).operator<<(val); }
-std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(float val) { return ((std::basic_ostream<wchar_t>&) *this).operator<<(val); }
-std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(double val) { return ((std::basic_ostream<wchar_t>&) *this).operator<<(val); }
+std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(std::basic_ostream<wchar_t>& (*manip)(std::basic_ostream<wchar_t>&)) {
+   std::basic_ostream<wchar_t>& s = *this;
+   (*manip)(s);
+   return s;
+}
+
+std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(bool val) {
+   std::basic_ostream<wchar_t>& s = *this;
+   if (!appendInteger(s, buf, val ? 1 : 0)) {
+      s << val;
+   }
+   return s;
+}
+
+std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(short val) {
+   std::basic_ostream<wchar_t>& s = *this;
+   if (!appendInteger(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
+std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(int val) {
+   std::basic_ostream<wchar_t>& s = *this;
+   if (!appendInteger(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
+std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(unsigned int val) {
+   std::basic_ostream<wchar_t>& s = *this;
+   if (!appendUnsigned(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
+std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(long val) {
+   std::basic_ostream<wchar_t>& s = *this;
+   if (!appendInteger(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
+std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(unsigned long val) {
+   std::basic_ostream<wchar_t>& s = *this;
+   if (!appendUnsigned(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
+std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(float val) {
+   std::basic_ostream<wchar_t>& s = *this;
+   if (!appendDouble(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
+std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(double val) {
+   std::basic_ostream<wchar_t>& s = *this;
+   if (!appendDouble(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
 std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(long double val) { return ((std::basic_ostream<wchar_t>&) *this).operator<<(val); }
 std::basic_ostream<wchar_t>& WideMessageBuffer::operator<<(void* val) { return ((std::basic_ostream<wchar_t>&) *this).operator<<(val); }
 
@@ -208,6 +571,20 @@ bool MessageBuffer::hasStream() const {
     return retval;
 }
 
+void MessageBuffer::extract(LogString& dst) {
+#if LOG4CXX_UNICHAR_API || LOG4CXX_CFSTRING_API
+    if (ubuf != 0) {
+        ubuf->extract(dst);
+        return;
+    }
+#endif   
+    if (wbuf != 0) {
+        wbuf->extract(dst);
+    } else {
+        cbuf.extract(dst);
+    }
+}
+
 std::ostream& MessageBuffer::operator<<(ios_base_manip manip) {
    std::ostream& s = *this;
    (*manip)(s);
@@ -233,6 +610,10 @@ CharMessageBuffer& MessageBuffer::operator<<(const char msg) {
    return cbuf.operator<<(msg);
 }
 
+CharMessageBuffer& MessageBuffer::append(const char* msg, size_t len) {
+   return cbuf.append(msg, len);
+}
+
 const std::string& MessageBuffer::str(CharMessageBuffer& buf) {
    return cbuf.str(buf);
 }
@@ -260,6 +641,13 @@ WideMessageBuffer& MessageBuffer::operator<<(const wchar_t msg) {
    return (*wbuf) << msg;
 }
 
+WideMessageBuffer& MessageBuffer::append(const wchar_t* msg, size_t len) {
+   if (wbuf == 0) {
+      wbuf = new WideMessageBuffer();
+   }
+   return wbuf->append(msg, len);
+}
+
 const std::wstring& MessageBuffer::str(WideMessageBuffer& buf) {
    return wbuf->str(buf);
 }
@@ -312,10 +700,21 @@ const std::basic_string<log4cxx::UniChar>& MessageBuffer::str(std::basic_ostream
 }
 
 
-UniCharMessageBuffer::UniCharMessageBuffer() : stream(0) {}
+UniCharMessageBuffer::UniCharMessageBuffer() : stream(0) {
+   ThreadSpecificData::MessageBufferCache* cache = ThreadSpecificData::getMessageBufferCache();
+   if (cache != 0) {
+      takeBuffer(&cache->uniBuffer, buf);
+   }
+}
 
 UniCharMessageBuffer::~UniCharMessageBuffer() {
-   delete stream;
+   ThreadSpecificData::MessageBufferCache* cache = ThreadSpecificData::getMessageBufferCache();
+   if (stream != 0) {
+      releaseStream(cache != 0 ? &cache->uniStream : 0, stream);
+   }
+   if (cache != 0) {
+      releaseBuffer(&cache->uniBuffer, buf);
+   }
 }
 
 
@@ -323,7 +722,7 @@ UniCharMessageBuffer& UniCharMessageBuffer::operator<<(const std::basic_string<l
    if (stream == 0) {
         buf.append(msg);
    } else {
-      *stream << buf;
+      *stream << msg;
    }
    return *this;
 }
@@ -357,16 +756,13 @@ UniCharMessageBuffer& UniCharMessageBuffer::operator<<(const log4cxx::UniChar ms
 
 UniCharMessageBuffer::operator UniCharMessageBuffer::uostream&() {
    if (stream == 0) {
-     stream = new std::basic_ostringstream<UniChar>();
-     if (!buf.empty()) {
-        *stream << buf;
-     }
+     ThreadSpecificData::MessageBufferCache* cache = ThreadSpecificData::getMessageBufferCache();
+     stream = takeStream(cache != 0 ? &cache->uniStream : 0, buf);
    }
    return *stream;
 }
 
 const std::basic_string<log4cxx::UniChar>& UniCharMessageBuffer::str(UniCharMessageBuffer::uostream&) {
-    buf = stream->str();
    return buf;
 }
 
@@ -378,20 +774,90 @@ bool UniCharMessageBuffer::hasStream() const {
     return (stream != 0);
 }
 
+void UniCharMessageBuffer::extract(LogString& dst) {
+#if LOG4CXX_LOGCHAR_IS_UNICHAR
+   dst.swap(buf);
+#else
+   Transcoder::decode(buf, dst);
+#endif
+}
+
 UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(ios_base_manip manip) {
    UniCharMessageBuffer::uostream& s = *this;
    (*manip)(s);
    return s;
 }
 
-UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(bool val) { return ((UniCharMessageBuffer::uostream&) *this).operator<<(val); }
-UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(short val) { return ((UniCharMessageBuffer::uostream&) *this).operator<<(val); }
-UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(int val) { return ((UniCharMessageBuffer::uostream&) *this).operator<<(val); }
-UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(unsigned int val) { return ((UniCharMessageBuffer::uostream&) *this).operator<<(val); }
-UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(long val) { return ((UniCharMessageBuffer::uostream&) *this).operator<<(val); }
-UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(unsigned long val) { return ((UniCharMessageBuffer::uostream&) *this).operator<<(val); }
-UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(float val) { return ((UniCharMessageBuffer::uostream&) *this).operator<<(val); }
-UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(double val) { return ((UniCharMessageBuffer::uostream&) *this).operator<<(val); }
+UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(UniCharMessageBuffer::uostream& (*manip)(UniCharMessageBuffer::uostream&)) {
+   UniCharMessageBuffer::uostream& s = *this;
+   (*manip)(s);
+   return s;
+}
+
+UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(bool val) {
+   UniCharMessageBuffer::uostream& s = *this;
+   if (!appendInteger(s, buf, val ? 1 : 0)) {
+      s << val;
+   }
+   return s;
+}
+
+UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(short val) {
+   UniCharMessageBuffer::uostream& s = *this;
+   if (!appendInteger(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
+UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(int val) {
+   UniCharMessageBuffer::uostream& s = *this;
+   if (!appendInteger(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
+UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(unsigned int val) {
+   UniCharMessageBuffer::uostream& s = *this;
+   if (!appendUnsigned(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
+UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(long val) {
+   UniCharMessageBuffer::uostream& s = *this;
+   if (!appendInteger(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
+UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(unsigned long val) {
+   UniCharMessageBuffer::uostream& s = *this;
+   if (!appendUnsigned(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
+UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(float val) {
+   UniCharMessageBuffer::uostream& s = *this;
+   if (!appendDouble(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
+UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(double val) {
+   UniCharMessageBuffer::uostream& s = *this;
+   if (!appendDouble(s, buf, val)) {
+      s << val;
+   }
+   return s;
+}
+
 UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(long double val) { return ((UniCharMessageBuffer::uostream&) *this).operator<<(val); }
 UniCharMessageBuffer::uostream& UniCharMessageBuffer::operator<<(void* val) { return ((UniCharMessageBuffer::uostream&) *this).operator<<(val); }
 
@@ -34,7 +34,8 @@ ObjectOutputStream::ObjectOutputStream(OutputStreamPtr outputStream, Pool& p)
      : os(outputStream) , 
        utf8Encoder(CharsetEncoder::getUTF8Encoder()), 
        objectHandle(0x7E0000),
-       classDescriptions(new ClassDescriptionMap())
+       classDescriptions(new ClassDescriptionMap()),
+       sharedStrings(new SharedStringMap())
 {
    char start[] = { 0xAC, 0xED, 0x00, 0x05 };
    ByteBuffer buf(start, sizeof(start));
@@ -43,6 +44,7 @@ ObjectOutputStream::ObjectOutputStream(OutputStreamPtr outputStream, Pool& p)
 
 ObjectOutputStream::~ObjectOutputStream() {
     delete classDescriptions;
+    delete sharedStrings;
 }
 
 void ObjectOutputStream::close(Pool& p) {
@@ -76,6 +78,27 @@ void ObjectOutputStream::writeObject(const LogString& val, Pool& p) {
    os->write(dataBuf, p);
 }
 
+void ObjectOutputStream::writeObject(const SharedStringPtr& val, Pool& p) {
+    SharedStringMap::const_iterator match = sharedStrings->find(val);
+    if (match != sharedStrings->end()) {
+        char bytes[5];
+        bytes[0] = TC_REFERENCE;
+        bytes[1] = (char) ((match->second >> 24) & 0xFF);
+        bytes[2] = (char) ((match->second >> 16) & 0xFF);
+        bytes[3] = (char) ((match->second >> 8) & 0xFF);
+        bytes[4] = (char) (match->second & 0xFF);
+        ByteBuffer buf(bytes, sizeof(bytes));
+        os->write(buf, p);
+    } else {
+        //
+        //   the map holds a reference to each string, bounded
+        //      since thread names come and go with their threads
+        if (sharedStrings->size() < MAX_SHARED_STRINGS) {
+            sharedStrings->insert(SharedStringMap::value_type(val, objectHandle));
+        }
+        writeObject(val->getValue(), p);
+    }
+}
 
 void ObjectOutputStream::writeObject(const MDC::Map& val, Pool& p) {
     //
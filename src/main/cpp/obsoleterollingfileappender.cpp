@@ -121,6 +121,10 @@ long RollingFileAppender::getMaximumFileSize() const {
   return maxFileSize;
 }
 
+bool RollingFileAppender::formatsBatches() const {
+  return &getClass() == &RollingFileAppender::getStaticClass();
+}
+
 void RollingFileAppender::setMaxBackupIndex(int maxBackups) {
   maxBackupIndex = maxBackups;
 }
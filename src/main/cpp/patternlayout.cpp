@@ -46,6 +46,8 @@
 #include <log4cxx/pattern/ndcpatternconverter.h>
 #include <log4cxx/pattern/propertiespatternconverter.h>
 #include <log4cxx/pattern/throwableinformationpatternconverter.h>
+#include <limits.h>
+#include <apr_atomic.h>
 
 
 using namespace log4cxx;
@@ -56,7 +58,7 @@ using namespace log4cxx::pattern;
 IMPLEMENT_LOG4CXX_OBJECT(PatternLayout)
 
 
-PatternLayout::PatternLayout()
+PatternLayout::PatternLayout() : expectedLength(0)
 {
 }
 
@@ -64,7 +66,7 @@ PatternLayout::PatternLayout()
 Constructs a PatternLayout using the supplied conversion pattern.
 */
 PatternLayout::PatternLayout(const LogString& pattern)
-  : conversionPattern(pattern) {
+  : conversionPattern(pattern), expectedLength(0) {
   Pool pool;
   activateOptions(pool);
 }
@@ -80,17 +82,52 @@ void PatternLayout::format(LogString& output,
       const spi::LoggingEventPtr& event,
       Pool& pool) const
 {
-  std::vector<FormattingInfoPtr>::const_iterator formatterIter =
-     patternFields.begin();
-  for(std::vector<LoggingEventPatternConverterPtr>::const_iterator
-           converterIter = patternConverters.begin();
-      converterIter != patternConverters.end();
-      converterIter++, formatterIter++) {
+  size_t start = output.length();
+  unsigned int expected = apr_atomic_read32(&expectedLength);
+  if (output.capacity() < start + expected) {
+      output.reserve(start + expected + expected / 4);
+  }
+  for(FormatStepList::const_iterator step = formatSteps.begin();
+      step != formatSteps.end();
+      step++) {
       int startField = output.length();
-      (*converterIter)->format(event, output, pool);
-      (*formatterIter)->format(startField, output);
+      switch(step->kind) {
+          case FormatStep::LITERAL:
+          output.append(step->literal);
+          break;
+
+          case FormatStep::MESSAGE:
+          output.append(event->getRenderedMessage());
+          break;
+
+          case FormatStep::LINE_SEPARATOR:
+          output.append(LOG4CXX_EOL);
+          break;
+
+          case FormatStep::LEVEL:
+          output.append(event->getLevel()->toString());
+          break;
+
+          case FormatStep::LOGGER:
+          output.append(event->getLoggerName());
+          break;
+
+          case FormatStep::DATE:
+          step->dateFormat->format(output, event->getTimeStamp(), pool);
+          break;
+
+          default:
+          step->converter->format(event, output, pool);
+      }
+      if (step->field != 0) {
+          step->field->format(startField, output);
+      }
   }
-
+  //
+  //   the estimate is shared by all threads using the layout,
+  //      an update lost to another thread only affects sizing
+  unsigned int length = (unsigned int) (output.length() - start);
+  apr_atomic_set32(&expectedLength, (expected == 0) ? length : (expected * 7 + length) / 8);
 }
 
 void PatternLayout::setOption(const LogString& option, const LogString& value)
@@ -109,25 +146,73 @@ void PatternLayout::activateOptions(Pool&)
         if (pat.empty()) {
             pat = LOG4CXX_STR("%m%n");
         }
-        patternConverters.erase(patternConverters.begin(), patternConverters.end());
-        patternFields.erase(patternFields.begin(), patternFields.end());
         std::vector<PatternConverterPtr> converters;
+        std::vector<FormattingInfoPtr> fields;
         PatternParser::parse(pat,
                 converters,
-                patternFields,
+                fields,
                 getFormatSpecifiers());
+        compile(converters, fields);
+}
+
+/**
+ *  Returns true if the field width and alignment leave any value unchanged.
+ */
+static bool isNoOp(const FormattingInfoPtr& field) {
+    return field == 0 ||
+        (field->getMinLength() <= 0 && field->getMaxLength() == INT_MAX);
+}
 
-       //
-       //   strip out any pattern converters that don't handle LoggingEvents
-       //
-       //
+void PatternLayout::compile(const std::vector<PatternConverterPtr>& converters,
+       const std::vector<FormattingInfoPtr>& fields)
+{
+       formatSteps.erase(formatSteps.begin(), formatSteps.end());
+       apr_atomic_set32(&expectedLength, 0);
+       PatternConverterPtr defaultLogger(
+           LoggerPatternConverter::newInstance(std::vector<LogString>()));
+       Pool p;
+       std::vector<FormattingInfoPtr>::const_iterator fieldIter = fields.begin();
        for(std::vector<PatternConverterPtr>::const_iterator converterIter = converters.begin();
            converterIter != converters.end();
            converterIter++) {
+           FormattingInfoPtr field;
+           if (fieldIter != fields.end()) {
+               field = *fieldIter++;
+           }
+           //
+           //   skip any pattern converters that don't handle LoggingEvents
            LoggingEventPatternConverterPtr eventConverter(*converterIter);
-           if (eventConverter != NULL) {
-             patternConverters.push_back(eventConverter);
+           if (eventConverter == NULL) {
+               continue;
+           }
+           FormatStep step;
+           step.field = isNoOp(field) ? FormattingInfoPtr() : field;
+           const Class& converterClass = eventConverter->getClass();
+           if (&converterClass == &LiteralPatternConverter::getStaticClass()) {
+               step.kind = FormatStep::LITERAL;
+               eventConverter->format(LoggingEventPtr(), step.literal, p);
+               if (step.field == 0 && !formatSteps.empty() &&
+                   formatSteps.back().kind == FormatStep::LITERAL &&
+                   formatSteps.back().field == 0) {
+                   formatSteps.back().literal.append(step.literal);
+                   continue;
+               }
+           } else if (&converterClass == &MessagePatternConverter::getStaticClass()) {
+               step.kind = FormatStep::MESSAGE;
+           } else if (&converterClass == &LineSeparatorPatternConverter::getStaticClass()) {
+               step.kind = FormatStep::LINE_SEPARATOR;
+           } else if (&converterClass == &LevelPatternConverter::getStaticClass()) {
+               step.kind = FormatStep::LEVEL;
+           } else if (*converterIter == defaultLogger) {
+               step.kind = FormatStep::LOGGER;
+           } else if (&converterClass == &DatePatternConverter::getStaticClass()) {
+               step.kind = FormatStep::DATE;
+               step.dateFormat = DatePatternConverterPtr(eventConverter)->getFormat();
+           } else {
+               step.kind = FormatStep::CONVERTER;
+               step.converter = eventConverter;
            }
+           formatSteps.push_back(step);
        }
 }
 
@@ -20,6 +20,7 @@
 #include <apr_strings.h>
 #include <log4cxx/helpers/exception.h>
 #include <apr_pools.h>
+#include <apr_atomic.h>
 #include <assert.h>
 #if !defined(LOG4CXX)
 #define LOG4CXX 1
@@ -30,11 +31,16 @@ using namespace log4cxx::helpers;
 using namespace log4cxx;
 
 
+namespace {
+    unsigned int volatile createdCount = 0;
+}
+
 Pool::Pool() : pool(0), release(true) {
     apr_status_t stat = apr_pool_create(&pool, APRInitializer::getRootPool());
     if (stat != APR_SUCCESS) {
         throw PoolException(stat);
     }
+    apr_atomic_inc32(&createdCount);
 }
 
 Pool::Pool(apr_pool_t* p, bool release1) : pool(p), release(release1) {
@@ -58,9 +64,14 @@ apr_pool_t* Pool::create() {
     if (stat != APR_SUCCESS) {
         throw PoolException(stat);
     }
+    apr_atomic_inc32(&createdCount);
     return child;
 }
 
+unsigned int Pool::getCreatedCount() {
+    return apr_atomic_read32(&createdCount);
+}
+
 void* Pool::palloc(size_t size) {
   return apr_palloc(pool, size);
 }
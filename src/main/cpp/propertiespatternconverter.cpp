@@ -71,10 +71,22 @@ void PropertiesPatternConverter::format(
           toAppendTo.append(1, (logchar) 0x7D /* '}' */);
       }
 
+      size_t fieldCount = event->getFieldCount();
+      for(size_t i = 0; i < fieldCount; i++) {
+          const EventField& field = event->getField(i);
+          toAppendTo.append(1, (logchar) 0x7B /* '{' */);
+          toAppendTo.append(field.getKey());
+          toAppendTo.append(1, (logchar) 0x2C /* ',' */);
+          field.format(toAppendTo);
+          toAppendTo.append(1, (logchar) 0x7D /* '}' */);
+      }
+
       toAppendTo.append(1, (logchar) 0x7D /* '}' */);
 
     } else {
-      event->getMDC(option, toAppendTo);
+      if (!event->getMDC(option, toAppendTo)) {
+          event->getField(option, toAppendTo);
+      }
     }
  }
 
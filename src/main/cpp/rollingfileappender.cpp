@@ -256,6 +256,47 @@ void RollingFileAppenderSkeleton::subAppend(const LoggingEventPtr& event, Pool&
   FileAppender::subAppend(event, p);
 }
 
+/**
+ * {@inheritDoc}
+*/
+bool RollingFileAppenderSkeleton::formatsBatches() const {
+  const Class& cls = getClass();
+  return &cls == &RollingFileAppenderSkeleton::getStaticClass() ||
+    &cls == &RollingFileAppender::getStaticClass();
+}
+
+/**
+ * {@inheritDoc}
+*/
+void RollingFileAppenderSkeleton::writeBatch(const LoggingEventList& events, Pool& p) {
+  LogString msg;
+  for(LoggingEventList::const_iterator iter = events.begin();
+      iter != events.end();
+      iter++) {
+    //
+    //   the length of the file includes the events formatted
+    //     but not yet written, estimated by their characters.
+    //
+    if (
+      triggeringPolicy->isTriggeringEvent(
+          this, *iter, getFile(), getFileLength() + msg.length())) {
+      if (!msg.empty()) {
+        writeFormatted(msg, p);
+        msg.erase(msg.begin(), msg.end());
+      }
+      try {
+        rollover(p);
+      } catch (std::exception& ex) {
+          LogLog::warn(LOG4CXX_STR("Exception during rollover attempt."));
+      }
+    }
+    layout->format(msg, *iter, p);
+  }
+  if (!msg.empty()) {
+    writeFormatted(msg, p);
+  }
+}
+
 /**
  * Get rolling policy.
  * @return rolling policy.
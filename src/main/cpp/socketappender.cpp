@@ -109,3 +109,27 @@ void SocketAppender::append(const spi::LoggingEventPtr& event, log4cxx::helpers:
         }
     }
 }
+
+void SocketAppender::appendBatch(const spi::LoggingEventList& events, log4cxx::helpers::Pool& p) {
+    if (oos != 0) {
+        try {
+           for(spi::LoggingEventList::const_iterator iter = events.begin();
+               iter != events.end();
+               iter++) {
+               LogString ndcVal;
+               (*iter)->getNDC(ndcVal);
+               (*iter)->getThreadName();
+               // Get a copy of this thread's MDC.
+               (*iter)->getMDCCopy();
+               (*iter)->write(*oos, p);
+           }
+           oos->flush(p);
+        } catch(std::exception& e) {
+           oos = 0;
+           LogLog::warn(LOG4CXX_STR("Detected problem with connection: "), e);
+           if (getReconnectionDelay() > 0) {
+               fireConnector();
+           }
+        }
+    }
+}
@@ -28,6 +28,9 @@
 #endif
 #include <log4cxx/private/log4cxx_private.h>
 #include <cctype>
+#include <stdio.h>
+#include <locale.h>
+#include <string.h>
 #include <apr.h>
 
 
@@ -103,9 +106,84 @@ log4cxx_int64_t StringHelper::toInt64(const LogString& s) {
     return apr_atoi64(as.c_str());
 }
 
-void StringHelper::toString(int n, Pool& pool, LogString& s) {
-  char* fmt = pool.itoa(n);
-  Transcoder::decode(fmt, s);
+namespace {
+    /**
+     *  Two digit decimal representations of 0 through 99.
+     */
+    const char DIGIT_PAIRS[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    size_t formatMagnitude(apr_uint64_t n, bool negative, char* buf) {
+        char digits[StringHelper::NUMBER_BUFFER_SIZE];
+        char* end = digits + sizeof(digits);
+        char* start = end;
+        while (n >= 100) {
+            apr_uint64_t quotient = n / 100;
+            const char* pair = DIGIT_PAIRS + 2 * (size_t) (n - quotient * 100);
+            *--start = pair[1];
+            *--start = pair[0];
+            n = quotient;
+        }
+        if (n >= 10) {
+            const char* pair = DIGIT_PAIRS + 2 * (size_t) n;
+            *--start = pair[1];
+            *--start = pair[0];
+        } else {
+            *--start = (char) (0x30 /* '0' */ + n);
+        }
+        if (negative) {
+            *--start = 0x2D /* '-' */;
+        }
+        size_t len = end - start;
+        memcpy(buf, start, len);
+        return len;
+    }
+}
+
+size_t StringHelper::formatInteger(log4cxx_int64_t n, char* buf) {
+    if (n < 0) {
+        return formatMagnitude((apr_uint64_t) 0 - (apr_uint64_t) n, true, buf);
+    }
+    return formatMagnitude((apr_uint64_t) n, false, buf);
+}
+
+size_t StringHelper::formatUnsigned(log4cxx_uint64_t n, char* buf) {
+    return formatMagnitude(n, false, buf);
+}
+
+size_t StringHelper::formatDouble(double n, char* buf) {
+    //
+    //   std::ostream formats with "%.*g" and a default precision of 6,
+    //      the result is at most 13 characters such as "-1.23457e+308"
+    size_t len = sprintf(buf, "%.6g", n);
+    //
+    //   sprintf uses the decimal point of the C library locale
+    const char* point = localeconv()->decimal_point;
+    if (point != 0 && strcmp(point, ".") != 0) {
+        size_t pointLen = strlen(point);
+        char* found = strstr(buf, point);
+        if (pointLen > 0 && found != 0) {
+            *found = 0x2E /* '.' */;
+            memmove(found + 1, found + pointLen, len - (found - buf) - pointLen + 1);
+            len -= pointLen - 1;
+        }
+    }
+    return len;
+}
+
+void StringHelper::toString(int n, Pool& /* pool */, LogString& s) {
+  char buf[NUMBER_BUFFER_SIZE];
+  size_t len = formatInteger(n, buf);
+  s.append(buf, buf + len);
 }
 
 void StringHelper::toString(bool val, LogString& dst) {
@@ -117,20 +195,10 @@ void StringHelper::toString(bool val, LogString& dst) {
 }
 
 
-void StringHelper::toString(log4cxx_int64_t n, Pool& pool, LogString& dst) {
-  if (n >= INT_MIN && n <= INT_MAX) {
-    toString((int) n, pool, dst);
-  } else {
-    const log4cxx_int64_t BILLION = APR_INT64_C(1000000000);
-    int billions = (int) (n / BILLION);
-    char* upper = pool.itoa(billions);
-    int remain = (int) (n - billions * BILLION);
-    if (remain < 0) remain *= -1;
-    char* lower = pool.itoa(remain);
-    Transcoder::decode(upper, dst);
-    dst.append(9 - strlen(lower), 0x30 /* '0' */);
-    Transcoder::decode(lower, dst);
-  }
+void StringHelper::toString(log4cxx_int64_t n, Pool& /* pool */, LogString& dst) {
+  char buf[NUMBER_BUFFER_SIZE];
+  size_t len = formatInteger(n, buf);
+  dst.append(buf, buf + len);
 }
 
 
@@ -174,9 +174,15 @@ void Thread::run(Runnable start, void* data) {
         
         //   create LaunchPackage on the thread's memory pool
         LaunchPackage* package = new(p) LaunchPackage(this, start, data);
+        //
+        //   report the thread as alive from the return of run
+        //      rather than from the start of the launcher
+        //
+        apr_atomic_set32(&alive, 0xFFFFFFFF);
         stat = apr_thread_create(&thread, attrs,
             ThreadLaunch::launcher, package, p.getAPRPool());
         if (stat != APR_SUCCESS) {
+                apr_atomic_set32(&alive, 0);
                 throw ThreadException(stat);
         }
 #else
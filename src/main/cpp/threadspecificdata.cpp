@@ -18,20 +18,42 @@
 #include <log4cxx/logstring.h>
 #include <log4cxx/helpers/threadspecificdata.h>
 #include <log4cxx/helpers/exception.h>
+#include <log4cxx/helpers/pool.h>
+#include <log4cxx/spi/loggingevent.h>
+#include <log4cxx/helpers/deferredlog.h>
+#include <log4cxx/helpers/eventqueue.h>
+#include <apr_pools.h>
+#include <apr_allocator.h>
 #if !defined(LOG4CXX)
 #define LOG4CXX 1
 #endif
 #include <log4cxx/helpers/aprinitializer.h>
+#include <log4cxx/helpers/transcoder.h>
+#include <log4cxx/private/log4cxx_private.h>
+#include <apr_portable.h>
+#include <apr_strings.h>
 
 using namespace log4cxx;
 using namespace log4cxx::helpers;
 
 
 ThreadSpecificData::ThreadSpecificData()
-    : ndcStack(), mdcMap() {
+    : ndcStack(), mdcMap(), pool(0), poolBorrowed(false), events(), threadName(), messageBuffers(),
+      deferredBuffer(), eventQueues(), dateCacheUses(0) {
 }
 
 ThreadSpecificData::~ThreadSpecificData() {
+    for(EventCache::iterator iter = events.begin();
+        iter != events.end();
+        iter++) {
+        delete *iter;
+    }
+    //
+    //   the pool is a child of the root pool and
+    //      has already been released if APR has terminated
+    if (!APRInitializer::isDestructed) {
+        delete pool;
+    }
 }
 
 
@@ -60,7 +82,9 @@ ThreadSpecificData* ThreadSpecificData::getCurrentData() {
 
 void ThreadSpecificData::recycle() {
 #if APR_HAS_THREADS
-    if(ndcStack.empty() && mdcMap.empty()) {
+    if(ndcStack.empty() && mdcMap.empty() && pool == 0 && events.empty()
+        && threadName == 0 && messageBuffers.empty() && deferredBuffer == 0 && eventQueues.empty()
+        && isDateCacheUnused()) {
         void* pData = NULL;
         apr_status_t stat = apr_threadkey_private_get(&pData, APRInitializer::getTlsKey());
         if (stat == APR_SUCCESS && pData == this) {
@@ -116,6 +140,221 @@ void ThreadSpecificData::inherit(const NDC::Stack& src) {
 
 
 
+Pool* ThreadSpecificData::borrowPool() {
+    ThreadSpecificData* data = getCurrentData();
+    if (data == 0) {
+        data = createCurrentData();
+    }
+    if (data == 0 || data->poolBorrowed) {
+        return 0;
+    }
+    if (data->pool == 0) {
+        data->pool = createPool();
+        if (data->pool == 0) {
+            return 0;
+        }
+    }
+    data->poolBorrowed = true;
+    return data->pool;
+}
+
+void ThreadSpecificData::returnPool(Pool* p) {
+    ThreadSpecificData* data = getCurrentData();
+    if (data != 0 && p != 0 && data->pool == p) {
+        apr_pool_clear(p->getAPRPool());
+        data->poolBorrowed = false;
+    }
+}
+
+SharedStringPtr ThreadSpecificData::getThreadName() {
+    ThreadSpecificData* data = getCurrentData();
+    if (data == 0) {
+        data = createCurrentData();
+    }
+    if (data == 0) {
+        return new SharedString(createThreadName());
+    }
+    if (data->threadName == 0) {
+        data->threadName = new SharedString(createThreadName());
+    }
+    return data->threadName;
+}
+
+void ThreadSpecificData::setThreadName(const LogString& name) {
+    ThreadSpecificData* data = getCurrentData();
+    if (data == 0) {
+        data = createCurrentData();
+    }
+    if (data != 0) {
+        if (name.empty()) {
+            data->threadName = 0;
+        } else {
+            data->threadName = new SharedString(name);
+        }
+    }
+}
+
+LogString ThreadSpecificData::createThreadName() {
+#if APR_HAS_THREADS
+#if defined(_WIN32)
+   char result[20];
+   DWORD threadId = GetCurrentThreadId();
+   apr_snprintf(result, sizeof(result), LOG4CXX_WIN32_THREAD_FMTSPEC, threadId);
+#else
+   // apr_os_thread_t encoded in HEX takes needs as many characters
+   // as two times the size of the type, plus an additional null byte.
+   char result[sizeof(apr_os_thread_t) * 3 + 10];
+   apr_os_thread_t threadId = apr_os_thread_current();
+   apr_snprintf(result, sizeof(result), LOG4CXX_APR_THREAD_FMTSPEC, (void*) &threadId);
+#endif
+   LOG4CXX_DECODE_CHAR(str, (const char*) result);
+   return str;
+#else
+   return LOG4CXX_STR("0x00000000");
+#endif
+}
+
+ThreadSpecificData::MessageBufferCache::MessageBufferCache()
+    : charStream(0), charBuffer()
+#if LOG4CXX_WCHAR_T_API
+    , wideStream(0), wideBuffer()
+#endif
+#if LOG4CXX_UNICHAR_API || LOG4CXX_CFSTRING_API
+    , uniStream(0), uniBuffer()
+#endif
+{
+}
+
+ThreadSpecificData::MessageBufferCache::~MessageBufferCache() {
+    delete charStream;
+#if LOG4CXX_WCHAR_T_API
+    delete wideStream;
+#endif
+#if LOG4CXX_UNICHAR_API || LOG4CXX_CFSTRING_API
+    delete uniStream;
+#endif
+}
+
+namespace {
+    template<class T> bool isUnreserved(const std::basic_string<T>& buf) {
+        return buf.capacity() <= std::basic_string<T>().capacity();
+    }
+}
+
+bool ThreadSpecificData::MessageBufferCache::empty() const {
+    bool retval = charStream == 0 && isUnreserved(charBuffer);
+#if LOG4CXX_WCHAR_T_API
+    retval = retval && wideStream == 0 && isUnreserved(wideBuffer);
+#endif
+#if LOG4CXX_UNICHAR_API || LOG4CXX_CFSTRING_API
+    retval = retval && uniStream == 0 && isUnreserved(uniBuffer);
+#endif
+    return retval;
+}
+
+ThreadSpecificData::MessageBufferCache* ThreadSpecificData::getMessageBufferCache() {
+    ThreadSpecificData* data = getCurrentData();
+    if (data == 0) {
+        data = createCurrentData();
+    }
+    if (data != 0) {
+        return &data->messageBuffers;
+    }
+    return 0;
+}
+
+ThreadSpecificData::EventCache* ThreadSpecificData::getEventCache() {
+    ThreadSpecificData* data = getCurrentData();
+    if (data == 0) {
+        data = createCurrentData();
+    }
+    if (data != 0) {
+        return &data->events;
+    }
+    return 0;
+}
+
+DeferredBufferPtr* ThreadSpecificData::getDeferredBuffer() {
+    ThreadSpecificData* data = getCurrentData();
+    if (data == 0) {
+        data = createCurrentData();
+    }
+    if (data != 0) {
+        return &data->deferredBuffer;
+    }
+    return 0;
+}
+
+ThreadSpecificData::EventQueueList* ThreadSpecificData::getEventQueues() {
+    ThreadSpecificData* data = getCurrentData();
+    if (data == 0) {
+        data = createCurrentData();
+    }
+    if (data != 0) {
+        return &data->eventQueues;
+    }
+    return 0;
+}
+
+ThreadSpecificData::DateCacheEntry::DateCacheEntry()
+    : formatId(0), lastUse(0), millisecondStart(0), slotBegin(0), previousTime(0), cache() {
+}
+
+ThreadSpecificData::DateCacheEntry* ThreadSpecificData::getDateCache(unsigned int formatId) {
+    ThreadSpecificData* data = getCurrentData();
+    if (data == 0) {
+        data = createCurrentData();
+    }
+    if (data == 0) {
+        return 0;
+    }
+    //
+    //   ages are differences of the use counter so that
+    //      wrapping around does not change their order
+    unsigned int uses = data->dateCacheUses;
+    DateCacheEntry* entry = data->dateCache;
+    for(int i = 0; i < DATE_CACHE_SIZE; i++) {
+        DateCacheEntry* candidate = data->dateCache + i;
+        if (candidate->formatId == formatId) {
+            entry = candidate;
+            break;
+        }
+        if (uses - candidate->lastUse > uses - entry->lastUse) {
+            entry = candidate;
+        }
+    }
+    entry->lastUse = ++data->dateCacheUses;
+    return entry;
+}
+
+bool ThreadSpecificData::isDateCacheUnused() const {
+    for(int i = 0; i < DATE_CACHE_SIZE; i++) {
+        if (dateCache[i].formatId != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Pool* ThreadSpecificData::createPool() {
+    //
+    //   the pool gets an allocator of its own so that
+    //      clearing and reusing it does not contend with other threads
+    apr_allocator_t* allocator = NULL;
+    if (apr_allocator_create(&allocator) != APR_SUCCESS) {
+        return 0;
+    }
+    apr_pool_t* p = NULL;
+    if (apr_pool_create_ex(&p, APRInitializer::getRootPool(), NULL, allocator) != APR_SUCCESS) {
+        apr_allocator_destroy(allocator);
+        return 0;
+    }
+    apr_allocator_owner_set(allocator, p);
+    apr_allocator_max_free_set(allocator, 64 * 1024);
+    return new Pool(p, true);
+}
+
+
 ThreadSpecificData* ThreadSpecificData::createCurrentData() {
 #if APR_HAS_THREADS
     ThreadSpecificData* newData = new ThreadSpecificData();
@@ -88,6 +88,17 @@ void WriterAppender::append(const spi::LoggingEventPtr& event, Pool& pool1)
         subAppend(event, pool1);
 }
 
+void WriterAppender::appendBatch(const spi::LoggingEventList& events, Pool& pool1)
+{
+
+        if(!checkEntryConditions())
+        {
+                return;
+        }
+
+        subAppendBatch(events, pool1);
+}
+
 /**
    This method determines if there is a sense in attempting to append.
 
@@ -225,6 +236,49 @@ void WriterAppender::subAppend(const spi::LoggingEventPtr& event, Pool& p)
 }
 
 
+void WriterAppender::subAppendBatch(const spi::LoggingEventList& events, Pool& p)
+{
+        if (formatsBatches()) {
+           writeBatch(events, p);
+           return;
+        }
+        for(spi::LoggingEventList::const_iterator iter = events.begin();
+            iter != events.end();
+            iter++) {
+           subAppend(*iter, p);
+        }
+}
+
+bool WriterAppender::formatsBatches() const
+{
+        //
+        //   a subclass may override subAppend, which writeBatch would bypass
+        return &getClass() == &WriterAppender::getStaticClass();
+}
+
+void WriterAppender::writeBatch(const spi::LoggingEventList& events, Pool& p)
+{
+        LogString msg;
+        for(spi::LoggingEventList::const_iterator iter = events.begin();
+            iter != events.end();
+            iter++) {
+           layout->format(msg, *iter, p);
+        }
+        writeFormatted(msg, p);
+}
+
+void WriterAppender::writeFormatted(const LogString& msg, Pool& p)
+{
+        synchronized sync(mutex);
+        if (writer != NULL) {
+           writer->write(msg, p);
+           if (immediateFlush) {
+              writer->flush(p);
+           }
+        }
+}
+
+
 void WriterAppender::writeFooter(Pool& p)
 {
         if (layout != NULL) {
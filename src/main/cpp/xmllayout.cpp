@@ -103,7 +103,8 @@ void XMLLayout::format(LogString& output,
         if (properties) {
             LoggingEvent::KeySet propertySet(event->getPropertyKeySet());
             LoggingEvent::KeySet keySet(event->getMDCKeySet());
-            if (!(keySet.empty() && propertySet.empty())) {
+            size_t fieldCount = event->getFieldCount();
+            if (!(keySet.empty() && propertySet.empty() && fieldCount == 0)) {
                 output.append(LOG4CXX_STR("<log4j:properties>"));
                 output.append(LOG4CXX_EOL);
                 for (LoggingEvent::KeySet::const_iterator i = keySet.begin();
@@ -134,6 +135,17 @@ void XMLLayout::format(LogString& output,
                             output.append(LOG4CXX_EOL);
                         }
                 }
+                for (size_t i3 = 0; i3 < fieldCount; i3++) {
+                        const EventField& field = event->getField(i3);
+                        LogString value;
+                        field.format(value);
+                        output.append(LOG4CXX_STR("<log4j:data name=\""));
+                        Transform::appendEscapingTags(output, field.getKey());
+                        output.append(LOG4CXX_STR("\" value=\""));
+                        Transform::appendEscapingTags(output, value);
+                        output.append(LOG4CXX_STR("\"/>"));
+                        output.append(LOG4CXX_EOL);
+                }
                 output.append(LOG4CXX_STR("</log4j:properties>"));
                 output.append(LOG4CXX_EOL);
             }
@@ -37,6 +37,7 @@ namespace log4cxx
         {
         class LoggingEvent;
         typedef helpers::ObjectPtrT<LoggingEvent> LoggingEventPtr;
+        typedef std::vector<LoggingEventPtr> LoggingEventList;
 
         class Filter;
         typedef helpers::ObjectPtrT<Filter> FilterPtr;
@@ -94,6 +95,20 @@ namespace log4cxx
         virtual void doAppend(const spi::LoggingEventPtr& event,
               log4cxx::helpers::Pool& pool) = 0;
 
+        /**
+         Log a sequence of events, as dispatched by AsyncAppender.
+         Appenders may override this method to write the events
+         at once, the default calls <code>doAppend</code> for each event.
+        */
+        virtual void doAppendBatch(const spi::LoggingEventList& events,
+              log4cxx::helpers::Pool& pool) {
+            for (spi::LoggingEventList::const_iterator iter = events.begin();
+                 iter != events.end();
+                 iter++) {
+                 doAppend(*iter, pool);
+            }
+        }
+
 
         /**
          Get the name of this appender. The name uniquely identifies the
@@ -58,6 +58,12 @@ namespace log4cxx
                 There is no level threshold filtering by default.  */
                 LevelPtr threshold;
 
+                /**
+                Integer value of threshold kept by setThreshold, for
+                appenders that check events without holding mutex.
+                */
+                unsigned int volatile thresholdInt;
+
                 /**
                 It is assumed and enforced that errorHandler is never null.
                 */
@@ -118,6 +124,13 @@ namespace log4cxx
         protected:
                 virtual void append(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& p) = 0;
 
+                /**
+                Logs the events of a batch that passed the threshold and
+                filters, called by AppenderSkeleton::doAppendBatch.
+                The default calls <code>append</code> for each event.
+                */
+                virtual void appendBatch(const spi::LoggingEventList& events, log4cxx::helpers::Pool& p);
+
                 /**
                 Clear the filters chain.
                 */
@@ -174,6 +187,12 @@ namespace log4cxx
                 * */
                 void doAppend(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& pool);
 
+                /**
+                * Performs the threshold checks and filters of each event
+                * and passes the remaining events to AppenderSkeleton#appendBatch.
+                * */
+                void doAppendBatch(const spi::LoggingEventList& events, log4cxx::helpers::Pool& pool);
+
                 /**
                 Set the {@link spi::ErrorHandler ErrorHandler} for this Appender.
                 */
@@ -203,6 +222,12 @@ namespace log4cxx
                 */
                 void setThreshold(const LevelPtr& threshold);
 
+        private:
+                /**
+                Returns true if the event passes the threshold and filters.
+                */
+                bool isAccepted(const spi::LoggingEventPtr& event) const;
+
         }; // class AppenderSkeleton
 }  // namespace log4cxx
 
@@ -27,10 +27,12 @@
 #include <log4cxx/appenderskeleton.h>
 #include <log4cxx/helpers/appenderattachableimpl.h>
 #include <deque>
+#include <map>
 #include <log4cxx/spi/loggingevent.h>
 #include <log4cxx/helpers/thread.h>
 #include <log4cxx/helpers/mutex.h>
 #include <log4cxx/helpers/condition.h>
+#include <log4cxx/helpers/eventqueue.h>
 
 
 namespace log4cxx
@@ -82,8 +84,22 @@ namespace log4cxx
                 */
                 void addAppender(const AppenderPtr& newAppender);
 
+                /**
+                 * Checks the threshold and filters and adds the event to the
+                 * buffer without taking the mutex of the appender, so threads
+                 * logging at once only meet in the buffer.  Filters are called
+                 * concurrently and should decide without changing their state.
+                 */
+                void doAppend(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& p);
+
                 void append(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& p);
 
+                /**
+                 * Removes the filters, keeping them until the appender is
+                 * destroyed since doAppend may still be calling them.
+                 */
+                void clearFilters();
+
                 /**
                 Close this <code>AsyncAppender</code> by interrupting the
                 dispatcher thread which will process all pending events before
@@ -173,6 +189,135 @@ namespace log4cxx
                  * @return true if calling thread will be blocked when buffer is full.
                  */
                  bool getBlocking() const;
+
+                /**
+                 * Sets the level below which events are discarded rather than
+                 * waiting when the buffer is full.  Events below this level
+                 * also leave <b>ReservedSize</b> events of the buffer to events
+                 * at or above it.  No level is set by default.
+                 *
+                 * @param level overflow threshold, may be null.
+                 */
+                 void setOverflowThreshold(const LevelPtr& level);
+
+                /**
+                 * Gets the level below which events are discarded first.
+                 * @return the current value of the <b>OverflowThreshold</b> option, may be null.
+                 */
+                 const LevelPtr& getOverflowThreshold() const;
+
+                /**
+                 * Sets the number of events of the buffer kept for events
+                 * at or above the <b>OverflowThreshold</b> level.  Events
+                 * below it may still fill one event of a buffer smaller
+                 * than this size.  The lanes of <b>DispatchLanes</b>
+                 * keep the same number of events of their own buffers.
+                 *
+                 * @param size number of reserved events.
+                 */
+                 void setReservedSize(int size);
+
+                /**
+                 * Gets the number of events of the buffer kept for severe events.
+                 * @return the current value of the <b>ReservedSize</b> option.
+                 */
+                 int getReservedSize() const;
+
+                /**
+                 * Gets the number of events of a level discarded
+                 * because the buffer was full.
+                 *
+                 * @param level level.
+                 * @return number of discarded events.
+                 */
+                 unsigned int getDiscardCount(const LevelPtr& level) const;
+
+                /**
+                 * Sets whether each logging thread adds its events to a queue
+                 * of its own instead of the buffer shared by all threads.
+                 * The queue of a thread holds up to <b>BufferSize</b> events
+                 * and is released when the thread ends.
+                 *
+                 * @param value true to use a queue for each logging thread.
+                 */
+                 void setProducerQueues(bool value);
+
+                /**
+                 * Gets whether each logging thread has a queue of its own.
+                 * @return the current value of the <b>ProducerQueues</b> option.
+                 */
+                 bool getProducerQueues() const;
+
+                /**
+                 * Sets whether the events removed from the queues of the logging
+                 * threads at the same time are dispatched in time stamp order.
+                 * Otherwise only the order of the events of each thread is kept.
+                 *
+                 * @param value true to merge the events by time stamp.
+                 */
+                 void setStrictOrdering(bool value);
+
+                /**
+                 * Gets whether events of different threads are merged by time stamp.
+                 * @return the current value of the <b>StrictOrdering</b> option.
+                 */
+                 bool getStrictOrdering() const;
+
+                /**
+                 * Sets whether each attached appender is given a queue and
+                 * a thread of its own, so that a slow appender does not delay
+                 * the others.  The queues share the events rather than copy them.
+                 *
+                 * @param value true to dispatch to each appender separately.
+                 */
+                 void setDispatchLanes(bool value);
+
+                /**
+                 * Gets whether each attached appender has a queue and thread of its own.
+                 * @return the current value of the <b>DispatchLanes</b> option.
+                 */
+                 bool getDispatchLanes() const;
+
+                /**
+                 * Sets the number of events the queue of an appender holds
+                 * unless set for that appender by setLaneOptions.
+                 *
+                 * @param size maximum number of events waiting for the appender.
+                 */
+                 void setLaneBufferSize(int size);
+
+                /**
+                 * Gets the default size of the queue of an appender.
+                 * @return the current value of the <b>LaneBufferSize</b> option.
+                 */
+                 int getLaneBufferSize() const;
+
+                /**
+                 * Sets whether events wait for space in a full queue of an appender
+                 * or are discarded for that appender, unless set for that
+                 * appender by setLaneOptions.  Discarded events are summarized
+                 * as for a full buffer.  The other appenders still receive the
+                 * waiting events, and once as many events wait as the queue size
+                 * new events stay in the buffer as if it were full.
+                 *
+                 * @param value true to wait for space.
+                 */
+                 void setLaneBlocking(bool value);
+
+                /**
+                 * Gets whether events wait for space in a full queue of an appender.
+                 * @return the current value of the <b>LaneBlocking</b> option.
+                 */
+                 bool getLaneBlocking() const;
+
+                /**
+                 * Sets the size and overflow behavior of the queue of one appender.
+                 *
+                 * @param appenderName name of the attached appender.
+                 * @param size maximum number of events waiting for the appender.
+                 * @param blocking true to wait for space, false to discard events.
+                 */
+                 void setLaneOptions(const LogString& appenderName, int size, bool blocking);
                  
                  
                  /**
@@ -191,19 +336,75 @@ namespace log4cxx
                 */
                 enum { DEFAULT_BUFFER_SIZE = 128 };
 
+                LOG4CXX_LIST_DEF(LoggingEventList, log4cxx::spi::LoggingEventPtr);
+
                 /**
-                 * Event buffer.
+                 *  Bounded multiple producer, single consumer ring of events,
+                 *  defined in the implementation.
+                 */
+                class EventRing;
+
+                /**
+                 * Event buffer, replaced when the buffer size
+                 * grows beyond its capacity.
                 */
-                LOG4CXX_LIST_DEF(LoggingEventList, log4cxx::spi::LoggingEventPtr);
-                LoggingEventList buffer;
+                EventRing* volatile buffer;
+
+                /**
+                 *  Buffers replaced while they may still hold events,
+                 *  oldest first, released by the dispatcher.
+                 */
+                EventRing* retiredBuffers;
+
+                /**
+                 *  Identifies the queues of this appender among
+                 *  the queues of a logging thread.
+                 */
+                const unsigned int id;
+
+                LOG4CXX_LIST_DEF(EventQueueList, helpers::EventQueuePtr);
+
+                /**
+                 *  Queues of logging threads not yet seen by the dispatcher.
+                 */
+                EventQueueList newQueues;
+
+                /**
+                 *  Queues of logging threads read by the dispatcher.
+                 */
+                EventQueueList dispatchQueues;
+
+                /**
+                 *  Number of threads between reading the buffer pointer
+                 *  and adding an event to the shared buffer, threads with
+                 *  their own queue mark that queue instead.
+                 */
+                unsigned int volatile producers;
+
+                /**
+                 *  Nonzero until close takes the remaining events,
+                 *  producers that find it cleared drop their events.
+                 */
+                unsigned int volatile accepting;
+
+                /**
+                 *  Nonzero while the dispatcher waits for events.
+                 */
+                unsigned int volatile dispatcherIdle;
 
                 /**
-                 *  Mutex used to guard access to buffer and discardMap.
+                 *  Number of threads waiting for space in the buffer.
+                 */
+                unsigned int volatile blockedProducers;
+
+                /**
+                 *  Mutex used to guard discardMap, replacement of the buffer
+                 *  and the waits of the dispatcher and blocked threads.
                  */
                 ::log4cxx::helpers::Mutex bufferMutex;
                 ::log4cxx::helpers::Condition bufferNotFull;
                 ::log4cxx::helpers::Condition bufferNotEmpty;
-    
+
                 class DiscardSummary {
                 private:
                     /**
@@ -248,6 +449,34 @@ namespace log4cxx
                 */
                 typedef std::map<LogString, DiscardSummary> DiscardMap;
                 DiscardMap* discardMap;
+
+                /**
+                 * Counts of discarded events keyed by level,
+                 * guarded by bufferMutex.
+                 */
+                typedef std::map<int, unsigned int> DiscardCountMap;
+                DiscardCountMap discardCounts;
+
+                /**
+                 * Filter chains removed by clearFilters, guarded by mutex.
+                 */
+                std::vector<spi::FilterPtr> retiredFilters;
+
+                /**
+                 * Level below which events are discarded first, may be null.
+                 */
+                LevelPtr overflowThreshold;
+
+                /**
+                 * Integer value of overflowThreshold for the logging
+                 * threads, the lowest level if it is null.
+                 */
+                unsigned int volatile overflowLevel;
+
+                /**
+                 * Events of the buffer kept for events at or above overflowThreshold.
+                 */
+                int reservedSize;
                 
                 /**
                  * Buffer size.
@@ -274,6 +503,132 @@ namespace log4cxx
                 */
                 bool blocking;
 
+                /**
+                 * Does each logging thread have a queue.
+                */
+                bool producerQueues;
+
+                /**
+                 * Are the events of the queues merged by time stamp.
+                */
+                bool strictOrdering;
+
+                /**
+                 * Does each appender have a queue and thread.
+                */
+                bool dispatchLanes;
+
+                /**
+                 *  Queue and thread of an attached appender,
+                 *  defined in the implementation.
+                 */
+                class Lane;
+                typedef std::vector<Lane*> LaneList;
+
+                /**
+                 *  Lanes of the attached appenders, guarded
+                 *  by the mutex of the appenders.
+                 */
+                LaneList lanes;
+
+                struct LaneOptions {
+                    int bufferSize;
+                    bool blocking;
+                };
+
+                /**
+                 *  Lane options keyed by appender name.
+                 */
+                typedef std::map<LogString, LaneOptions> LaneOptionMap;
+                LaneOptionMap laneOptions;
+
+                /**
+                 *  Options of lanes of appenders without an entry in laneOptions.
+                 */
+                LaneOptions defaultLaneOptions;
+
+                /**
+                 *  Returns true if the event is below the overflow threshold.
+                 */
+                bool isOverflowable(const spi::LoggingEventPtr& event) const;
+
+                /**
+                 *  Gets the number of events of a buffer that events
+                 *  below the overflow threshold may fill, at least one.
+                 */
+                int getOverflowLimit(int size) const;
+
+                /**
+                 *  Adds an event to the buffer without waiting.
+                 *  @param limit number of events the buffer may hold.
+                 *  @return false if the buffer is full.
+                 */
+                bool tryAppend(const spi::LoggingEventPtr& event, int limit);
+
+                /**
+                 *  Gets the queue of the calling thread, creating it if needed.
+                 *  @return queue, null if thread specific data is unavailable.
+                 */
+                helpers::EventQueue* getProducerQueue();
+
+                /**
+                 *  Returns true if the dispatcher has no events to remove.
+                 *  Called by the dispatcher with bufferMutex held.
+                 */
+                bool isIdle() const;
+
+                /**
+                 *  Removes the events of the queues, merged as configured.
+                 *  Called by the dispatcher.
+                 */
+                void pollQueues(LoggingEventList& events);
+
+                /**
+                 *  Gets the lane options of an appender.
+                 */
+                const LaneOptions& getLaneOptions(const LogString& appenderName) const;
+
+                /**
+                 *  Applies the lane options to the existing lanes.
+                 *  Called with the mutex of the appenders held.
+                 */
+                void updateLanes();
+
+                /**
+                 *  Adds events to the lane of each attached appender, creating
+                 *  and closing lanes as appenders are added and removed.
+                 *  Full blocking lanes keep the events that do not fit
+                 *  until called again.
+                 *  Called by the dispatcher without the mutex of the appenders.
+                 */
+                void dispatchToLanes(const LoggingEventList& events, log4cxx::helpers::Pool& p);
+
+                /**
+                 *  Returns true if a blocking lane keeps as many events
+                 *  waiting for space as its buffer size, the dispatcher
+                 *  then leaves new events in the buffers.
+                 *  Called by the dispatcher.
+                 */
+                bool hasStalledLane() const;
+
+                /**
+                 *  Returns true if a lane keeping events has space for them.
+                 *  Called by the dispatcher.
+                 */
+                bool canRetryLanes() const;
+
+                /**
+                 *  Closes the lanes after their events have been appended.
+                 *  Called by the dispatcher without the mutex of the appenders.
+                 */
+                void closeLanes();
+
+                /**
+                 *  Wakes the dispatcher if it is waiting for events
+                 *  or for space in a lane.
+                 */
+                void signalDispatcher();
+
                 /**
                  *  Dispatch routine.
                  */
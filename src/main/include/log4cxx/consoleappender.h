@@ -67,6 +67,9 @@ namespace log4cxx
                 static const LogString& getSystemErr();
 
 
+        protected:
+                virtual bool formatsBatches() const;
+
         private:
                 void targetWarn(const LogString& val);
 
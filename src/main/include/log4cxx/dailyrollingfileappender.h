@@ -189,6 +189,9 @@ public:
    */
   void activateOptions(log4cxx::helpers::Pool&);
 
+protected:
+  virtual bool formatsBatches() const;
+
 };
 
 LOG4CXX_PTR_DEF(DailyRollingFileAppender);
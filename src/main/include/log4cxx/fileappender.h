@@ -211,6 +211,9 @@ namespace log4cxx
                  */
                 static LogString stripDuplicateBackslashes(const LogString& name);
 
+        protected:
+                virtual bool formatsBatches() const;
+
                 private:
                 FileAppender(const FileAppender&);
                 FileAppender& operator=(const FileAppender&);
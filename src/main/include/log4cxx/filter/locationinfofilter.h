@@ -14,74 +14,110 @@
  * See the License for the specific language governing permissions and
  * limitations under the License.
  */
+
 #ifndef _LOG4CXX_FILTER_LOCATIONINFOFILTER_H
 #define _LOG4CXX_FILTER_LOCATIONINFOFILTER_H
 
+#if defined(_MSC_VER)
+#pragma warning ( push )
+#pragma warning ( disable: 4231 4251 4275 4786 )
+#endif
+
 #include <log4cxx/spi/filter.h>
+#include <log4cxx/spi/location/locationinfo.h>
 
 namespace log4cxx
 {
-    namespace rule
-    {
-        class ExpressionRule;
-        class Rule;
-        typedef helpers::ObjectPtrT < Rule > RulePtr;
-        typedef helpers::ObjectPtrT < ExpressionRule > ExpressionRulePtr;
-    }
-
     namespace filter
     {
 /**
- * Location information is usually specified at the appender level - all events associated
- * with an appender either create and parse stack traces or they do not.  This is
- * an expensive operation and in some cases not needed for all events associated with
- * an appender.
- *
- * This filter creates event-level location information only if the provided expression evaluates to true.
- *
- * For information on expression syntax, see org.apache.log4j.rule.ExpressionRule
- *
- * 
- */
-        class LOG4CXX_EXPORT LocationInfoFilter:public log4cxx::spi::Filter
+   This is a very simple filter based on the location of the
+   logging statement.
+
+   <p>The filter admits the options <b>FileName</b>, <b>MethodName</b>,
+   <b>LineNumber</b> and <b>AcceptOnMatch</b>.  A location matches if it
+   matches every option that is set: <b>FileName</b> matches the full
+   file name or its trailing path components, <b>MethodName</b> matches
+   either the method name or the class and method name separated by
+   "::", and <b>LineNumber</b> matches the line.  On a match the
+   #decide method returns {@link spi::Filter#ACCEPT ACCEPT} if the
+   <b>AcceptOnMatch</b> option is <code>true</code> and {@link
+   spi::Filter#DENY DENY} otherwise.  If there is no match, {@link
+   spi::Filter#NEUTRAL NEUTRAL} is returned.
+
+   <p>The same matching selects call sites in
+   {@link spi::CallSiteRegistry CallSiteRegistry}, which switches
+   individual logging statements on or off before any event is created.
+   */
+        class LOG4CXX_EXPORT LocationInfoFilter : public spi::Filter
         {
-            bool convertInFixToPostFix;
-            LogString expression;
-                      log4cxx::rule::RulePtr expressionRule;
-            //HACK: Category is the last of the internal layers - pass this in as the class name
-            //in order for parsing to work correctly
-            LogString className;
+        private:
+            bool acceptOnMatch;
+            std::string fileName;
+            std::string methodName;
+            int lineNumber;
 
-          public:
-                      DECLARE_LOG4CXX_OBJECT(LocationInfoFilter)
-                      BEGIN_LOG4CXX_CAST_MAP()
-                      LOG4CXX_CAST_ENTRY(log4cxx::spi::Filter)
-                      END_LOG4CXX_CAST_MAP()
+        public:
+            typedef spi::Filter BASE_CLASS;
+            DECLARE_LOG4CXX_OBJECT(LocationInfoFilter)
+            BEGIN_LOG4CXX_CAST_MAP()
+                LOG4CXX_CAST_ENTRY(LocationInfoFilter)
+                LOG4CXX_CAST_ENTRY_CHAIN(BASE_CLASS)
+            END_LOG4CXX_CAST_MAP()
 
-                      LocationInfoFilter();
+            LocationInfoFilter();
 
-            void activateOptions(log4cxx::helpers::Pool &);
+            /**
+            Set options
+            */
+            virtual void setOption(const LogString& option,
+                const LogString& value);
 
-            void setExpression(const LogString & expression);
+            void setFileName(const LogString& fileName);
 
-            LogString getExpression() const;
+            LogString getFileName() const;
 
-            void setConvertInFixToPostFix(bool convertInFixToPostFix);
+            void setMethodName(const LogString& methodName);
 
-            bool getConvertInFixToPostFix() const;
+            LogString getMethodName() const;
 
-  /**
-   * If this event does not already contain location information,
-   * evaluate the event against the expression.
-   *
-   * If the expression evaluates to true, generate a LocationInfo instance
-   * by creating an exception and set this LocationInfo on the event.
-   *
-   * Returns {@link log4cxx::spi::Filter#NEUTRAL}
-   */
-            FilterDecision decide(const spi::LoggingEventPtr & event) const;
+            /**
+            Set the line to match, -1 matches any line.
+            */
+            inline void setLineNumber(int lineNumber1)
+                { this->lineNumber = lineNumber1; }
+
+            inline int getLineNumber() const
+                { return lineNumber; }
+
+            inline void setAcceptOnMatch(bool acceptOnMatch1)
+                { this->acceptOnMatch = acceptOnMatch1; }
 
-        };
-    }
-}
+            inline bool getAcceptOnMatch() const
+                { return acceptOnMatch; }
+
+            /**
+            Returns <code>true</code> if the location matches every
+            option that is set.
+            */
+            bool matches(const spi::LocationInfo& location) const;
+
+            /**
+            Return the decision of this filter for a location.
+            */
+            FilterDecision decide(const spi::LocationInfo& location) const;
+
+            /**
+            Return the decision of this filter for the location of the event.
+            */
+            FilterDecision decide(const spi::LoggingEventPtr& event) const;
+        }; // class LocationInfoFilter
+        LOG4CXX_PTR_DEF(LocationInfoFilter);
+    }  // namespace filter
+} // namespace log4cxx
+
+#if defined(_MSC_VER)
+#pragma warning ( pop )
 #endif
+
+#endif // _LOG4CXX_FILTER_LOCATIONINFOFILTER_H
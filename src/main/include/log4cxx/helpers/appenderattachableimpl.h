@@ -76,6 +76,12 @@ namespace log4cxx
             int appendLoopOnAppenders(const spi::LoggingEventPtr& event,
                 log4cxx::helpers::Pool& p);
 
+            /**
+             Call the <code>doAppendBatch</code> method on all attached appenders.
+            */
+            int appendLoopOnAppenders(const spi::LoggingEventList& events,
+                log4cxx::helpers::Pool& p);
+
             /**
              * Get all previously added appenders as an Enumeration.
              */
@@ -0,0 +1,240 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LOG4CXX_HELPERS_BRACE_FORMAT_H
+#define _LOG4CXX_HELPERS_BRACE_FORMAT_H
+
+#include <log4cxx/helpers/messagebuffer.h>
+
+namespace log4cxx {
+   namespace helpers {
+   /**
+    *   This class is used by the LOG4CXX_INFO_FMT and similar macros
+    *   to format a message from a pattern such as "user={} took {}ms".
+    *   Each "{}" is replaced by the next argument, inserted as the
+    *   LOG4CXX_INFO macro would insert it, and "{{" and "}}" stand for
+    *   literal braces.  Placeholders without an argument are kept as is
+    *   and arguments without a placeholder are ignored, both reported
+    *   through LogLog.
+    *   The class is not intended for use outside of that context.
+    */
+   class LOG4CXX_EXPORT BraceFormat {
+   public:
+      /**
+       *  Message buffer for a pattern character type.
+       */
+      template<class C> struct Buffer;
+
+      /**
+       *  Gets the buffer to format a pattern into.
+       *  @param buf message buffer.
+       *  @return buf.
+       */
+      static CharMessageBuffer& getBuffer(CharMessageBuffer& buf, const char*) {
+         return buf;
+      }
+      /**
+       *  Appends the pattern up to its next placeholder.
+       *  @param out buffer.
+       *  @param pattern remaining pattern, advanced past the placeholder.
+       *  @return true if a placeholder was found.
+       */
+      static bool appendLiteral(CharMessageBuffer& out, const char*& pattern);
+      /**
+       *  Appends the rest of the pattern, keeping placeholders.
+       *  @param out buffer.
+       *  @param pattern remaining pattern.
+       *  @return number of placeholders kept.
+       */
+      static size_t appendRemainder(CharMessageBuffer& out, const char* pattern);
+      /**
+       *  Reports a pattern whose placeholders do not match its arguments.
+       *  @param pattern pattern.
+       *  @param placeholders number of placeholders.
+       *  @param arguments number of arguments.
+       */
+      static void reportMismatch(const char* pattern, size_t placeholders, size_t arguments);
+#if LOG4CXX_WCHAR_T_API
+      /**
+       *  Gets the char buffer of a message buffer.
+       *  @param buf message buffer.
+       *  @return char buffer.
+       */
+      static CharMessageBuffer& getBuffer(MessageBuffer& buf, const char*);
+      /**
+       *  Gets the buffer to format a pattern into.
+       *  @param buf message buffer.
+       *  @return buf.
+       */
+      static WideMessageBuffer& getBuffer(WideMessageBuffer& buf, const wchar_t*) {
+         return buf;
+      }
+      /**
+       *  Gets the wchar_t buffer of a message buffer, creating it if needed.
+       *  @param buf message buffer.
+       *  @return wchar_t buffer.
+       */
+      static WideMessageBuffer& getBuffer(MessageBuffer& buf, const wchar_t*);
+      /**
+       *  Appends the pattern up to its next placeholder.
+       *  @param out buffer.
+       *  @param pattern remaining pattern, advanced past the placeholder.
+       *  @return true if a placeholder was found.
+       */
+      static bool appendLiteral(WideMessageBuffer& out, const wchar_t*& pattern);
+      /**
+       *  Appends the rest of the pattern, keeping placeholders.
+       *  @param out buffer.
+       *  @param pattern remaining pattern.
+       *  @return number of placeholders kept.
+       */
+      static size_t appendRemainder(WideMessageBuffer& out, const wchar_t* pattern);
+      /**
+       *  Reports a pattern whose placeholders do not match its arguments.
+       *  @param pattern pattern.
+       *  @param placeholders number of placeholders.
+       *  @param arguments number of arguments.
+       */
+      static void reportMismatch(const wchar_t* pattern, size_t placeholders, size_t arguments);
+#endif
+
+   private:
+      BraceFormat();
+   };
+
+   template<> struct BraceFormat::Buffer<char> {
+      typedef CharMessageBuffer type;
+   };
+#if LOG4CXX_WCHAR_T_API
+   template<> struct BraceFormat::Buffer<wchar_t> {
+      typedef WideMessageBuffer type;
+   };
+#endif
+
+   /**
+    *  Formats the arguments of one braceFormat call in turn,
+    *  each replacing the next placeholder of the pattern.
+    */
+   template<class C>
+   class BraceFormatter {
+   public:
+      typedef typename BraceFormat::Buffer<C>::type buffer_type;
+
+      template<class B>
+      BraceFormatter(B& buf, const C* pattern) :
+         out(BraceFormat::getBuffer(buf, pattern)), pattern(pattern),
+         remaining(pattern), arguments(0), unused(0) {
+      }
+
+      /**
+       *  Replaces the next placeholder by an argument.
+       *  @param arg argument.
+       *  @return this formatter.
+       */
+      template<class A>
+      BraceFormatter& operator()(const A& arg) {
+         arguments++;
+         if (unused == 0 && BraceFormat::appendLiteral(out, remaining)) {
+            out << arg;
+         } else {
+            unused++;
+         }
+         return *this;
+      }
+
+      /**
+       *  Appends the rest of the pattern.
+       *  @return buffer holding the message.
+       */
+      buffer_type& finish() {
+         size_t kept = BraceFormat::appendRemainder(out, remaining);
+         if (kept > 0 || unused > 0) {
+            BraceFormat::reportMismatch(pattern, arguments - unused + kept, arguments);
+         }
+         return out;
+      }
+
+   private:
+      buffer_type& out;
+      const C* const pattern;
+      const C* remaining;
+      size_t arguments;
+      size_t unused;
+   };
+
+   /**
+    *  Formats a pattern without arguments into a message buffer.
+    *  @param buf message buffer.
+    *  @param pattern pattern.
+    *  @return buffer holding the message.
+    */
+   template<class B, class C>
+   typename BraceFormat::Buffer<C>::type& braceFormat(B& buf, const C* pattern) {
+      return BraceFormatter<C>(buf, pattern).finish();
+   }
+
+   /**
+    *  Formats a pattern and arguments into a message buffer.
+    *  @param buf message buffer.
+    *  @param pattern pattern.
+    *  @param a1 argument for the first placeholder.
+    *  @return buffer holding the message.
+    */
+   template<class B, class C, class A1>
+   typename BraceFormat::Buffer<C>::type& braceFormat(B& buf, const C* pattern, const A1& a1) {
+      return BraceFormatter<C>(buf, pattern)(a1).finish();
+   }
+
+   template<class B, class C, class A1, class A2>
+   typename BraceFormat::Buffer<C>::type& braceFormat(B& buf, const C* pattern, const A1& a1, const A2& a2) {
+      return BraceFormatter<C>(buf, pattern)(a1)(a2).finish();
+   }
+
+   template<class B, class C, class A1, class A2, class A3>
+   typename BraceFormat::Buffer<C>::type& braceFormat(B& buf, const C* pattern, const A1& a1, const A2& a2, const A3& a3) {
+      return BraceFormatter<C>(buf, pattern)(a1)(a2)(a3).finish();
+   }
+
+   template<class B, class C, class A1, class A2, class A3, class A4>
+   typename BraceFormat::Buffer<C>::type& braceFormat(B& buf, const C* pattern, const A1& a1, const A2& a2, const A3& a3, const A4& a4) {
+      return BraceFormatter<C>(buf, pattern)(a1)(a2)(a3)(a4).finish();
+   }
+
+   template<class B, class C, class A1, class A2, class A3, class A4, class A5>
+   typename BraceFormat::Buffer<C>::type& braceFormat(B& buf, const C* pattern, const A1& a1, const A2& a2, const A3& a3, const A4& a4, const A5& a5) {
+      return BraceFormatter<C>(buf, pattern)(a1)(a2)(a3)(a4)(a5).finish();
+   }
+
+   template<class B, class C, class A1, class A2, class A3, class A4, class A5, class A6>
+   typename BraceFormat::Buffer<C>::type& braceFormat(B& buf, const C* pattern, const A1& a1, const A2& a2, const A3& a3, const A4& a4, const A5& a5, const A6& a6) {
+      return BraceFormatter<C>(buf, pattern)(a1)(a2)(a3)(a4)(a5)(a6).finish();
+   }
+
+   template<class B, class C, class A1, class A2, class A3, class A4, class A5, class A6, class A7>
+   typename BraceFormat::Buffer<C>::type& braceFormat(B& buf, const C* pattern, const A1& a1, const A2& a2, const A3& a3, const A4& a4, const A5& a5, const A6& a6, const A7& a7) {
+      return BraceFormatter<C>(buf, pattern)(a1)(a2)(a3)(a4)(a5)(a6)(a7).finish();
+   }
+
+   template<class B, class C, class A1, class A2, class A3, class A4, class A5, class A6, class A7, class A8>
+   typename BraceFormat::Buffer<C>::type& braceFormat(B& buf, const C* pattern, const A1& a1, const A2& a2, const A3& a3, const A4& a4, const A5& a5, const A6& a6, const A7& a7, const A8& a8) {
+      return BraceFormatter<C>(buf, pattern)(a1)(a2)(a3)(a4)(a5)(a6)(a7)(a8).finish();
+   }
+
+   }
+}
+
+#endif
@@ -81,24 +81,6 @@ namespace log4cxx
              */
             log4cxx::helpers::DateFormatPtr formatter;
 
-            /**
-             *  Index of initial digit of millisecond pattern or
-             *   UNRECOGNIZED_MILLISECONDS or NO_MILLISECONDS.
-             */
-            mutable int millisecondStart;
-
-            /**
-             *  Integral second preceding the previous convered Date.
-             */
-            mutable log4cxx_time_t slotBegin;
-
-
-            /**
-             *  Cache of previous conversion.
-             */
-            mutable LogString cache;
-
-
             /**
              *  Maximum validity period for the cache.
              *  Typically 1, use cache for duplicate requests only, or
@@ -107,9 +89,11 @@ namespace log4cxx
             const int expiration;
 
             /**
-             *  Date requested in previous conversion.
+             *  Identifies the cached conversions of this object
+             *  in the thread specific data of each formatting thread,
+             *  replaced when the timezone changes.
              */
-            mutable log4cxx_time_t previousTime;
+            unsigned int volatile id;
 
        public:
           /**
@@ -139,6 +123,8 @@ namespace log4cxx
 
             /**
              * Formats a Date into a date/time string.
+             * Each thread keeps its own copy of the last conversion
+             * so concurrent calls do not need to be synchronized.
              *
              *  @param date the date to format.
              *  @param sbuf the string buffer to write to.
@@ -160,6 +146,11 @@ namespace log4cxx
                     LogString& buf,
                     int offset);
 
+                /**
+                 *  Gets a new identifier, never 0.
+                 */
+                static unsigned int nextId();
+
 
            public:
                /**
@@ -0,0 +1,509 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LOG4CXX_HELPERS_DEFERRED_LOG_H
+#define _LOG4CXX_HELPERS_DEFERRED_LOG_H
+
+#include <log4cxx/logger.h>
+#include <log4cxx/helpers/braceformat.h>
+#include <log4cxx/helpers/objectimpl.h>
+#include <log4cxx/helpers/sharedstring.h>
+#include <string.h>
+
+namespace log4cxx {
+   namespace helpers {
+   /**
+    *  Single producer, single consumer ring of the deferred logging
+    *  requests of one thread.  The thread appends records, the
+    *  background thread of DeferredLog removes them.
+    */
+   class LOG4CXX_EXPORT DeferredBuffer : public ObjectImpl {
+   public:
+      DECLARE_LOG4CXX_OBJECT(DeferredBuffer)
+      BEGIN_LOG4CXX_CAST_MAP()
+              LOG4CXX_CAST_ENTRY(DeferredBuffer)
+      END_LOG4CXX_CAST_MAP()
+
+      enum { CAPACITY = 64 * 1024 };
+
+      DeferredBuffer();
+      DeferredBuffer(const SharedStringPtr& threadName);
+      virtual ~DeferredBuffer();
+
+      /**
+       *  Reserves contiguous space for a record, waiting while the ring is full.
+       *  Called by the owning thread only.
+       *  @param size record size.
+       *  @return start of the record, null if the ring stayed full
+       *  because the background thread stopped.
+       */
+      char* reserve(size_t size);
+      /**
+       *  Publishes the reserved record.
+       */
+      void commit();
+      /**
+       *  Waits until all records have been removed.
+       *  @return true if empty.
+       */
+      bool waitUntilEmpty();
+
+      /**
+       *  Gets the end of the published records.
+       */
+      unsigned int getHead() const;
+      /**
+       *  Gets the start of the records not yet removed.
+       */
+      unsigned int getTail() const;
+      /**
+       *  Gets the record at a position.
+       */
+      const char* getRecord(unsigned int position) const;
+      /**
+       *  Releases records before a position.  Called by the consumer only.
+       */
+      void setTail(unsigned int position);
+      /**
+       *  Returns true if the owning thread has released the buffer.
+       */
+      bool isOrphaned() const;
+
+      inline const SharedStringPtr& getThreadName() const {
+         return threadName;
+      }
+      /**
+       *  Sets the thread name of later records.
+       *  Called by the owning thread only while the ring is empty.
+       */
+      inline void setThreadName(const SharedStringPtr& name) {
+         threadName = name;
+      }
+
+   private:
+      DeferredBuffer(const DeferredBuffer&);
+      DeferredBuffer& operator=(const DeferredBuffer&);
+      bool canWait() const;
+
+      char* data;
+      SharedStringPtr threadName;
+      unsigned int volatile head;
+      /**
+       *  Separates the positions written by each side.
+       */
+      char padding[64];
+      unsigned int volatile tail;
+      /**
+       *  Owner's view of tail and position after the reserved record.
+       */
+      unsigned int cachedTail;
+      unsigned int reserved;
+   };
+   LOG4CXX_PTR_DEF(DeferredBuffer);
+
+   /**
+    *   Level of a deferred logging request, given as the integer of
+    *   a standard level, as the macros do, or as a level object,
+    *   which a custom level requires.
+    */
+   class DeferredLevel {
+   public:
+      DeferredLevel(int val) : value(val), level(0) {
+      }
+      DeferredLevel(const LevelPtr& val) : value(val->toInt()), level(val) {
+      }
+      LevelPtr toLevel() const {
+         return level != 0 ? LevelPtr(level) : Level::toLevel(value);
+      }
+
+      const int value;
+      /**
+       *  Level object, null for the integer of a standard level.
+       */
+      Level* const level;
+   };
+
+   /**
+    *   Supports the LOG4CXX_INFO_DEFERRED and similar macros.
+    *
+    *   <p>A deferred logging request only copies the logger, level, call site,
+    *   pattern and the binary value of its arguments into a buffer
+    *   owned by the calling thread.  A background thread later formats the
+    *   message, creates the logging event and passes it to the appenders
+    *   of the logger, so configured layouts and appenders are unchanged.
+    *   The record holds a reference to the logger and to a custom level
+    *   until it has been processed.
+    *
+    *   <p>Events keep their original time stamp and thread name but carry
+    *   no NDC or MDC.  Logging blocks while the thread's buffer is full.
+    *   Requests too large for the buffer are logged immediately once the
+    *   earlier requests of the thread have been processed, and requests
+    *   made by the background thread itself, such as from an appender,
+    *   are always logged immediately.  Only if the background thread
+    *   cannot be started is a request logged immediately ahead of
+    *   earlier requests still in the buffer.
+    */
+   class LOG4CXX_EXPORT DeferredLog {
+   public:
+      /**
+       *  Argument type tags of the binary record.
+       */
+      enum {
+         TAG_INTEGER = 1,
+         TAG_UNSIGNED = 2,
+         TAG_DOUBLE = 3,
+         TAG_CHAR = 4,
+         TAG_STRING = 5
+      };
+
+      /**
+       *  Reserves a record in the calling thread's buffer.
+       *  @param logger logger.
+       *  @param level level, such as Level::INFO_INT.
+       *  @param site location of the logging request.
+       *  @param pattern brace format pattern, copied into the record.
+       *  @param argumentSize size of the encoded arguments.
+       *  @param args receives where the arguments are to be written.
+       *  @return buffer to pass to commit, null if the request
+       *  must be logged immediately.
+       */
+      static DeferredBuffer* reserve(const Logger* logger, const DeferredLevel& level,
+         const spi::CallSite& site, const char* pattern,
+         size_t argumentSize, char*& args);
+      /**
+       *  Makes the reserved record available to the background thread,
+       *  waking it if idle.
+       *  @param buffer buffer returned by reserve.
+       */
+      static void commit(DeferredBuffer* buffer);
+
+      /**
+       *  Waits until the requests made before the call
+       *  have been passed to the appenders.
+       */
+      static void flush();
+      /**
+       *  Processes pending requests and stops the background thread,
+       *  which is restarted by the next deferred request.
+       */
+      static void shutdown();
+      /**
+       *  Returns true if called by the background thread.
+       */
+      static bool isDispatchThread();
+      /**
+       *  Creates the logging event of a record and passes it to
+       *  the appenders of its logger.  Called by the background thread.
+       *  @param buffer buffer holding the record.
+       *  @param record record.
+       */
+      static void dispatch(const DeferredBuffer& buffer, const char* record);
+
+   private:
+      DeferredLog();
+   };
+
+   /**
+    *  Encodes an argument of a deferred logging request.
+    *  Only the specialized types may be used as arguments.
+    */
+   template<class T> struct DeferredArgument;
+
+   /**
+    *  Encodes signed integers.
+    */
+   struct DeferredInteger {
+      static size_t size(log4cxx_int64_t) {
+         return 1 + sizeof(log4cxx_int64_t);
+      }
+      static char* write(char* args, log4cxx_int64_t val) {
+         *args = (char) DeferredLog::TAG_INTEGER;
+         memcpy(args + 1, &val, sizeof(val));
+         return args + 1 + sizeof(val);
+      }
+   };
+
+   /**
+    *  Encodes unsigned integers.
+    */
+   struct DeferredUnsigned {
+      static size_t size(log4cxx_uint64_t) {
+         return 1 + sizeof(log4cxx_uint64_t);
+      }
+      static char* write(char* args, log4cxx_uint64_t val) {
+         *args = (char) DeferredLog::TAG_UNSIGNED;
+         memcpy(args + 1, &val, sizeof(val));
+         return args + 1 + sizeof(val);
+      }
+   };
+
+   /**
+    *  Encodes floating point numbers.
+    */
+   struct DeferredDouble {
+      static size_t size(double) {
+         return 1 + sizeof(double);
+      }
+      static char* write(char* args, double val) {
+         *args = (char) DeferredLog::TAG_DOUBLE;
+         memcpy(args + 1, &val, sizeof(val));
+         return args + 1 + sizeof(val);
+      }
+   };
+
+   /**
+    *  Encodes strings as their length followed by their characters.
+    */
+   struct DeferredString {
+      static size_t size(const char* val) {
+         return 1 + sizeof(size_t) + (val == 0 ? 4 : strlen(val));
+      }
+      static char* write(char* args, const char* val) {
+         if (val == 0) {
+            val = "null";
+         }
+         return write(args, val, strlen(val));
+      }
+      static size_t size(const std::string& val) {
+         return 1 + sizeof(size_t) + val.length();
+      }
+      static char* write(char* args, const std::string& val) {
+         return write(args, val.data(), val.length());
+      }
+      static char* write(char* args, const char* val, size_t len) {
+         *args = (char) DeferredLog::TAG_STRING;
+         memcpy(args + 1, &len, sizeof(len));
+         memcpy(args + 1 + sizeof(len), val, len);
+         return args + 1 + sizeof(len) + len;
+      }
+   };
+
+   template<> struct DeferredArgument<bool> {
+      static size_t size(bool val) {
+         return DeferredInteger::size(val);
+      }
+      static char* write(char* args, bool val) {
+         return DeferredInteger::write(args, val ? 1 : 0);
+      }
+   };
+
+   template<> struct DeferredArgument<char> {
+      static size_t size(char) {
+         return 2;
+      }
+      static char* write(char* args, char val) {
+         args[0] = (char) DeferredLog::TAG_CHAR;
+         args[1] = val;
+         return args + 2;
+      }
+   };
+
+   template<> struct DeferredArgument<short> : DeferredInteger {};
+   template<> struct DeferredArgument<int> : DeferredInteger {};
+   template<> struct DeferredArgument<long> : DeferredInteger {};
+   template<> struct DeferredArgument<log4cxx_int64_t> : DeferredInteger {};
+   template<> struct DeferredArgument<unsigned short> : DeferredUnsigned {};
+   template<> struct DeferredArgument<unsigned int> : DeferredUnsigned {};
+   template<> struct DeferredArgument<unsigned long> : DeferredUnsigned {};
+   template<> struct DeferredArgument<log4cxx_uint64_t> : DeferredUnsigned {};
+   template<> struct DeferredArgument<float> : DeferredDouble {};
+   template<> struct DeferredArgument<double> : DeferredDouble {};
+   template<> struct DeferredArgument<const char*> : DeferredString {};
+   template<> struct DeferredArgument<char*> : DeferredString {};
+   template<> struct DeferredArgument<std::string> : DeferredString {};
+   template<size_t N> struct DeferredArgument<char[N]> : DeferredString {};
+   template<size_t N> struct DeferredArgument<const char[N]> : DeferredString {};
+
+   /**
+    *  Records a deferred logging request.
+    *  @param logger logger.
+    *  @param level level, such as Level::INFO_INT.
+    *  @param site location of the logging request.
+    *  @param pattern brace format pattern.
+    */
+   inline void deferredLog(const Logger* logger, const DeferredLevel& level,
+         const spi::CallSite& site, const char* pattern) {
+      char* args = 0;
+      DeferredBuffer* buffer = DeferredLog::reserve(logger, level, site, pattern, 0, args);
+      if (buffer != 0) {
+         DeferredLog::commit(buffer);
+      } else {
+         MessageBuffer buf;
+         logger->forcedLog(level.toLevel(), braceFormat(buf, pattern),
+            spi::LocationInfo(site.fileName, site.methodName, site.lineNumber));
+      }
+   }
+
+   template<class A1>
+   void deferredLog(const Logger* logger, const DeferredLevel& level,
+         const spi::CallSite& site, const char* pattern, const A1& a1) {
+      char* args = 0;
+      DeferredBuffer* buffer = DeferredLog::reserve(logger, level, site, pattern,
+         DeferredArgument<A1>::size(a1), args);
+      if (buffer != 0) {
+         args = DeferredArgument<A1>::write(args, a1);
+         DeferredLog::commit(buffer);
+      } else {
+         MessageBuffer buf;
+         logger->forcedLog(level.toLevel(), braceFormat(buf, pattern, a1),
+            spi::LocationInfo(site.fileName, site.methodName, site.lineNumber));
+      }
+   }
+
+   template<class A1, class A2>
+   void deferredLog(const Logger* logger, const DeferredLevel& level,
+         const spi::CallSite& site, const char* pattern, const A1& a1, const A2& a2) {
+      char* args = 0;
+      DeferredBuffer* buffer = DeferredLog::reserve(logger, level, site, pattern,
+         DeferredArgument<A1>::size(a1) + DeferredArgument<A2>::size(a2), args);
+      if (buffer != 0) {
+         args = DeferredArgument<A1>::write(args, a1);
+         args = DeferredArgument<A2>::write(args, a2);
+         DeferredLog::commit(buffer);
+      } else {
+         MessageBuffer buf;
+         logger->forcedLog(level.toLevel(), braceFormat(buf, pattern, a1, a2),
+            spi::LocationInfo(site.fileName, site.methodName, site.lineNumber));
+      }
+   }
+
+   template<class A1, class A2, class A3>
+   void deferredLog(const Logger* logger, const DeferredLevel& level,
+         const spi::CallSite& site, const char* pattern, const A1& a1, const A2& a2, const A3& a3) {
+      char* args = 0;
+      DeferredBuffer* buffer = DeferredLog::reserve(logger, level, site, pattern,
+         DeferredArgument<A1>::size(a1) + DeferredArgument<A2>::size(a2) + DeferredArgument<A3>::size(a3), args);
+      if (buffer != 0) {
+         args = DeferredArgument<A1>::write(args, a1);
+         args = DeferredArgument<A2>::write(args, a2);
+         args = DeferredArgument<A3>::write(args, a3);
+         DeferredLog::commit(buffer);
+      } else {
+         MessageBuffer buf;
+         logger->forcedLog(level.toLevel(), braceFormat(buf, pattern, a1, a2, a3),
+            spi::LocationInfo(site.fileName, site.methodName, site.lineNumber));
+      }
+   }
+
+   template<class A1, class A2, class A3, class A4>
+   void deferredLog(const Logger* logger, const DeferredLevel& level,
+         const spi::CallSite& site, const char* pattern, const A1& a1, const A2& a2, const A3& a3, const A4& a4) {
+      char* args = 0;
+      DeferredBuffer* buffer = DeferredLog::reserve(logger, level, site, pattern,
+         DeferredArgument<A1>::size(a1) + DeferredArgument<A2>::size(a2) + DeferredArgument<A3>::size(a3) + DeferredArgument<A4>::size(a4), args);
+      if (buffer != 0) {
+         args = DeferredArgument<A1>::write(args, a1);
+         args = DeferredArgument<A2>::write(args, a2);
+         args = DeferredArgument<A3>::write(args, a3);
+         args = DeferredArgument<A4>::write(args, a4);
+         DeferredLog::commit(buffer);
+      } else {
+         MessageBuffer buf;
+         logger->forcedLog(level.toLevel(), braceFormat(buf, pattern, a1, a2, a3, a4),
+            spi::LocationInfo(site.fileName, site.methodName, site.lineNumber));
+      }
+   }
+
+   template<class A1, class A2, class A3, class A4, class A5>
+   void deferredLog(const Logger* logger, const DeferredLevel& level,
+         const spi::CallSite& site, const char* pattern, const A1& a1, const A2& a2, const A3& a3, const A4& a4, const A5& a5) {
+      char* args = 0;
+      DeferredBuffer* buffer = DeferredLog::reserve(logger, level, site, pattern,
+         DeferredArgument<A1>::size(a1) + DeferredArgument<A2>::size(a2) + DeferredArgument<A3>::size(a3) + DeferredArgument<A4>::size(a4) + DeferredArgument<A5>::size(a5), args);
+      if (buffer != 0) {
+         args = DeferredArgument<A1>::write(args, a1);
+         args = DeferredArgument<A2>::write(args, a2);
+         args = DeferredArgument<A3>::write(args, a3);
+         args = DeferredArgument<A4>::write(args, a4);
+         args = DeferredArgument<A5>::write(args, a5);
+         DeferredLog::commit(buffer);
+      } else {
+         MessageBuffer buf;
+         logger->forcedLog(level.toLevel(), braceFormat(buf, pattern, a1, a2, a3, a4, a5),
+            spi::LocationInfo(site.fileName, site.methodName, site.lineNumber));
+      }
+   }
+
+   template<class A1, class A2, class A3, class A4, class A5, class A6>
+   void deferredLog(const Logger* logger, const DeferredLevel& level,
+         const spi::CallSite& site, const char* pattern, const A1& a1, const A2& a2, const A3& a3, const A4& a4, const A5& a5, const A6& a6) {
+      char* args = 0;
+      DeferredBuffer* buffer = DeferredLog::reserve(logger, level, site, pattern,
+         DeferredArgument<A1>::size(a1) + DeferredArgument<A2>::size(a2) + DeferredArgument<A3>::size(a3) + DeferredArgument<A4>::size(a4) + DeferredArgument<A5>::size(a5) + DeferredArgument<A6>::size(a6), args);
+      if (buffer != 0) {
+         args = DeferredArgument<A1>::write(args, a1);
+         args = DeferredArgument<A2>::write(args, a2);
+         args = DeferredArgument<A3>::write(args, a3);
+         args = DeferredArgument<A4>::write(args, a4);
+         args = DeferredArgument<A5>::write(args, a5);
+         args = DeferredArgument<A6>::write(args, a6);
+         DeferredLog::commit(buffer);
+      } else {
+         MessageBuffer buf;
+         logger->forcedLog(level.toLevel(), braceFormat(buf, pattern, a1, a2, a3, a4, a5, a6),
+            spi::LocationInfo(site.fileName, site.methodName, site.lineNumber));
+      }
+   }
+
+   template<class A1, class A2, class A3, class A4, class A5, class A6, class A7>
+   void deferredLog(const Logger* logger, const DeferredLevel& level,
+         const spi::CallSite& site, const char* pattern, const A1& a1, const A2& a2, const A3& a3, const A4& a4, const A5& a5, const A6& a6, const A7& a7) {
+      char* args = 0;
+      DeferredBuffer* buffer = DeferredLog::reserve(logger, level, site, pattern,
+         DeferredArgument<A1>::size(a1) + DeferredArgument<A2>::size(a2) + DeferredArgument<A3>::size(a3) + DeferredArgument<A4>::size(a4) + DeferredArgument<A5>::size(a5) + DeferredArgument<A6>::size(a6) + DeferredArgument<A7>::size(a7), args);
+      if (buffer != 0) {
+         args = DeferredArgument<A1>::write(args, a1);
+         args = DeferredArgument<A2>::write(args, a2);
+         args = DeferredArgument<A3>::write(args, a3);
+         args = DeferredArgument<A4>::write(args, a4);
+         args = DeferredArgument<A5>::write(args, a5);
+         args = DeferredArgument<A6>::write(args, a6);
+         args = DeferredArgument<A7>::write(args, a7);
+         DeferredLog::commit(buffer);
+      } else {
+         MessageBuffer buf;
+         logger->forcedLog(level.toLevel(), braceFormat(buf, pattern, a1, a2, a3, a4, a5, a6, a7),
+            spi::LocationInfo(site.fileName, site.methodName, site.lineNumber));
+      }
+   }
+
+   template<class A1, class A2, class A3, class A4, class A5, class A6, class A7, class A8>
+   void deferredLog(const Logger* logger, const DeferredLevel& level,
+         const spi::CallSite& site, const char* pattern, const A1& a1, const A2& a2, const A3& a3, const A4& a4, const A5& a5, const A6& a6, const A7& a7, const A8& a8) {
+      char* args = 0;
+      DeferredBuffer* buffer = DeferredLog::reserve(logger, level, site, pattern,
+         DeferredArgument<A1>::size(a1) + DeferredArgument<A2>::size(a2) + DeferredArgument<A3>::size(a3) + DeferredArgument<A4>::size(a4) + DeferredArgument<A5>::size(a5) + DeferredArgument<A6>::size(a6) + DeferredArgument<A7>::size(a7) + DeferredArgument<A8>::size(a8), args);
+      if (buffer != 0) {
+         args = DeferredArgument<A1>::write(args, a1);
+         args = DeferredArgument<A2>::write(args, a2);
+         args = DeferredArgument<A3>::write(args, a3);
+         args = DeferredArgument<A4>::write(args, a4);
+         args = DeferredArgument<A5>::write(args, a5);
+         args = DeferredArgument<A6>::write(args, a6);
+         args = DeferredArgument<A7>::write(args, a7);
+         args = DeferredArgument<A8>::write(args, a8);
+         DeferredLog::commit(buffer);
+      } else {
+         MessageBuffer buf;
+         logger->forcedLog(level.toLevel(), braceFormat(buf, pattern, a1, a2, a3, a4, a5, a6, a7, a8),
+            spi::LocationInfo(site.fileName, site.methodName, site.lineNumber));
+      }
+   }
+   }
+}
+
+#endif
@@ -0,0 +1,139 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LOG4CXX_HELPERS_EVENT_QUEUE_H
+#define _LOG4CXX_HELPERS_EVENT_QUEUE_H
+
+#if defined(_MSC_VER)
+#pragma warning ( push )
+#pragma warning ( disable: 4231 4251 4275 4786 )
+#endif
+
+#include <log4cxx/helpers/objectimpl.h>
+#include <log4cxx/spi/loggingevent.h>
+
+namespace log4cxx {
+   namespace helpers {
+      /**
+       *  Single producer, single consumer ring of the events one thread
+       *  passes to an AsyncAppender.  The thread keeps the queue in its
+       *  thread specific data, the dispatcher of the appender removes
+       *  the events.
+       */
+      class LOG4CXX_EXPORT EventQueue : public ObjectImpl {
+      public:
+      DECLARE_ABSTRACT_LOG4CXX_OBJECT(EventQueue)
+      BEGIN_LOG4CXX_CAST_MAP()
+              LOG4CXX_CAST_ENTRY(EventQueue)
+      END_LOG4CXX_CAST_MAP()
+
+      /**
+       *  Creates a new instance.
+       *  @param ownerId identifier of the appender.
+       *  @param size maximum number of events.
+       */
+      EventQueue(unsigned int ownerId, int size);
+      virtual ~EventQueue();
+
+      inline unsigned int getOwnerId() const {
+        return ownerId;
+      }
+
+      inline unsigned int getCapacity() const {
+        return mask + 1;
+      }
+
+      /**
+       *  Adds an event unless limit events are already queued.
+       *  Called by the owning thread only.
+       *  @return false if full.
+       */
+      bool offer(const spi::LoggingEventPtr& event, int limit);
+
+      /**
+       *  Marks the owning thread as adding an event.  The appender
+       *  waits for the mark to be cleared before taking the last
+       *  events of its queues when closed.  Called by the owning
+       *  thread only, before checking whether the appender is closed.
+       */
+      void beginOffer();
+
+      /**
+       *  Clears the mark set by beginOffer.
+       */
+      void endOffer();
+
+      bool isOffering() const;
+
+      /**
+       *  Moves the queued events to a list.  Called by the dispatcher only.
+       *  @return false if there were none.
+       */
+      bool poll(spi::LoggingEventList& events);
+
+      /**
+       *  Returns true if no events are queued.  Called by the dispatcher only.
+       */
+      bool isEmpty() const;
+
+      /**
+       *  Returns true if the owning thread has released the queue.
+       */
+      bool isOrphaned() const;
+
+      /**
+       *  Marks the queue as no longer read since the appender closed.
+       */
+      void detach();
+
+      bool isDetached() const;
+
+      private:
+      EventQueue(const EventQueue&);
+      EventQueue& operator=(const EventQueue&);
+      const unsigned int ownerId;
+      unsigned int mask;
+      spi::LoggingEventPtr* events;
+      unsigned int volatile detached;
+      /**
+       *  Separates the positions written by each side.
+       */
+      char padding1[64];
+      unsigned int volatile head;
+      /**
+       *  Owner's view of tail.
+       */
+      unsigned int cachedTail;
+      /**
+       *  Nonzero between beginOffer and endOffer.
+       */
+      unsigned int volatile offering;
+      char padding2[64];
+      unsigned int volatile tail;
+      char padding3[64];
+      };
+
+      LOG4CXX_PTR_DEF(EventQueue);
+
+   }
+}
+
+#if defined(_MSC_VER)
+#pragma warning ( pop )
+#endif
+
+#endif //_LOG4CXX_HELPERS_EVENT_QUEUE_H
@@ -29,6 +29,8 @@ namespace log4cxx {
    
    typedef std::ios_base& (*ios_base_manip)(std::ios_base&);
 
+   class BraceFormat;
+
    /**
     *   This class is used by the LOG4CXX_INFO and similar
     *   macros to support insertion operators in the message parameter.
@@ -71,6 +73,13 @@ namespace log4cxx {
          *   @return this buffer.
          */
         CharMessageBuffer& operator<<(const char msg);
+        /**
+         *   Appends characters to buffer.
+         *   @param msg characters to append.
+         *   @param len number of characters.
+         *   @return this buffer.
+         */
+        CharMessageBuffer& append(const char* msg, size_t len);
 
         /**
          *   Insertion operator for STL manipulators such as std::fixed.
@@ -78,6 +87,12 @@ namespace log4cxx {
          *   @return encapsulated STL stream.
          */
         std::ostream& operator<<(ios_base_manip manip);
+        /**
+         *   Insertion operator for STL manipulators such as std::endl.
+         *   @param manip manipulator.
+         *   @return encapsulated STL stream.
+         */
+        std::ostream& operator<<(std::ostream& (*manip)(std::ostream&));
         /**
          *   Insertion operator for built-in type.
          *   @param val build in type.
@@ -165,6 +180,14 @@ namespace log4cxx {
          */
         bool hasStream() const;
 
+      /**
+       *   Moves the content of the buffer to a LogString, exchanging
+       *   storage rather than copying when no conversion is required,
+       *   in which case the buffer keeps the storage of dst for reuse.
+       *   @param dst empty string that receives the content.
+       */
+      void extract(LogString& dst);
+
    private:
         /**
          * Prevent use of default copy constructor.
@@ -182,7 +205,7 @@ namespace log4cxx {
         /**
          *  Encapsulated stream, created on demand.
          */
-        std::basic_ostringstream<char>* stream;
+        std::basic_ostream<char>* stream;
    };
 
 template<class V>
@@ -252,6 +275,12 @@ std::basic_ostream<char>& operator<<(CharMessageBuffer& os, const V& val) {
          *   @return encapsulated STL stream.
          */
         uostream& operator<<(ios_base_manip manip);
+        /**
+         *   Insertion operator for STL manipulators such as std::endl.
+         *   @param manip manipulator.
+         *   @return encapsulated STL stream.
+         */
+        uostream& operator<<(uostream& (*manip)(uostream&));
         /**
          *   Insertion operator for built-in type.
          *   @param val build in type.
@@ -340,6 +369,14 @@ std::basic_ostream<char>& operator<<(CharMessageBuffer& os, const V& val) {
          */
         bool hasStream() const;
 
+      /**
+       *   Moves the content of the buffer to a LogString, exchanging
+       *   storage rather than copying when no conversion is required,
+       *   in which case the buffer keeps the storage of dst for reuse.
+       *   @param dst empty string that receives the content.
+       */
+      void extract(LogString& dst);
+
    private:
         /**
          * Prevent use of default copy constructor.
@@ -357,7 +394,7 @@ std::basic_ostream<char>& operator<<(CharMessageBuffer& os, const V& val) {
         /**
          *  Encapsulated stream, created on demand.
          */
-        std::basic_ostringstream<UniChar>* stream;
+        std::basic_ostream<UniChar>* stream;
    };
 
 template<class V>
@@ -409,6 +446,13 @@ UniCharMessageBuffer::uostream& operator<<(UniCharMessageBuffer& os, const V& va
          *   @return this buffer.
          */
         WideMessageBuffer& operator<<(const wchar_t msg);
+        /**
+         *   Appends characters to buffer.
+         *   @param msg characters to append.
+         *   @param len number of characters.
+         *   @return this buffer.
+         */
+        WideMessageBuffer& append(const wchar_t* msg, size_t len);
 
         /**
          *   Insertion operator for STL manipulators such as std::fixed.
@@ -416,6 +460,12 @@ UniCharMessageBuffer::uostream& operator<<(UniCharMessageBuffer& os, const V& va
          *   @return encapsulated STL stream.
          */
         std::basic_ostream<wchar_t>& operator<<(ios_base_manip manip);
+        /**
+         *   Insertion operator for STL manipulators such as std::endl.
+         *   @param manip manipulator.
+         *   @return encapsulated STL stream.
+         */
+        std::basic_ostream<wchar_t>& operator<<(std::basic_ostream<wchar_t>& (*manip)(std::basic_ostream<wchar_t>&));
         /**
          *   Insertion operator for built-in type.
          *   @param val build in type.
@@ -504,6 +554,14 @@ UniCharMessageBuffer::uostream& operator<<(UniCharMessageBuffer& os, const V& va
          */
         bool hasStream() const;
 
+      /**
+       *   Moves the content of the buffer to a LogString, exchanging
+       *   storage rather than copying when no conversion is required,
+       *   in which case the buffer keeps the storage of dst for reuse.
+       *   @param dst empty string that receives the content.
+       */
+      void extract(LogString& dst);
+
    private:
         /**
          * Prevent use of default copy constructor.
@@ -521,7 +579,7 @@ UniCharMessageBuffer::uostream& operator<<(UniCharMessageBuffer& os, const V& va
         /**
          *  Encapsulated stream, created on demand.
          */
-        std::basic_ostringstream<wchar_t>* stream;
+        std::basic_ostream<wchar_t>* stream;
    };
 
 template<class V>
@@ -579,6 +637,14 @@ std::basic_ostream<wchar_t>& operator<<(WideMessageBuffer& os, const V& val) {
          *   @return encapsulated CharMessageBuffer.
          */
         CharMessageBuffer& operator<<(const char msg);
+        /**
+         *   Appends characters into the buffer and
+         *   fixes the buffer to use char characters.
+         *   @param msg characters to append.
+         *   @param len number of characters.
+         *   @return encapsulated CharMessageBuffer.
+         */
+        CharMessageBuffer& append(const char* msg, size_t len);
 
       /**
        *   Get content of buffer.
@@ -624,6 +690,14 @@ std::basic_ostream<wchar_t>& operator<<(WideMessageBuffer& os, const V& val) {
          *   @return encapsulated CharMessageBuffer.
          */
         WideMessageBuffer& operator<<(const wchar_t msg);
+        /**
+         *   Appends characters into the buffer and
+         *   fixes the buffer to use wchar_t characters.
+         *   @param msg characters to append.
+         *   @param len number of characters.
+         *   @return encapsulated WideMessageBuffer.
+         */
+        WideMessageBuffer& append(const wchar_t* msg, size_t len);
 
 #if LOG4CXX_UNICHAR_API || LOG4CXX_CFSTRING_API
       /**
@@ -774,6 +848,14 @@ std::basic_ostream<wchar_t>& operator<<(WideMessageBuffer& os, const V& val) {
          */
         bool hasStream() const;
 
+      /**
+       *   Moves the content of the buffer to a LogString, exchanging
+       *   storage rather than copying when no conversion is required,
+       *   in which case the buffer keeps the storage of dst for reuse.
+       *   @param dst empty string that receives the content.
+       */
+      void extract(LogString& dst);
+
    private:
         /**
          * Prevent use of default copy constructor.
@@ -784,6 +866,8 @@ std::basic_ostream<wchar_t>& operator<<(WideMessageBuffer& os, const V& val) {
          */
         MessageBuffer& operator=(const MessageBuffer&);
 
+        friend class BraceFormat;
+
         /**
          *  Character message buffer.
          */
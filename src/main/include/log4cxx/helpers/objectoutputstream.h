@@ -22,6 +22,7 @@
 #include <log4cxx/mdc.h>
 #include <log4cxx/helpers/outputstream.h>
 #include <log4cxx/helpers/charsetencoder.h>
+#include <log4cxx/helpers/sharedstring.h>
 
 namespace log4cxx
 {
@@ -45,6 +46,12 @@ namespace log4cxx
                   void close(Pool& p);
                   void flush(Pool& p);
                   void writeObject(const LogString&, Pool& p);
+                  /**
+                   *  Writes a string shared by several objects, such as the
+                   *  name of a logger, as a reference to its first occurrence
+                   *  on this stream when it has already been written.
+                   */
+                  void writeObject(const SharedStringPtr&, Pool& p);
                   void writeUTFString(const std::string&, Pool& p);
                   void writeObject(const MDC::Map& mdc, Pool& p);
                   void writeInt(int val, Pool& p);
@@ -83,6 +90,9 @@ namespace log4cxx
                   unsigned int objectHandle;
                   typedef std::map<std::string, unsigned int> ClassDescriptionMap;
                   ClassDescriptionMap* classDescriptions;
+                  typedef std::map<SharedStringPtr, unsigned int> SharedStringMap;
+                  SharedStringMap* sharedStrings;
+                  enum { MAX_SHARED_STRINGS = 1024 };
           };
           
           LOG4CXX_PTR_DEF(ObjectOutputStream);          
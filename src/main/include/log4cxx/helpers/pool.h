@@ -45,6 +45,12 @@ namespace log4cxx
                         char* pstrdup(const char*s);
                         char* pstrdup(const std::string&);
 
+                        /**
+                         *  Gets the number of APR pools created by Pool
+                         *  and Pool::create, for measuring allocations.
+                         */
+                        static unsigned int getCreatedCount();
+
                 protected:
                         apr_pool_t* pool;
                         const bool release;
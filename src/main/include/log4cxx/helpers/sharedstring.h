@@ -0,0 +1,55 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LOG4CXX_HELPERS_SHARED_STRING_H
+#define _LOG4CXX_HELPERS_SHARED_STRING_H
+
+#include <log4cxx/helpers/objectimpl.h>
+#include <log4cxx/logstring.h>
+
+
+namespace log4cxx {
+   namespace helpers {
+      /**
+       *  An immutable, reference counted string, allowing
+       *  logging events to share a thread or logger name without copying it.
+       */
+      class LOG4CXX_EXPORT SharedString : public ObjectImpl {
+          const LogString val;
+      public:
+      DECLARE_LOG4CXX_OBJECT(SharedString)
+      BEGIN_LOG4CXX_CAST_MAP()
+              LOG4CXX_CAST_ENTRY(SharedString)
+      END_LOG4CXX_CAST_MAP()
+
+      SharedString();
+      SharedString(const LogString& val);
+      virtual ~SharedString();
+
+      inline const LogString& getValue() const {
+        return val;
+      }
+
+      };
+
+      LOG4CXX_PTR_DEF(SharedString);
+
+   }
+}
+
+
+#endif
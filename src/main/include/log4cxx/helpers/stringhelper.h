@@ -51,6 +51,33 @@ namespace log4cxx
 
             static void toString(bool val, LogString& dst);
 
+            /**
+             *  Size of a buffer sufficient for any of the format methods.
+             */
+            enum { NUMBER_BUFFER_SIZE = 32 };
+            /**
+             *  Formats an integer as std::ostream does by default.
+             *  @param n number.
+             *  @param buf buffer of at least NUMBER_BUFFER_SIZE characters.
+             *  @return number of characters written, not null terminated.
+             */
+            static size_t formatInteger(log4cxx_int64_t n, char* buf);
+            /**
+             *  Formats an unsigned integer as std::ostream does by default.
+             *  @param n number.
+             *  @param buf buffer of at least NUMBER_BUFFER_SIZE characters.
+             *  @return number of characters written, not null terminated.
+             */
+            static size_t formatUnsigned(log4cxx_uint64_t n, char* buf);
+            /**
+             *  Formats a floating point number as std::ostream does by default,
+             *  that is with six significant digits in the "C" locale.
+             *  @param n number.
+             *  @param buf buffer of at least NUMBER_BUFFER_SIZE characters.
+             *  @return number of characters written, not null terminated.
+             */
+            static size_t formatDouble(double n, char* buf);
+
             static LogString toLowerCase(const LogString& s);
 
             static LogString format(const LogString& pattern, const std::vector<LogString>& params);
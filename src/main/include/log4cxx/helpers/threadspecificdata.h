@@ -20,12 +20,26 @@
 
 #include <log4cxx/ndc.h>
 #include <log4cxx/mdc.h>
+#include <log4cxx/helpers/sharedstring.h>
+#include <vector>
+#include <sstream>
 
 
 namespace log4cxx
 {
+        namespace spi
+        {
+                class LoggingEvent;
+        }
+
         namespace helpers
         {
+                class Pool;
+                class DeferredBuffer;
+                LOG4CXX_PTR_DEF(DeferredBuffer);
+                class EventQueue;
+                LOG4CXX_PTR_DEF(EventQueue);
+
                 /**
                   *   This class contains all the thread-specific
                   *   data in use by log4cxx.
@@ -42,7 +56,11 @@ namespace log4cxx
                          */
                         static ThreadSpecificData* getCurrentData();
                         /**
-                         *  Release this ThreadSpecficData if empty.
+                         *  Release this ThreadSpecficData if empty.  The pool,
+                         *  thread name, event, message buffer and date caches
+                         *  count as content, so the data of a thread that
+                         *  has logged is kept until the thread ends rather
+                         *  than rebuilt after each NDC or MDC is cleared.
                          */
                         void recycle();
                         
@@ -52,13 +70,135 @@ namespace log4cxx
                         
                         log4cxx::NDC::Stack& getStack();
                         log4cxx::MDC::Map& getMap();
+
+                        /**
+                         *  Borrows the calling thread's logging pool.  The pool
+                         *  is cleared, not destroyed, when returned so its memory is
+                         *  reused by the next request on the same thread.
+                         *  @return pool, null if already borrowed by an enclosing
+                         *  request or if it could not be created.
+                         */
+                        static Pool* borrowPool();
+                        /**
+                         *  Clears and returns a pool obtained from borrowPool.
+                         *  @param pool pool to return.
+                         */
+                        static void returnPool(Pool* pool);
+
+                        /**
+                         *  Gets the name of the calling thread, computed
+                         *  once per thread and shared by its logging events.
+                         *  @return thread name.
+                         */
+                        static SharedStringPtr getThreadName();
+                        /**
+                         *  Sets the name used by subsequent logging events
+                         *  from the calling thread.
+                         *  @param name thread name, if empty the thread
+                         *  identifier is used.
+                         */
+                        static void setThreadName(const LogString& name);
+
+                        /**
+                         *  Streams and strings kept for reuse by the message
+                         *  buffers of the calling thread.  A message buffer takes
+                         *  an entry, leaving it empty, and puts it back when done.
+                         */
+                        struct MessageBufferCache {
+                            MessageBufferCache();
+                            ~MessageBufferCache();
+                            bool empty() const;
+
+                            std::basic_ostream<char>* charStream;
+                            std::basic_string<char> charBuffer;
+#if LOG4CXX_WCHAR_T_API
+                            std::basic_ostream<wchar_t>* wideStream;
+                            std::basic_string<wchar_t> wideBuffer;
+#endif
+#if LOG4CXX_UNICHAR_API || LOG4CXX_CFSTRING_API
+                            std::basic_ostream<UniChar>* uniStream;
+                            std::basic_string<UniChar> uniBuffer;
+#endif
+                        private:
+                            MessageBufferCache(const MessageBufferCache&);
+                            MessageBufferCache& operator=(const MessageBufferCache&);
+                        };
+                        /**
+                         *  Gets the calling thread's message buffer cache.
+                         *  @return message buffer cache, may be null.
+                         */
+                        static MessageBufferCache* getMessageBufferCache();
+
+                        typedef std::vector<log4cxx::spi::LoggingEvent*> EventCache;
+                        /**
+                         *  Gets the calling thread's cache of recycled logging events.
+                         *  Cached events are deleted when the thread ends.
+                         *  @return event cache, may be null.
+                         */
+                        static EventCache* getEventCache();
+
+                        /**
+                         *  Gets the calling thread's buffer of deferred logging
+                         *  requests, released when the thread ends.
+                         *  @return buffer slot, may be null.
+                         */
+                        static DeferredBufferPtr* getDeferredBuffer();
+
+                        /**
+                         *  Queues of the calling thread, one for each
+                         *  AsyncAppender with producer queues the thread logged to.
+                         */
+                        typedef std::vector<EventQueuePtr> EventQueueList;
+                        static EventQueueList* getEventQueues();
+
+                        /**
+                         *  Last time formatted by a CachedDateFormat on the
+                         *  calling thread.
+                         */
+                        struct DateCacheEntry {
+                            DateCacheEntry();
+                            /**
+                             *  Identifier of the format, 0 if unused.
+                             */
+                            unsigned int formatId;
+                            /**
+                             *  Value of the thread's use counter when last returned.
+                             */
+                            unsigned int lastUse;
+                            int millisecondStart;
+                            log4cxx_time_t slotBegin;
+                            log4cxx_time_t previousTime;
+                            LogString cache;
+                        };
+                        enum { DATE_CACHE_SIZE = 8 };
+                        /**
+                         *  Gets the calling thread's entry for a CachedDateFormat.
+                         *  Any entry may hold any format, the least recently
+                         *  used entry is given to a format without one.
+                         *  @param formatId identifier of the format, not 0.
+                         *  @return entry, holding another format if its formatId
+                         *  differs, may be null.
+                         */
+                        static DateCacheEntry* getDateCache(unsigned int formatId);
                         
 
                 private:
                         static ThreadSpecificData& getDataNoThreads();
                         static ThreadSpecificData* createCurrentData();
+                        static Pool* createPool();
+                        static LogString createThreadName();
+                        bool isDateCacheUnused() const;
                         log4cxx::NDC::Stack ndcStack;
                         log4cxx::MDC::Map mdcMap;
+                        Pool* pool;
+                        bool poolBorrowed;
+                        EventCache events;
+                        SharedStringPtr threadName;
+                        MessageBufferCache messageBuffers;
+                        DeferredBufferPtr deferredBuffer;
+                        EventQueueList eventQueues;
+                        DateCacheEntry dateCache[DATE_CACHE_SIZE];
+                        unsigned int dateCacheUses;
                 };
 
         }  // namespace helpers
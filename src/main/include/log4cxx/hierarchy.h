@@ -59,25 +59,48 @@ namespace log4cxx
         private:
             log4cxx::helpers::Pool pool;
             log4cxx::helpers::Mutex mutex;
-            bool configured;
+
+            /**
+            Non-zero once the hierarchy has been configured or automatic
+            configuration has been attempted.  Read without locking.
+            */
+            mutable unsigned int volatile configured;
 
             spi::LoggerFactoryPtr defaultFactory;
             spi::HierarchyEventListenerList listeners;
 
-            typedef std::map<LogString, LoggerPtr> LoggerMap;
-            LoggerMap* loggers;
+            /**
+            Node for a logger name and each of its ancestor names, linked
+            to the nodes of its parent name and child names.  A node without
+            a logger stands in for a logger that has not been created yet,
+            like a provision node.
+            */
+            class LoggerNode;
 
-            typedef std::map<LogString, ProvisionNode> ProvisionNodeMap;
-            ProvisionNodeMap* provisionNodes;
+            /**
+            Hash index of the nodes by name that getLogger and exists
+            search without locking.  Updated while holding <code>mutex</code>.
+            */
+            class LoggerIndex;
+            LoggerIndex* index;
 
             LoggerPtr root;
 
-            int thresholdInt;
+            /**
+            Integer value of <code>threshold</code>, read without locking.
+            */
+            mutable unsigned int volatile thresholdInt;
             LevelPtr threshold;
 
-            bool emittedNoAppenderWarning;
+            unsigned int volatile emittedNoAppenderWarning;
             bool emittedNoResourceBundleWarning;
 
+            /**
+            Incremented on every change that may alter the effective
+            level of a logger, invalidating the level cached by each Logger.
+            */
+            unsigned int volatile generation;
+
         public:
             DECLARE_ABSTRACT_LOG4CXX_OBJECT(Hierarchy)
             BEGIN_LOG4CXX_CAST_MAP()
@@ -99,7 +122,9 @@ namespace log4cxx
             /**
             This call will clear all logger definitions from the internal
             hashtable. Invoking this method will irrevocably mess up the
-            logger hierarchy.
+            logger hierarchy.  The cleared loggers stay referenced until
+            the hierarchy is destroyed since concurrent lookups may
+            still reach them.
 
             <p>You should <em>really</em> know what you are doing before
             invoking this method.
@@ -232,45 +257,27 @@ namespace log4cxx
         private:
 
             /**
-            This method loops through all the *potential* parents of
-            'cat'. There 3 possible cases:
-
-            1) No entry for the potential parent of 'cat' exists
-
-            We create a ProvisionNode for this potential parent and insert
-            'cat' in that provision node.
-
-            2) There entry is of type Logger for the potential parent.
-
-            The entry is 'cat's nearest existing parent. We update cat's
-            parent field with this entry. We also break from the loop
-            because updating our parent's parent is our parent's
-            responsibility.
-
-            3) There entry is of type ProvisionNode for this potential parent.
-
-            We add 'cat' to the list of children for this potential parent.
+            Walks up the names from the node of 'cat' to the first node
+            holding a logger, which is 'cat's nearest existing parent.
+            If there is none, 'cat's parent is the root logger.
             */
-            void updateParents(LoggerPtr logger);
+            void updateParents(LoggerNode* node, const LoggerPtr& logger);
 
             /**
-            We update the links for all the children that placed themselves
-            in the provision node 'pn'. The second argument 'cat' is a
-            reference for the newly created Logger, parent of all the
-            children in 'pn'
-
-            We loop on all the children 'c' in 'pn':
-
-            If the child 'c' has been already linked to a child of
-            'cat' then there is no need to update 'c'.
-
-            Otherwise, we set cat's parent field to c's parent and set
-            c's parent field to cat.
+            Walks down the names from the node of 'cat', the newly created
+            logger.  The first logger found on each branch had 'cat's
+            parent as its parent and now becomes a child of 'cat'.
+            Loggers below it are already linked to a closer parent.
             */
+            void updateChildren(LoggerNode* node, const LoggerPtr& logger);
+
             Hierarchy(const Hierarchy&);
             Hierarchy& operator=(const Hierarchy&);
 
-            void updateChildren(ProvisionNode& pn, LoggerPtr logger);
+            /**
+            Invalidate the effective levels cached by all loggers.
+            */
+            void updateGeneration();
         };
 
 }  //namespace log4cxx
@@ -26,10 +26,14 @@
 #include <log4cxx/helpers/appenderattachableimpl.h>
 #include <log4cxx/level.h>
 #include <log4cxx/helpers/pool.h>
+#include <log4cxx/helpers/sharedstring.h>
 #include <log4cxx/helpers/mutex.h>
 #include <log4cxx/spi/location/locationinfo.h>
+#include <log4cxx/spi/callsite.h>
+#include <log4cxx/spi/eventfields.h>
 #include <log4cxx/helpers/resourcebundle.h>
 #include <log4cxx/helpers/messagebuffer.h>
+#include <log4cxx/helpers/braceformat.h>
 
 
 namespace log4cxx
@@ -37,6 +41,7 @@ namespace log4cxx
 
     namespace helpers {
             class synchronized;
+            class DeferredLog;
     }
     
     namespace spi {
@@ -44,6 +49,7 @@ namespace log4cxx
         LOG4CXX_PTR_DEF(LoggerRepository);
         class LoggerFactory;
         LOG4CXX_PTR_DEF(LoggerFactory);
+        class CallSiteRegistry;
     }
 
     class Logger;
@@ -100,6 +106,11 @@ namespace log4cxx
         // Loggers need to know what Hierarchy they are in
         log4cxx::spi::LoggerRepository * repository;
 
+        /**
+        Appenders attached to this logger.  Treated as an immutable
+        snapshot: changes build a new instance and swap it in while
+        holding <code>mutex</code>, callAppenders reads it without locking.
+        */
         helpers::AppenderAttachableImplPtr aai;
 
                 /** Additivity is set to true by default, that is children inherit
@@ -589,6 +600,110 @@ namespace log4cxx
         void forcedLogLS(const LevelPtr& level, const LogString& message,
                         const log4cxx::spi::LocationInfo& location) const;
 
+        /**
+        This method creates a new logging event and logs the event
+        without further checks, taking over the content of the message
+        buffer rather than copying it.  Used by the LOG4CXX_* macros.
+        Without the wide API, MessageBuffer is CharMessageBuffer.
+        @param level the level to log.
+        @param message message buffer, left with unspecified content.
+        @param location location of the logging statement.
+        */
+        void forcedLog(const LevelPtr& level, helpers::MessageBuffer& message,
+                        const log4cxx::spi::LocationInfo& location) const;
+#if LOG4CXX_WCHAR_T_API
+        /**
+        This method creates a new logging event and logs the event
+        without further checks, taking over the content of the message
+        buffer rather than copying it.  Used by the LOG4CXX_* macros.
+        @param level the level to log.
+        @param message message buffer, left with unspecified content.
+        @param location location of the logging statement.
+        */
+        void forcedLog(const LevelPtr& level, helpers::CharMessageBuffer& message,
+                        const log4cxx::spi::LocationInfo& location) const;
+        /**
+        This method creates a new logging event and logs the event
+        without further checks, taking over the content of the message
+        buffer rather than copying it.  Used by the LOG4CXX_* macros.
+        @param level the level to log.
+        @param message message buffer, left with unspecified content.
+        @param location location of the logging statement.
+        */
+        void forcedLog(const LevelPtr& level, helpers::WideMessageBuffer& message,
+                        const log4cxx::spi::LocationInfo& location) const;
+#endif
+#if LOG4CXX_UNICHAR_API || LOG4CXX_CFSTRING_API || LOG4CXX_LOGCHAR_IS_UNICHAR
+        /**
+        This method creates a new logging event and logs the event
+        without further checks, taking over the content of the message
+        buffer rather than copying it.  Used by the LOG4CXX_* macros.
+        @param level the level to log.
+        @param message message buffer, left with unspecified content.
+        @param location location of the logging statement.
+        */
+        void forcedLog(const LevelPtr& level, helpers::UniCharMessageBuffer& message,
+                        const log4cxx::spi::LocationInfo& location) const;
+#endif
+
+        /**
+        This method creates a new logging event with typed fields
+        and logs the event without further checks, taking over the
+        content of the message buffer and the fields.  Used by the
+        LOG4CXX_*_FIELDS macros.
+        Without the wide API, MessageBuffer is CharMessageBuffer.
+        @param level the level to log.
+        @param message message buffer, left with unspecified content.
+        @param fields fields of the event, left with unspecified content.
+        @param location location of the logging statement.
+        */
+        void forcedLog(const LevelPtr& level, helpers::MessageBuffer& message,
+                        spi::EventFields& fields,
+                        const log4cxx::spi::LocationInfo& location) const;
+#if LOG4CXX_WCHAR_T_API
+        /**
+        This method creates a new logging event with typed fields
+        and logs the event without further checks, taking over the
+        content of the message buffer and the fields.  Used by the
+        LOG4CXX_*_FIELDS macros.
+        @param level the level to log.
+        @param message message buffer, left with unspecified content.
+        @param fields fields of the event, left with unspecified content.
+        @param location location of the logging statement.
+        */
+        void forcedLog(const LevelPtr& level, helpers::CharMessageBuffer& message,
+                        spi::EventFields& fields,
+                        const log4cxx::spi::LocationInfo& location) const;
+        /**
+        This method creates a new logging event with typed fields
+        and logs the event without further checks, taking over the
+        content of the message buffer and the fields.  Used by the
+        LOG4CXX_*_FIELDS macros.
+        @param level the level to log.
+        @param message message buffer, left with unspecified content.
+        @param fields fields of the event, left with unspecified content.
+        @param location location of the logging statement.
+        */
+        void forcedLog(const LevelPtr& level, helpers::WideMessageBuffer& message,
+                        spi::EventFields& fields,
+                        const log4cxx::spi::LocationInfo& location) const;
+#endif
+#if LOG4CXX_UNICHAR_API || LOG4CXX_CFSTRING_API || LOG4CXX_LOGCHAR_IS_UNICHAR
+        /**
+        This method creates a new logging event with typed fields
+        and logs the event without further checks, taking over the
+        content of the message buffer and the fields.  Used by the
+        LOG4CXX_*_FIELDS macros.
+        @param level the level to log.
+        @param message message buffer, left with unspecified content.
+        @param fields fields of the event, left with unspecified content.
+        @param location location of the logging statement.
+        */
+        void forcedLog(const LevelPtr& level, helpers::UniCharMessageBuffer& message,
+                        spi::EventFields& fields,
+                        const log4cxx::spi::LocationInfo& location) const;
+#endif
+
         /**
         Get the additivity flag for this Logger instance.
         */
@@ -980,6 +1095,26 @@ namespace log4cxx
         */
         bool isEnabledFor(const LevelPtr& level) const;
 
+        /**
+        Check whether a request of a given level made at a call site
+        is enabled, using the decision cached by the call site while the
+        configuration generation is unchanged.  Used by the logging macros.
+
+        @param site call site of the request.
+        @param level integer value of the level of the request.
+        @return bool True if the request is enabled.
+        */
+        inline bool isEnabledAt(spi::CallSite& site, int level) const
+        {
+                unsigned int state = site.state;
+                if (site.logger == this &&
+                    (state >> 1) == (configurationGeneration & 0x7FFFFFFF))
+                {
+                        return (state & 1) != 0;
+                }
+                return updateCallSite(site, level);
+        }
+
 
         /**
         Check whether this logger is enabled for the info Level.
@@ -1716,6 +1851,103 @@ namespace log4cxx
         Logger& operator=(const Logger&);
         log4cxx::helpers::Mutex mutex;
         friend class log4cxx::helpers::synchronized;
+
+        /**
+        Configuration generation of the owning Hierarchy, null
+        if the repository does not maintain one.  Set by Hierarchy.
+        */
+        unsigned int volatile* generation;
+
+        /**
+        Value of <code>*generation</code> when
+        <code>enabledLevelInt</code> was last computed, 0 if never
+        or while <code>enabledLevelInt</code> is being replaced.
+        */
+        mutable unsigned int volatile enabledGeneration;
+
+        /**
+        Lowest level that passes both the repository threshold
+        and the effective level of this logger.
+        */
+        mutable int volatile enabledLevelInt;
+
+        /**
+        Check level against the cached effective level,
+        recomputing it if the hierarchy has changed.
+        */
+        bool isEnabled(int level) const;
+        bool updateEnabledLevel(int level) const;
+
+        /**
+        Appenders reached by events logged to this logger, resolved
+        over the ancestors honoring additivity and without duplicates.
+        Immutable like <code>aai</code>, null if there are none.
+        */
+        mutable helpers::AppenderAttachableImplPtr route;
+
+        /**
+        Value of <code>*generation</code> when <code>route</code>
+        was last resolved, 0 if never or while <code>route</code>
+        is being replaced.
+        */
+        mutable unsigned int volatile routeGeneration;
+
+        /**
+        Snapshots replaced in <code>aai</code> or <code>route</code>, kept
+        until the logger is destroyed since readers may have read one
+        without having referenced it yet.  Guarded by <code>mutex</code>.
+        */
+        mutable std::vector<helpers::AppenderAttachableImplPtr> retiredAppenders;
+
+        /**
+        Copy of <code>name</code> shared by the events logged
+        to this logger.
+        */
+        helpers::SharedStringPtr sharedName;
+
+        /**
+        Get a reference to a snapshot without locking.
+        */
+        helpers::AppenderAttachableImplPtr getAppenderSnapshot(
+                const helpers::AppenderAttachableImplPtr& slot) const;
+
+        /**
+        Replace a snapshot, caller must hold <code>mutex</code>.
+        */
+        void setAppenderSnapshot(helpers::AppenderAttachableImplPtr& slot,
+                const helpers::AppenderAttachableImplPtr& snapshot) const;
+
+        /**
+        Get the route, resolving it again if the hierarchy has changed.
+        */
+        helpers::AppenderAttachableImplPtr getRoute() const;
+        helpers::AppenderAttachableImplPtr updateRoute() const;
+
+        /**
+        Collect the appenders of this logger and its ancestors.
+        */
+        AppenderList resolveAppenders() const;
+
+        /**
+        Invalidate cached levels and routes of the hierarchy.
+        */
+        void updateGeneration();
+
+        /**
+        Incremented with the generation of any Hierarchy, invalidating
+        the decisions cached by every call site.
+        */
+        static unsigned int volatile configurationGeneration;
+        friend class spi::CallSiteRegistry;
+        friend class helpers::DeferredLog;
+
+        bool updateCallSite(spi::CallSite& site, int level) const;
+
+        /**
+        Create a new snapshot holding the appenders of src.
+        */
+        static helpers::AppenderAttachableImplPtr copyAppenders(
+                const helpers::AppenderAttachableImplPtr& src, helpers::Pool& p);
    };
    LOG4CXX_LIST_DEF(LoggerList, LoggerPtr);
    
@@ -1745,6 +1977,19 @@ to optimize for the expression being false.
 #endif
 #endif
 
+#if !defined(LOG4CXX_HAS_VARIADIC_MACROS)
+#if __cplusplus >= 201103L || defined(__GNUC__) || (defined(_MSC_VER) && _MSC_VER >= 1400)
+/**
+Non-zero if the compiler accepts macros with a variable number
+of arguments, which LOG4CXX_INFO_FMT and similar macros require
+but C++98 does not provide.
+*/
+#define LOG4CXX_HAS_VARIADIC_MACROS 1
+#else
+#define LOG4CXX_HAS_VARIADIC_MACROS 0
+#endif
+#endif
+
 
 /**
 Logs a message to a specified logger with a specified level.
@@ -1756,7 +2001,8 @@ Logs a message to a specified logger with a specified level.
 #define LOG4CXX_LOG(logger, level, message) do { \
         if (logger->isEnabledFor(level)) {\
            ::log4cxx::helpers::MessageBuffer oss_; \
-           logger->forcedLog(level, oss_.str(oss_ << message), LOG4CXX_LOCATION); } } while (0)
+           oss_ << message; \
+           logger->forcedLog(level, oss_, LOG4CXX_LOCATION); } } while (0)
 
 /**
 Logs a message to a specified logger with a specified level.
@@ -1768,7 +2014,42 @@ Logs a message to a specified logger with a specified level.
 #define LOG4CXX_LOGLS(logger, level, message) do { \
         if (logger->isEnabledFor(level)) {\
            ::log4cxx::helpers::LogCharMessageBuffer oss_; \
-           logger->forcedLog(level, oss_.str(oss_ << message), LOG4CXX_LOCATION); } } while (0)
+           oss_ << message; \
+           logger->forcedLog(level, oss_, LOG4CXX_LOCATION); } } while (0)
+
+#if LOG4CXX_HAS_VARIADIC_MACROS
+/**
+Logs a message to a specified logger with a specified level,
+replacing each "{}" in the pattern by the next argument.
+The arguments are formatted only if the level is enabled.
+
+@param logger the logger to be used.
+@param level the level to log.
+@param ... the pattern, for example "user={} took {}ms",
+followed by up to eight arguments.
+*/
+#define LOG4CXX_LOG_FMT(logger, level, ...) do { \
+        if (logger->isEnabledFor(level)) {\
+           ::log4cxx::helpers::MessageBuffer oss_; \
+           logger->forcedLog(level, \
+              ::log4cxx::helpers::braceFormat(oss_, __VA_ARGS__), LOG4CXX_LOCATION); } } while (0)
+#endif
+
+/**
+Logs a message with typed fields to a specified logger with a specified level.
+The fields are evaluated only if the level is enabled.
+
+@param logger the logger to be used.
+@param level the level to log.
+@param message the message string to log.
+@param fields fields of the event, taken over by the event, for example
+<code>::log4cxx::spi::EventFields().add(LOG4CXX_STR("status"), 200)</code>.
+*/
+#define LOG4CXX_LOG_FIELDS(logger, level, message, fields) do { \
+        if (logger->isEnabledFor(level)) {\
+           ::log4cxx::helpers::MessageBuffer oss_; \
+           oss_ << message; \
+           logger->forcedLog(level, oss_, fields, LOG4CXX_LOCATION); } } while (0)
 
 #if !defined(LOG4CXX_THRESHOLD) || LOG4CXX_THRESHOLD <= 10000 
 /**
@@ -1778,11 +2059,67 @@ Logs a message to a specified logger with the DEBUG level.
 @param message the message string to log.
 */
 #define LOG4CXX_DEBUG(logger, message) do { \
-        if (LOG4CXX_UNLIKELY(logger->isDebugEnabled())) {\
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (LOG4CXX_UNLIKELY(logger->isEnabledAt(site_, ::log4cxx::Level::DEBUG_INT))) {\
+           ::log4cxx::helpers::MessageBuffer oss_; \
+           oss_ << message; \
+           logger->forcedLog(::log4cxx::Level::getDebug(), oss_, LOG4CXX_LOCATION); } } while (0)
+
+#if LOG4CXX_HAS_VARIADIC_MACROS
+/**
+Logs a message to a specified logger with the DEBUG level,
+replacing each "{}" in the pattern by the next argument.
+The arguments are formatted only if the level is enabled.
+
+@param logger the logger to be used.
+@param ... the pattern, for example "user={} took {}ms",
+followed by up to eight arguments.
+*/
+#define LOG4CXX_DEBUG_FMT(logger, ...) do { \
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (LOG4CXX_UNLIKELY(logger->isEnabledAt(site_, ::log4cxx::Level::DEBUG_INT))) {\
            ::log4cxx::helpers::MessageBuffer oss_; \
-           logger->forcedLog(::log4cxx::Level::getDebug(), oss_.str(oss_ << message), LOG4CXX_LOCATION); } } while (0)
+           logger->forcedLog(::log4cxx::Level::getDebug(), \
+              ::log4cxx::helpers::braceFormat(oss_, __VA_ARGS__), LOG4CXX_LOCATION); } } while (0)
+
+/**
+Records a message for the specified logger with the DEBUG level
+to be formatted and appended by a background thread.
+The call copies the pattern and the arguments, which are limited
+to numbers, characters and strings.
+
+@param logger the logger to be used.
+@param ... the pattern, for example "user={} took {}ms",
+followed by up to eight arguments.
+*/
+#define LOG4CXX_DEBUG_DEFERRED(logger, ...) do { \
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (LOG4CXX_UNLIKELY(logger->isEnabledAt(site_, ::log4cxx::Level::DEBUG_INT))) {\
+           ::log4cxx::helpers::deferredLog(logger, ::log4cxx::Level::DEBUG_INT, site_, __VA_ARGS__); } } while (0)
+#endif
+
+/**
+Logs a message with typed fields to a specified logger with the DEBUG level.
+The fields are evaluated only if the level is enabled.
+
+@param logger the logger to be used.
+@param message the message string to log.
+@param fields fields of the event, taken over by the event, for example
+<code>::log4cxx::spi::EventFields().add(LOG4CXX_STR("status"), 200)</code>.
+*/
+#define LOG4CXX_DEBUG_FIELDS(logger, message, fields) do { \
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (LOG4CXX_UNLIKELY(logger->isEnabledAt(site_, ::log4cxx::Level::DEBUG_INT))) {\
+           ::log4cxx::helpers::MessageBuffer oss_; \
+           oss_ << message; \
+           logger->forcedLog(::log4cxx::Level::getDebug(), oss_, fields, LOG4CXX_LOCATION); } } while (0)
 #else
 #define LOG4CXX_DEBUG(logger, message)
+#if LOG4CXX_HAS_VARIADIC_MACROS
+#define LOG4CXX_DEBUG_FMT(logger, ...)
+#define LOG4CXX_DEBUG_DEFERRED(logger, ...)
+#endif
+#define LOG4CXX_DEBUG_FIELDS(logger, message, fields)
 #endif
 
 #if !defined(LOG4CXX_THRESHOLD) || LOG4CXX_THRESHOLD <= 5000 
@@ -1793,11 +2130,67 @@ Logs a message to a specified logger with the TRACE level.
 @param message the message string to log.
 */
 #define LOG4CXX_TRACE(logger, message) do { \
-        if (LOG4CXX_UNLIKELY(logger->isTraceEnabled())) {\
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (LOG4CXX_UNLIKELY(logger->isEnabledAt(site_, ::log4cxx::Level::TRACE_INT))) {\
+           ::log4cxx::helpers::MessageBuffer oss_; \
+           oss_ << message; \
+           logger->forcedLog(::log4cxx::Level::getTrace(), oss_, LOG4CXX_LOCATION); } } while (0)
+
+#if LOG4CXX_HAS_VARIADIC_MACROS
+/**
+Logs a message to a specified logger with the TRACE level,
+replacing each "{}" in the pattern by the next argument.
+The arguments are formatted only if the level is enabled.
+
+@param logger the logger to be used.
+@param ... the pattern, for example "user={} took {}ms",
+followed by up to eight arguments.
+*/
+#define LOG4CXX_TRACE_FMT(logger, ...) do { \
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (LOG4CXX_UNLIKELY(logger->isEnabledAt(site_, ::log4cxx::Level::TRACE_INT))) {\
+           ::log4cxx::helpers::MessageBuffer oss_; \
+           logger->forcedLog(::log4cxx::Level::getTrace(), \
+              ::log4cxx::helpers::braceFormat(oss_, __VA_ARGS__), LOG4CXX_LOCATION); } } while (0)
+
+/**
+Records a message for the specified logger with the TRACE level
+to be formatted and appended by a background thread.
+The call copies the pattern and the arguments, which are limited
+to numbers, characters and strings.
+
+@param logger the logger to be used.
+@param ... the pattern, for example "user={} took {}ms",
+followed by up to eight arguments.
+*/
+#define LOG4CXX_TRACE_DEFERRED(logger, ...) do { \
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (LOG4CXX_UNLIKELY(logger->isEnabledAt(site_, ::log4cxx::Level::TRACE_INT))) {\
+           ::log4cxx::helpers::deferredLog(logger, ::log4cxx::Level::TRACE_INT, site_, __VA_ARGS__); } } while (0)
+#endif
+
+/**
+Logs a message with typed fields to a specified logger with the TRACE level.
+The fields are evaluated only if the level is enabled.
+
+@param logger the logger to be used.
+@param message the message string to log.
+@param fields fields of the event, taken over by the event, for example
+<code>::log4cxx::spi::EventFields().add(LOG4CXX_STR("status"), 200)</code>.
+*/
+#define LOG4CXX_TRACE_FIELDS(logger, message, fields) do { \
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (LOG4CXX_UNLIKELY(logger->isEnabledAt(site_, ::log4cxx::Level::TRACE_INT))) {\
            ::log4cxx::helpers::MessageBuffer oss_; \
-           logger->forcedLog(::log4cxx::Level::getTrace(), oss_.str(oss_ << message), LOG4CXX_LOCATION); } } while (0)
+           oss_ << message; \
+           logger->forcedLog(::log4cxx::Level::getTrace(), oss_, fields, LOG4CXX_LOCATION); } } while (0)
 #else
 #define LOG4CXX_TRACE(logger, message)
+#if LOG4CXX_HAS_VARIADIC_MACROS
+#define LOG4CXX_TRACE_FMT(logger, ...)
+#define LOG4CXX_TRACE_DEFERRED(logger, ...)
+#endif
+#define LOG4CXX_TRACE_FIELDS(logger, message, fields)
 #endif
 
 #if !defined(LOG4CXX_THRESHOLD) || LOG4CXX_THRESHOLD <= 20000 
@@ -1808,11 +2201,67 @@ Logs a message to a specified logger with the INFO level.
 @param message the message string to log.
 */
 #define LOG4CXX_INFO(logger, message) do { \
-        if (logger->isInfoEnabled()) {\
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (logger->isEnabledAt(site_, ::log4cxx::Level::INFO_INT)) {\
+           ::log4cxx::helpers::MessageBuffer oss_; \
+           oss_ << message; \
+           logger->forcedLog(::log4cxx::Level::getInfo(), oss_, LOG4CXX_LOCATION); } } while (0)
+
+#if LOG4CXX_HAS_VARIADIC_MACROS
+/**
+Logs a message to a specified logger with the INFO level,
+replacing each "{}" in the pattern by the next argument.
+The arguments are formatted only if the level is enabled.
+
+@param logger the logger to be used.
+@param ... the pattern, for example "user={} took {}ms",
+followed by up to eight arguments.
+*/
+#define LOG4CXX_INFO_FMT(logger, ...) do { \
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (logger->isEnabledAt(site_, ::log4cxx::Level::INFO_INT)) {\
+           ::log4cxx::helpers::MessageBuffer oss_; \
+           logger->forcedLog(::log4cxx::Level::getInfo(), \
+              ::log4cxx::helpers::braceFormat(oss_, __VA_ARGS__), LOG4CXX_LOCATION); } } while (0)
+
+/**
+Records a message for the specified logger with the INFO level
+to be formatted and appended by a background thread.
+The call copies the pattern and the arguments, which are limited
+to numbers, characters and strings.
+
+@param logger the logger to be used.
+@param ... the pattern, for example "user={} took {}ms",
+followed by up to eight arguments.
+*/
+#define LOG4CXX_INFO_DEFERRED(logger, ...) do { \
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (logger->isEnabledAt(site_, ::log4cxx::Level::INFO_INT)) {\
+           ::log4cxx::helpers::deferredLog(logger, ::log4cxx::Level::INFO_INT, site_, __VA_ARGS__); } } while (0)
+#endif
+
+/**
+Logs a message with typed fields to a specified logger with the INFO level.
+The fields are evaluated only if the level is enabled.
+
+@param logger the logger to be used.
+@param message the message string to log.
+@param fields fields of the event, taken over by the event, for example
+<code>::log4cxx::spi::EventFields().add(LOG4CXX_STR("status"), 200)</code>.
+*/
+#define LOG4CXX_INFO_FIELDS(logger, message, fields) do { \
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (logger->isEnabledAt(site_, ::log4cxx::Level::INFO_INT)) {\
            ::log4cxx::helpers::MessageBuffer oss_; \
-           logger->forcedLog(::log4cxx::Level::getInfo(), oss_.str(oss_ << message), LOG4CXX_LOCATION); } } while (0)
+           oss_ << message; \
+           logger->forcedLog(::log4cxx::Level::getInfo(), oss_, fields, LOG4CXX_LOCATION); } } while (0)
 #else
 #define LOG4CXX_INFO(logger, message)
+#if LOG4CXX_HAS_VARIADIC_MACROS
+#define LOG4CXX_INFO_FMT(logger, ...)
+#define LOG4CXX_INFO_DEFERRED(logger, ...)
+#endif
+#define LOG4CXX_INFO_FIELDS(logger, message, fields)
 #endif
 
 #if !defined(LOG4CXX_THRESHOLD) || LOG4CXX_THRESHOLD <= 30000 
@@ -1823,11 +2272,67 @@ Logs a message to a specified logger with the WARN level.
 @param message the message string to log.
 */
 #define LOG4CXX_WARN(logger, message) do { \
-        if (logger->isWarnEnabled()) {\
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (logger->isEnabledAt(site_, ::log4cxx::Level::WARN_INT)) {\
+           ::log4cxx::helpers::MessageBuffer oss_; \
+           oss_ << message; \
+           logger->forcedLog(::log4cxx::Level::getWarn(), oss_, LOG4CXX_LOCATION); } } while (0)
+
+#if LOG4CXX_HAS_VARIADIC_MACROS
+/**
+Logs a message to a specified logger with the WARN level,
+replacing each "{}" in the pattern by the next argument.
+The arguments are formatted only if the level is enabled.
+
+@param logger the logger to be used.
+@param ... the pattern, for example "user={} took {}ms",
+followed by up to eight arguments.
+*/
+#define LOG4CXX_WARN_FMT(logger, ...) do { \
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (logger->isEnabledAt(site_, ::log4cxx::Level::WARN_INT)) {\
            ::log4cxx::helpers::MessageBuffer oss_; \
-           logger->forcedLog(::log4cxx::Level::getWarn(), oss_.str(oss_ << message), LOG4CXX_LOCATION); } } while (0)
+           logger->forcedLog(::log4cxx::Level::getWarn(), \
+              ::log4cxx::helpers::braceFormat(oss_, __VA_ARGS__), LOG4CXX_LOCATION); } } while (0)
+
+/**
+Records a message for the specified logger with the WARN level
+to be formatted and appended by a background thread.
+The call copies the pattern and the arguments, which are limited
+to numbers, characters and strings.
+
+@param logger the logger to be used.
+@param ... the pattern, for example "user={} took {}ms",
+followed by up to eight arguments.
+*/
+#define LOG4CXX_WARN_DEFERRED(logger, ...) do { \
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (logger->isEnabledAt(site_, ::log4cxx::Level::WARN_INT)) {\
+           ::log4cxx::helpers::deferredLog(logger, ::log4cxx::Level::WARN_INT, site_, __VA_ARGS__); } } while (0)
+#endif
+
+/**
+Logs a message with typed fields to a specified logger with the WARN level.
+The fields are evaluated only if the level is enabled.
+
+@param logger the logger to be used.
+@param message the message string to log.
+@param fields fields of the event, taken over by the event, for example
+<code>::log4cxx::spi::EventFields().add(LOG4CXX_STR("status"), 200)</code>.
+*/
+#define LOG4CXX_WARN_FIELDS(logger, message, fields) do { \
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (logger->isEnabledAt(site_, ::log4cxx::Level::WARN_INT)) {\
+           ::log4cxx::helpers::MessageBuffer oss_; \
+           oss_ << message; \
+           logger->forcedLog(::log4cxx::Level::getWarn(), oss_, fields, LOG4CXX_LOCATION); } } while (0)
 #else
 #define LOG4CXX_WARN(logger, message)
+#if LOG4CXX_HAS_VARIADIC_MACROS
+#define LOG4CXX_WARN_FMT(logger, ...)
+#define LOG4CXX_WARN_DEFERRED(logger, ...)
+#endif
+#define LOG4CXX_WARN_FIELDS(logger, message, fields)
 #endif
 
 #if !defined(LOG4CXX_THRESHOLD) || LOG4CXX_THRESHOLD <= 40000 
@@ -1838,9 +2343,60 @@ Logs a message to a specified logger with the ERROR level.
 @param message the message string to log.
 */
 #define LOG4CXX_ERROR(logger, message) do { \
-        if (logger->isErrorEnabled()) {\
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (logger->isEnabledAt(site_, ::log4cxx::Level::ERROR_INT)) {\
+           ::log4cxx::helpers::MessageBuffer oss_; \
+           oss_ << message; \
+           logger->forcedLog(::log4cxx::Level::getError(), oss_, LOG4CXX_LOCATION); } } while (0)
+
+#if LOG4CXX_HAS_VARIADIC_MACROS
+/**
+Logs a message to a specified logger with the ERROR level,
+replacing each "{}" in the pattern by the next argument.
+The arguments are formatted only if the level is enabled.
+
+@param logger the logger to be used.
+@param ... the pattern, for example "user={} took {}ms",
+followed by up to eight arguments.
+*/
+#define LOG4CXX_ERROR_FMT(logger, ...) do { \
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (logger->isEnabledAt(site_, ::log4cxx::Level::ERROR_INT)) {\
+           ::log4cxx::helpers::MessageBuffer oss_; \
+           logger->forcedLog(::log4cxx::Level::getError(), \
+              ::log4cxx::helpers::braceFormat(oss_, __VA_ARGS__), LOG4CXX_LOCATION); } } while (0)
+
+/**
+Records a message for the specified logger with the ERROR level
+to be formatted and appended by a background thread.
+The call copies the pattern and the arguments, which are limited
+to numbers, characters and strings.
+
+@param logger the logger to be used.
+@param ... the pattern, for example "user={} took {}ms",
+followed by up to eight arguments.
+*/
+#define LOG4CXX_ERROR_DEFERRED(logger, ...) do { \
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (logger->isEnabledAt(site_, ::log4cxx::Level::ERROR_INT)) {\
+           ::log4cxx::helpers::deferredLog(logger, ::log4cxx::Level::ERROR_INT, site_, __VA_ARGS__); } } while (0)
+#endif
+
+/**
+Logs a message with typed fields to a specified logger with the ERROR level.
+The fields are evaluated only if the level is enabled.
+
+@param logger the logger to be used.
+@param message the message string to log.
+@param fields fields of the event, taken over by the event, for example
+<code>::log4cxx::spi::EventFields().add(LOG4CXX_STR("status"), 200)</code>.
+*/
+#define LOG4CXX_ERROR_FIELDS(logger, message, fields) do { \
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (logger->isEnabledAt(site_, ::log4cxx::Level::ERROR_INT)) {\
            ::log4cxx::helpers::MessageBuffer oss_; \
-           logger->forcedLog(::log4cxx::Level::getError(), oss_.str(oss_ << message), LOG4CXX_LOCATION); } while (0)
+           oss_ << message; \
+           logger->forcedLog(::log4cxx::Level::getError(), oss_, fields, LOG4CXX_LOCATION); } } while (0)
 
 /**
 Logs a error if the condition is not true.
@@ -1850,12 +2406,19 @@ Logs a error if the condition is not true.
 @param message the message string to log.
 */
 #define LOG4CXX_ASSERT(logger, condition, message) do { \
-        if (!(condition) && logger->isErrorEnabled()) {\
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (!(condition) && logger->isEnabledAt(site_, ::log4cxx::Level::ERROR_INT)) {\
            ::log4cxx::helpers::MessageBuffer oss_; \
-           logger->forcedLog(::log4cxx::Level::getError(), oss_.str(oss_ << message), LOG4CXX_LOCATION); } } while (0)
+           oss_ << message; \
+           logger->forcedLog(::log4cxx::Level::getError(), oss_, LOG4CXX_LOCATION); } } while (0)
 
 #else
 #define LOG4CXX_ERROR(logger, message)
+#if LOG4CXX_HAS_VARIADIC_MACROS
+#define LOG4CXX_ERROR_FMT(logger, ...)
+#define LOG4CXX_ERROR_DEFERRED(logger, ...)
+#endif
+#define LOG4CXX_ERROR_FIELDS(logger, message, fields)
 #define LOG4CXX_ASSERT(logger, condition, message)
 #endif
 
@@ -1867,11 +2430,67 @@ Logs a message to a specified logger with the FATAL level.
 @param message the message string to log.
 */
 #define LOG4CXX_FATAL(logger, message) do { \
-        if (logger->isFatalEnabled()) {\
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (logger->isEnabledAt(site_, ::log4cxx::Level::FATAL_INT)) {\
            ::log4cxx::helpers::MessageBuffer oss_; \
-           logger->forcedLog(::log4cxx::Level::getFatal(), oss_.str(oss_ << message), LOG4CXX_LOCATION); } } while (0)
+           oss_ << message; \
+           logger->forcedLog(::log4cxx::Level::getFatal(), oss_, LOG4CXX_LOCATION); } } while (0)
+
+#if LOG4CXX_HAS_VARIADIC_MACROS
+/**
+Logs a message to a specified logger with the FATAL level,
+replacing each "{}" in the pattern by the next argument.
+The arguments are formatted only if the level is enabled.
+
+@param logger the logger to be used.
+@param ... the pattern, for example "user={} took {}ms",
+followed by up to eight arguments.
+*/
+#define LOG4CXX_FATAL_FMT(logger, ...) do { \
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (logger->isEnabledAt(site_, ::log4cxx::Level::FATAL_INT)) {\
+           ::log4cxx::helpers::MessageBuffer oss_; \
+           logger->forcedLog(::log4cxx::Level::getFatal(), \
+              ::log4cxx::helpers::braceFormat(oss_, __VA_ARGS__), LOG4CXX_LOCATION); } } while (0)
+
+/**
+Records a message for the specified logger with the FATAL level
+to be formatted and appended by a background thread.
+The call copies the pattern and the arguments, which are limited
+to numbers, characters and strings.
+
+@param logger the logger to be used.
+@param ... the pattern, for example "user={} took {}ms",
+followed by up to eight arguments.
+*/
+#define LOG4CXX_FATAL_DEFERRED(logger, ...) do { \
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (logger->isEnabledAt(site_, ::log4cxx::Level::FATAL_INT)) {\
+           ::log4cxx::helpers::deferredLog(logger, ::log4cxx::Level::FATAL_INT, site_, __VA_ARGS__); } } while (0)
+#endif
+
+/**
+Logs a message with typed fields to a specified logger with the FATAL level.
+The fields are evaluated only if the level is enabled.
+
+@param logger the logger to be used.
+@param message the message string to log.
+@param fields fields of the event, taken over by the event, for example
+<code>::log4cxx::spi::EventFields().add(LOG4CXX_STR("status"), 200)</code>.
+*/
+#define LOG4CXX_FATAL_FIELDS(logger, message, fields) do { \
+        static ::log4cxx::spi::CallSite site_ = LOG4CXX_CALL_SITE; \
+        if (logger->isEnabledAt(site_, ::log4cxx::Level::FATAL_INT)) {\
+           ::log4cxx::helpers::MessageBuffer oss_; \
+           oss_ << message; \
+           logger->forcedLog(::log4cxx::Level::getFatal(), oss_, fields, LOG4CXX_LOCATION); } } while (0)
 #else
 #define LOG4CXX_FATAL(logger, message)
+#if LOG4CXX_HAS_VARIADIC_MACROS
+#define LOG4CXX_FATAL_FMT(logger, ...)
+#define LOG4CXX_FATAL_DEFERRED(logger, ...)
+#endif
+#define LOG4CXX_FATAL_FIELDS(logger, message, fields)
 #endif           
 
 /**
@@ -1931,5 +2550,6 @@ Logs a localized message with three parameters.
 #endif
 
 #include <log4cxx/spi/loggerrepository.h>
+#include <log4cxx/helpers/deferredlog.h>
 
 #endif //_LOG4CXX_LOGGER_H
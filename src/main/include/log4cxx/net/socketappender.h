@@ -129,6 +129,11 @@ namespace log4cxx
 
                 void append(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& pool);
 
+                /**
+                Sends the events with a single flush of the connection.
+                */
+                void appendBatch(const spi::LoggingEventList& events, log4cxx::helpers::Pool& pool);
+
         private:
                 log4cxx::helpers::ObjectOutputStreamPtr oos;
 
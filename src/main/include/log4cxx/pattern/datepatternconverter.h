@@ -77,6 +77,13 @@ class LOG4CXX_EXPORT DatePatternConverter : public LoggingEventPatternConverter
   void format(const log4cxx::helpers::DatePtr& date,
      LogString& toAppendTo,
      log4cxx::helpers::Pool& p) const;
+
+  /**
+   * Gets the date format.
+   * @return date format.
+   */
+  inline const log4cxx::helpers::DateFormatPtr& getFormat() const
+     { return df; }
 };
 
 LOG4CXX_PTR_DEF(DatePatternConverter);
@@ -29,6 +29,8 @@ namespace log4cxx { namespace pattern {
  * java.util.Hashtable.toString(), or to output the value of a specific key
  * within the property bundle
  * when this pattern converter has the option set.
+ * Typed fields of the event follow the properties, and a key
+ * without a property is looked up in the fields.
  *
  * 
  * 
@@ -29,6 +29,7 @@
 #include <log4cxx/pattern/loggingeventpatternconverter.h>
 #include <log4cxx/pattern/formattinginfo.h>
 #include <log4cxx/pattern/patternparser.h>
+#include <log4cxx/helpers/dateformat.h>
 
 namespace log4cxx
 {
@@ -332,16 +333,41 @@ namespace log4cxx
                 LogString conversionPattern;
 
                 /**
-                 * Pattern converters.
+                 * Step of the conversion pattern as compiled by activateOptions,
+                 * which replaces the list of converters and field widths.
+                 * Adjacent literals are merged, the common converters
+                 * are performed without a virtual call and %d calls
+                 * its date format directly.
                  */
-                LOG4CXX_LIST_DEF(LoggingEventPatternConverterList, log4cxx::pattern::LoggingEventPatternConverterPtr);
-                LoggingEventPatternConverterList patternConverters;
+                struct FormatStep {
+                        enum Kind { LITERAL, MESSAGE, LINE_SEPARATOR, LEVEL, LOGGER, DATE, CONVERTER };
+                        Kind kind;
+                        /**
+                         * Text of a LITERAL step.
+                         */
+                        LogString literal;
+                        /**
+                         * Converter of a CONVERTER step.
+                         */
+                        log4cxx::pattern::LoggingEventPatternConverterPtr converter;
+                        /**
+                         * Date format of a DATE step.
+                         */
+                        log4cxx::helpers::DateFormatPtr dateFormat;
+                        /**
+                         * Field width and alignment, null if they have no effect.
+                         */
+                        log4cxx::pattern::FormattingInfoPtr field;
+                };
+                LOG4CXX_LIST_DEF(FormatStepList, FormatStep);
+                FormatStepList formatSteps;
 
-               /**
-                * Field widths and alignment corresponding to pattern converters.
-                */
-                LOG4CXX_LIST_DEF(FormattingInfoList, log4cxx::pattern::FormattingInfoPtr);
-                FormattingInfoList patternFields;
+                /**
+                 * Running average of the formatted length, used to
+                 * size the output before formatting.  Accessed with
+                 * APR atomics.
+                 */
+                mutable unsigned int volatile expectedLength;
 
 
         public:
@@ -397,6 +423,13 @@ namespace log4cxx
 
         protected:
                 virtual log4cxx::pattern::PatternMap getFormatSpecifiers();
+
+        private:
+                /**
+                 * Builds formatSteps from the parsed converters and field widths.
+                 */
+                void compile(const std::vector<log4cxx::pattern::PatternConverterPtr>& converters,
+                        const std::vector<log4cxx::pattern::FormattingInfoPtr>& fields);
         };
       LOG4CXX_PTR_DEF(PatternLayout);
 }  // namespace log4cxx
@@ -90,6 +90,14 @@ namespace log4cxx {
         */
         virtual void subAppend(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& p);
 
+        virtual bool formatsBatches() const;
+
+        /**
+         Writes the events at once, except that the events preceding
+         a triggering event are written before the rollover.
+        */
+        virtual void writeBatch(const spi::LoggingEventList& events, log4cxx::helpers::Pool& p);
+
         protected:
 
           RollingPolicyPtr getRollingPolicy() const;
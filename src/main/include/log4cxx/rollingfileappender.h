@@ -102,6 +102,8 @@ namespace log4cxx
     /** Prepares RollingFileAppender for use. */
     void activateOptions( log4cxx::helpers::Pool & pool );
 
+  protected:
+    virtual bool formatsBatches() const;
 
       }; // class RollingFileAppender
       LOG4CXX_PTR_DEF(RollingFileAppender);
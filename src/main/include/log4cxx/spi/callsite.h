@@ -0,0 +1,85 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LOG4CXX_SPI_CALL_SITE_H
+#define _LOG4CXX_SPI_CALL_SITE_H
+
+#include <log4cxx/log4cxx.h>
+#include <log4cxx/spi/location/locationinfo.h>
+
+namespace log4cxx
+{
+        class Logger;
+
+        namespace spi
+        {
+        /**
+        Enablement decision cached by a single expansion of one of the
+        LOG4CXX_TRACE, LOG4CXX_DEBUG, ... macros.
+
+        <p>Each expansion declares a static instance initialized by
+        LOG4CXX_CALL_SITE without any runtime initialization.  The first
+        logger that is checked at the call site claims it, the decision
+        is cached together with the configuration generation of Logger
+        and is valid until that generation changes.  Call sites used with
+        several loggers only cache the decision for the first one.
+
+        <p>A call site is added to CallSiteRegistry the first time it
+        is reached.
+        */
+        struct CallSite
+        {
+            /**
+            Logger the decision was cached for, null until claimed.
+            */
+            const Logger* volatile logger;
+
+            /**
+            Configuration generation shifted left by one, with the
+            low bit set if the call site was enabled.
+            */
+            unsigned int volatile state;
+
+            /**
+            Location of the logging statement.
+            */
+            const char* fileName;
+            const char* methodName;
+            int lineNumber;
+
+            /**
+            Non-zero once added to CallSiteRegistry.
+            */
+            unsigned int volatile registered;
+
+            /**
+            Filter::ACCEPT to log regardless of the logger level,
+            Filter::DENY to never log or Filter::NEUTRAL to follow
+            the logger level.  Set by CallSiteRegistry.
+            */
+            int volatile decision;
+        };
+        }  // namespace spi
+} // namespace log4cxx
+
+#if defined(__LOG4CXX_FUNC__)
+#define LOG4CXX_CALL_SITE { 0, 0, __FILE__, __LOG4CXX_FUNC__, __LINE__, 0, 0 }
+#else
+#define LOG4CXX_CALL_SITE { 0, 0, __FILE__, "", __LINE__, 0, 0 }
+#endif
+
+#endif //_LOG4CXX_SPI_CALL_SITE_H
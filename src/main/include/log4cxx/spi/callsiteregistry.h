@@ -0,0 +1,115 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LOG4CXX_SPI_CALL_SITE_REGISTRY_H
+#define _LOG4CXX_SPI_CALL_SITE_REGISTRY_H
+
+#if defined(_MSC_VER)
+#pragma warning ( push )
+#pragma warning ( disable: 4231 4251 4275 4786 )
+#endif
+
+#include <log4cxx/spi/callsite.h>
+#include <log4cxx/filter/locationinfofilter.h>
+#include <log4cxx/helpers/pool.h>
+#include <log4cxx/helpers/mutex.h>
+#include <vector>
+
+namespace log4cxx
+{
+        namespace spi
+        {
+        LOG4CXX_LIST_DEF(LocationInfoList, LocationInfo);
+
+        /**
+        Registry of the call sites of the LOG4CXX_TRACE, LOG4CXX_DEBUG, ...
+        macros, allowing individual logging statements or whole source
+        files to be switched on or off at runtime independently of logger
+        levels.
+
+        <p>Call sites are registered the first time they are reached.
+        Each call site takes the decision of the most recently added
+        LocationInfoFilter that does not return
+        {@link Filter#NEUTRAL NEUTRAL} for its location: on
+        {@link Filter#ACCEPT ACCEPT} the statement is logged whatever the
+        logger level, on {@link Filter#DENY DENY} it is never logged.
+        Filters also apply to call sites registered after they were added.
+
+        <p>The decision is cached by the call site, so a switched off
+        statement costs no more than a disabled one.
+
+        <p>The registry keeps the address of each call site, which is a
+        static of the module containing the logging statement.  A shared
+        library that is unloaded while logging remains in use must remove
+        its call sites with #unregisterCallSites before it is unloaded.
+        */
+        class LOG4CXX_EXPORT CallSiteRegistry
+        {
+        public:
+            /**
+            Add a filter to decide the call sites it matches.
+            */
+            static void addFilter(const filter::LocationInfoFilterPtr& filter);
+
+            /**
+            Remove all filters, all call sites follow logger levels again.
+            */
+            static void clearFilters();
+
+            /**
+            Get the locations of all call sites registered so far.
+            */
+            static LocationInfoList getCallSites();
+
+            /**
+            Add a call site and set its decision.  Used by Logger.
+            */
+            static void registerCallSite(CallSite& site);
+
+            /**
+            Remove the call sites stored between <code>begin</code>
+            and <code>end</code>, typically the static data of a module
+            about to be unloaded.  A removed call site that is reached
+            again is registered again.
+            @param begin first address of the range.
+            @param end address past the end of the range.
+            */
+            static void unregisterCallSites(const void* begin, const void* end);
+
+        private:
+            CallSiteRegistry();
+            CallSiteRegistry(const CallSiteRegistry&);
+            CallSiteRegistry& operator=(const CallSiteRegistry&);
+            ~CallSiteRegistry();
+
+            static CallSiteRegistry& getInstance();
+            int decide(const CallSite& site) const;
+            void update();
+
+            helpers::Pool pool;
+            helpers::Mutex mutex;
+            std::vector<CallSite*> sites;
+            std::vector<filter::LocationInfoFilterPtr> filters;
+        };
+        }  // namespace spi
+} // namespace log4cxx
+
+#if defined(_MSC_VER)
+#pragma warning ( pop )
+#endif
+
+#endif //_LOG4CXX_SPI_CALL_SITE_REGISTRY_H
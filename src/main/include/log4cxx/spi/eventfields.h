@@ -0,0 +1,228 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _LOG4CXX_SPI_EVENT_FIELDS_H
+#define _LOG4CXX_SPI_EVENT_FIELDS_H
+
+#if defined(_MSC_VER)
+#pragma warning (push)
+#pragma warning ( disable: 4231 4251 4275 4786 )
+#endif
+
+#include <log4cxx/logstring.h>
+#include <vector>
+
+namespace log4cxx
+{
+        namespace spi
+        {
+                class EventFields;
+
+                /**
+                A typed key-value pair attached to a logging event.
+                The value keeps its type and is converted to a string
+                only when a layout renders it.  The characters of a
+                STRING value are held by the EventFields containing the field.
+                */
+                class LOG4CXX_EXPORT EventField
+                {
+                public:
+                        enum Type { INTEGER, DOUBLE, BOOLEAN, STRING, UNSIGNED };
+
+                        EventField();
+                        /**
+                        @param key name of the field, a string literal
+                        since only the pointer is kept.
+                        @param value value.
+                        */
+                        EventField(const logchar* key, log4cxx_int64_t value);
+                        EventField(const logchar* key, log4cxx_uint64_t value);
+                        EventField(const logchar* key, double value);
+                        EventField(const logchar* key, bool value);
+
+                        inline const logchar* getKey() const
+                                { return key; }
+
+                        inline Type getType() const
+                                { return type; }
+
+                        /** Value of an INTEGER field. */
+                        inline log4cxx_int64_t getInteger() const
+                                { return value.integer; }
+
+                        /** Value of an UNSIGNED field. */
+                        inline log4cxx_uint64_t getUnsigned() const
+                                { return value.unsignedInteger; }
+
+                        /** Value of a DOUBLE field. */
+                        inline double getDouble() const
+                                { return value.real; }
+
+                        /** Value of a BOOLEAN field. */
+                        inline bool getBoolean() const
+                                { return value.boolean; }
+
+                        /** Value of a STRING field. */
+                        LogString getString() const;
+
+                        /**
+                        Appends the value as text.
+                        @param dest destination.
+                        */
+                        void format(LogString& dest) const;
+
+                private:
+#if !LOG4CXX_LOGCHAR_IS_UTF8
+                        /**
+                        Not implemented, prevents a string from
+                        being taken as a BOOLEAN value.
+                        */
+                        EventField(const logchar* key, const char* value);
+#endif
+#if !LOG4CXX_LOGCHAR_IS_WCHAR
+                        EventField(const logchar* key, const wchar_t* value);
+#endif
+
+                        const logchar* key;
+                        Type type;
+                        union {
+                                log4cxx_int64_t integer;
+                                log4cxx_uint64_t unsignedInteger;
+                                double real;
+                                bool boolean;
+                                /**
+                                Position of a STRING value in the characters
+                                of the containing EventFields.
+                                */
+                                struct {
+                                        size_t offset;
+                                        size_t length;
+                                } text;
+                        } value;
+                        /**
+                        Characters of the containing EventFields,
+                        set for a STRING field.
+                        */
+                        const LogString* strings;
+                        friend class EventFields;
+                };
+
+                /**
+                Fields of a logging event, kept in an inline array
+                unless there are more than INLINE_CAPACITY.  The characters
+                of all string values share a single string.
+
+                <p>Used to build the fields at a LOG4CXX_INFO_FIELDS call site:
+                <code>EventFields().add(LOG4CXX_STR("status"), 200).add(LOG4CXX_STR("elapsed"), 1.5)</code>
+                */
+                class LOG4CXX_EXPORT EventFields
+                {
+                public:
+                        enum { INLINE_CAPACITY = 16 };
+
+                        EventFields();
+                        EventFields(const EventFields& src);
+                        EventFields& operator=(const EventFields& src);
+                        ~EventFields();
+
+                        /**
+                        Adds a field.
+                        @param key name of the field, a string literal
+                        since only the pointer is kept.
+                        @param value value.
+                        @return this object.
+                        */
+                        EventFields& add(const logchar* key, int value);
+                        EventFields& add(const logchar* key, long value);
+                        EventFields& add(const logchar* key, unsigned int value);
+                        EventFields& add(const logchar* key, unsigned long value);
+                        EventFields& add(const logchar* key, log4cxx_int64_t value);
+                        EventFields& add(const logchar* key, log4cxx_uint64_t value);
+                        EventFields& add(const logchar* key, double value);
+                        EventFields& add(const logchar* key, bool value);
+                        EventFields& add(const logchar* key, const logchar* value);
+                        EventFields& add(const logchar* key, const LogString& value);
+                        EventFields& add(const EventField& field);
+
+                        inline size_t size() const
+                                { return count; }
+
+                        inline bool empty() const
+                                { return count == 0; }
+
+                        const EventField& operator[](size_t index) const;
+
+                        /**
+                        Finds the last field with a key.
+                        @param key key.
+                        @return field or null.
+                        */
+                        const EventField* find(const LogString& key) const;
+
+                        /**
+                        Removes all fields, keeping allocated storage.
+                        */
+                        void clear();
+
+                        /**
+                        Exchanges the fields and their storage with another object.
+                        @param other object.
+                        */
+                        void swap(EventFields& other);
+
+                private:
+                        EventField& append();
+                        EventField& at(size_t index);
+                        /**
+                        Points the STRING fields at the characters of this object.
+                        */
+                        void attachStrings();
+
+#if !LOG4CXX_LOGCHAR_IS_UTF8
+                        /**
+                        Not implemented, prevents a string of another character type
+                        from being added as a BOOLEAN value.
+                        */
+                        EventFields& add(const logchar* key, const char* value);
+#endif
+#if !LOG4CXX_LOGCHAR_IS_WCHAR
+                        /**
+                        Not implemented, prevents a string of another character type
+                        from being added as a BOOLEAN value.
+                        */
+                        EventFields& add(const logchar* key, const wchar_t* value);
+#endif
+
+                        EventField fields[INLINE_CAPACITY];
+                        size_t count;
+                        /**
+                        Characters of the STRING values.
+                        */
+                        LogString strings;
+                        /**
+                        Fields after the first INLINE_CAPACITY, allocated when needed.
+                        */
+                        std::vector<EventField>* overflow;
+                };
+        }
+}
+
+#if defined(_MSC_VER)
+#pragma warning (pop)
+#endif
+
+#endif //_LOG4CXX_SPI_EVENT_FIELDS_H
@@ -31,6 +31,8 @@
 #include <log4cxx/logger.h>
 #include <log4cxx/mdc.h>
 #include <log4cxx/spi/location/locationinfo.h>
+#include <log4cxx/spi/eventfields.h>
+#include <log4cxx/helpers/sharedstring.h>
 #include <vector>
 
 
@@ -39,6 +41,7 @@ namespace log4cxx
         namespace helpers
         {
                 class ObjectOutputStream;
+                class DeferredLog;
         }
 
         namespace spi
@@ -80,14 +83,60 @@ namespace log4cxx
                                 const LevelPtr& level,   const LogString& message,
                                 const log4cxx::spi::LocationInfo& location);
 
+                        /**
+                        Instantiate a LoggingEvent sharing the name of its logger.
+
+                        @param logger The name of the logger of this event.
+                        @param level The level of this event.
+                        @param message  The message of this event.
+                        @param location location of logging request.
+                        */
+                        LoggingEvent(const helpers::SharedStringPtr& logger,
+                                const LevelPtr& level,   const LogString& message,
+                                const log4cxx::spi::LocationInfo& location);
+
                         ~LoggingEvent();
 
+                        /**
+                        Obtains a LoggingEvent for the supplied parameters, reusing
+                        a previously released event when one is available.  The
+                        result is used in place of <code>new LoggingEvent(...)</code>
+                        and returns to the recycler when its last reference is released.
+
+                        @param logger The logger of this event.
+                        @param level The level of this event.
+                        @param message  The message of this event.
+                        @param location location of logging request.
+                        */
+                        static LoggingEvent* obtain(const LogString& logger,
+                                const LevelPtr& level,   const LogString& message,
+                                const log4cxx::spi::LocationInfo& location);
+
+                        /**
+                        Obtains a LoggingEvent sharing the name of its logger.
+
+                        @param logger The name of the logger of this event.
+                        @param level The level of this event.
+                        @param message  The message of this event.
+                        @param location location of logging request.
+                        */
+                        static LoggingEvent* obtain(const helpers::SharedStringPtr& logger,
+                                const LevelPtr& level,   const LogString& message,
+                                const log4cxx::spi::LocationInfo& location);
+
+                        void releaseRef() const;
+
                         /** Return the level of this event. */
                         inline const LevelPtr& getLevel() const
                                 { return level; }
 
                         /**  Return the name of the logger. */
                         inline const LogString& getLoggerName() const {
+                               return logger->getValue();
+                        }
+
+                        /**  Return the name of the logger, shared with the logger. */
+                        inline const helpers::SharedStringPtr& getSharedLoggerName() const {
                                return logger;
                         }
 
@@ -106,7 +155,7 @@ namespace log4cxx
 
                         /** Return the threadName of this event. */
                         inline const LogString& getThreadName() const {
-                             return threadName;
+                             return threadName->getValue();
                         }
 
                         /** Return the timeStamp of this event. */
@@ -188,11 +237,38 @@ namespace log4cxx
                         */
                         void setProperty(const LogString& key, const LogString& value);
 
+                        /**
+                        * Replaces the typed fields of the event.
+                        * @param fields fields.
+                        */
+                        void setFields(const EventFields& fields);
+                        /**
+                        * Replaces the typed fields of the event without copying them.
+                        * @param fields fields, left with the previous fields of the event.
+                        */
+                        void swapFields(EventFields& fields);
+                        /**
+                        * Returns the number of typed fields.
+                        */
+                        size_t getFieldCount() const;
+                        /**
+                        * Returns a typed field.
+                        * @param index index less than getFieldCount().
+                        */
+                        const EventField& getField(size_t index) const;
+                        /**
+                        * Appends the value of a typed field as text.
+                        * @param key key.
+                        * @param dest string to which value, if any, is appended.
+                        * @return true if key had a corresponding field.
+                        */
+                        bool getField(const LogString& key, LogString& dest) const;
+
                 private:
                         /**
                         * The logger of the logging event.
                         **/
-                        LogString logger;
+                        helpers::SharedStringPtr logger;
 
                         /** level of logging event. */
                         LevelPtr level;
@@ -208,6 +284,12 @@ namespace log4cxx
                         */
                         std::map<LogString, LogString> * properties;
 
+                        /**
+                        * Typed fields, allocated when first set and kept
+                        * when the event is recycled.
+                        */
+                        EventFields* fields;
+
                         /** Have we tried to do an NDC lookup? If we did, there is no need
                         *  to do it again.  Note that its value is always false when
                         *  serialized. Thus, a receiving SocketNode will never use it's own
@@ -231,20 +313,38 @@ namespace log4cxx
                         log4cxx_time_t timeStamp;
 
                         /** The is the location where this log statement was written. */
-                        const log4cxx::spi::LocationInfo locationInfo;
+                        log4cxx::spi::LocationInfo locationInfo;
 
 
                         /** The identifier of thread in which this logging event
                         was generated.
                         */
-                       const LogString threadName;
+                       helpers::SharedStringPtr threadName;
+
+                       /** True if obtained from the recycler and returned to it
+                       on release. */
+                       bool recyclable;
 
                        //
                        //   prevent copy and assignment
                        //
                        LoggingEvent(const LoggingEvent&);
                        LoggingEvent& operator=(const LoggingEvent&);
-                       static const LogString getCurrentThreadName();
+                       void reset(const helpers::SharedStringPtr& logger,
+                                const LevelPtr& level,   const LogString& message,
+                                const log4cxx::spi::LocationInfo& location);
+                       void recycle();
+                       static LoggingEvent* takeRecycled();
+                       /**
+                       Logger fills in <code>message</code> from a message buffer,
+                       exchanging storage instead of copying.
+                       */
+                       friend class log4cxx::Logger;
+                       /**
+                       DeferredLog fills in the time stamp and thread name
+                       recorded by the logging thread.
+                       */
+                       friend class log4cxx::helpers::DeferredLog;
                        
                        static void writeProlog(log4cxx::helpers::ObjectOutputStream& os, log4cxx::helpers::Pool& p);
                        
@@ -135,6 +135,12 @@ namespace log4cxx
                 value <code>false</code> is returned. */
                 virtual bool checkEntryConditions() const;
 
+                /**
+                This method is called by the AppenderSkeleton#doAppendBatch
+                method and writes the events with subAppendBatch.
+                */
+                virtual void appendBatch(const spi::LoggingEventList& events, log4cxx::helpers::Pool& p);
+
 
         public:
                 /**
@@ -188,6 +194,32 @@ namespace log4cxx
                */
                virtual void subAppend(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& p);
 
+               /**
+                Writes the events with writeBatch if formatsBatches is true,
+                otherwise calls subAppend for each event.
+               */
+               virtual void subAppendBatch(const spi::LoggingEventList& events, log4cxx::helpers::Pool& p);
+
+               /**
+                Returns true if the events of a batch may be written by
+                writeBatch, which bypasses subAppend.  True only for the
+                built-in appender classes themselves, so a subclass that
+                overrides subAppend gets a call for each event unless it
+                overrides this method too.
+               */
+               virtual bool formatsBatches() const;
+
+               /**
+                Formats the events and writes them at once, flushing
+                only after the last event if <b>ImmediateFlush</b> is set.
+               */
+               virtual void writeBatch(const spi::LoggingEventList& events, log4cxx::helpers::Pool& p);
+
+               /**
+                Writes formatted events, flushing if <b>ImmediateFlush</b> is set.
+               */
+               void writeFormatted(const LogString& msg, log4cxx::helpers::Pool& p);
+
 
                 /**
                 Write a footer as produced by the embedded layout's
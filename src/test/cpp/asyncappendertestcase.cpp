@@ -25,12 +25,17 @@
 #include "appenderskeletontestcase.h"
 #include <log4cxx/helpers/pool.h>
 #include <apr_strings.h>
+#include <apr_time.h>
+#include <apr_thread_proc.h>
+#include <apr_atomic.h>
 #include "testchar.h"
 #include <log4cxx/helpers/stringhelper.h>
 #include <log4cxx/helpers/synchronized.h>
 #include <log4cxx/spi/location/locationinfo.h>
 #include <log4cxx/xml/domconfigurator.h>
 #include <log4cxx/file.h>
+#include <log4cxx/helpers/thread.h>
+#include <map>
 
 using namespace log4cxx;
 using namespace log4cxx::helpers;
@@ -96,6 +101,64 @@ public:
 
 typedef helpers::ObjectPtrT<BlockableVectorAppender> BlockableVectorAppenderPtr;
 
+/**
+ * Vector appender that holds the dispatcher at an event
+ * with the message "hold" until the test releases it.
+ */
+class HoldingVectorAppender : public ImmediateVectorAppender {
+private:
+      Mutex holder;
+      volatile bool holding;
+public:
+      HoldingVectorAppender() : holder(pool), holding(false) {
+      }
+
+      void append(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& p) {
+          if (event->getMessage() == LOG4CXX_STR("hold")) {
+              holding = true;
+              synchronized sync(holder);
+          }
+          ImmediateVectorAppender::append(event, p);
+      }
+
+      Mutex& getHolder() {
+          return holder;
+      }
+
+      bool isHolding() const {
+          return holding;
+      }
+};
+
+typedef helpers::ObjectPtrT<HoldingVectorAppender> HoldingVectorAppenderPtr;
+
+/**
+ * Holding vector appender that throws once released.
+ */
+class FailingVectorAppender : public HoldingVectorAppender {
+public:
+      void append(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool& p) {
+          HoldingVectorAppender::append(event, p);
+          if (event->getMessage() == LOG4CXX_STR("hold")) {
+              throw RuntimeException(LOG4CXX_STR("Intentional RuntimeException"));
+          }
+      }
+};
+
+typedef helpers::ObjectPtrT<FailingVectorAppender> FailingVectorAppenderPtr;
+
+/**
+ * AsyncAppender that lets a test hold the mutex of the appender.
+ */
+class LockableAsyncAppender : public AsyncAppender {
+public:
+      Mutex& getMutex() {
+          return mutex;
+      }
+};
+
+typedef helpers::ObjectPtrT<LockableAsyncAppender> LockableAsyncAppenderPtr;
+
 #if APR_HAS_THREADS
 /**
  * Tests of AsyncAppender.
@@ -117,6 +180,21 @@ class AsyncAppenderTestCase : public AppenderSkeletonTestCase
                 //LOGUNIT_TEST(testBadAppender);
                 LOGUNIT_TEST(testLocationInfoTrue);
                 LOGUNIT_TEST(testConfiguration);
+                LOGUNIT_TEST(testMultipleProducers);
+                LOGUNIT_TEST(testGrowBuffer);
+                LOGUNIT_TEST(testProducerQueues);
+                LOGUNIT_TEST(testGrowProducerQueues);
+                LOGUNIT_TEST(testUnlockedProducers);
+                LOGUNIT_TEST(testStrictOrdering);
+                LOGUNIT_TEST(testThreadOrdering);
+                LOGUNIT_TEST(testDispatchLanes);
+                LOGUNIT_TEST(testLaneOverflow);
+                LOGUNIT_TEST(testBlockedLane);
+                LOGUNIT_TEST(testFullLane);
+                LOGUNIT_TEST(testFailedLane);
+                LOGUNIT_TEST(testOverflowThreshold);
+                LOGUNIT_TEST(testReservedSizeLimit);
+                LOGUNIT_TEST(testLaneOverflowThreshold);
         LOGUNIT_TEST_SUITE_END();
 
 
@@ -281,7 +359,568 @@ public:
 //              LOGUNIT_ASSERT_EQUAL(true, vectorAppender->isClosed());
         }
 
-        
+
+        enum { PRODUCERS = 4, EVENTS_PER_PRODUCER = 2000 };
+
+        static void* LOG4CXX_THREAD_FUNC produce(apr_thread_t* /* thread */, void* data) {
+              LoggerPtr logger((Logger*) data);
+              for (int i = 0; i < EVENTS_PER_PRODUCER; i++) {
+                    LOG4CXX_INFO(logger, i)
+              }
+              return 0;
+        }
+
+        /**
+         * Checks that every event of each producer was appended
+         * in the order it was logged.
+         */
+        void checkProducerOrder(const std::vector<spi::LoggingEventPtr>& v) {
+              LOGUNIT_ASSERT_EQUAL((size_t) (PRODUCERS * EVENTS_PER_PRODUCER), v.size());
+              std::map<LogString, int> next;
+              for (size_t i = 0; i < v.size(); i++) {
+                    int& expected = next[v[i]->getLoggerName()];
+                    LOGUNIT_ASSERT_EQUAL(expected, StringHelper::toInt(v[i]->getMessage()));
+                    expected++;
+              }
+              LOGUNIT_ASSERT_EQUAL((size_t) PRODUCERS, next.size());
+        }
+
+        void runProducers(const AsyncAppenderPtr& async, int grownSize) {
+              Thread threads[PRODUCERS];
+              for (int i = 0; i < PRODUCERS; i++) {
+                    LogString name(LOG4CXX_STR("producer"));
+                    name.append(1, (logchar) (0x30 + i));
+                    LoggerPtr logger(Logger::getLoggerLS(name));
+                    logger->setAdditivity(false);
+                    logger->addAppender(async);
+                    threads[i].run(produce, logger);
+              }
+              if (grownSize > 0) {
+                    async->setBufferSize(grownSize);
+              }
+              for (int i = 0; i < PRODUCERS; i++) {
+                    threads[i].join();
+              }
+              async->close();
+        }
+
+        /**
+         * Tests that events of concurrent threads are neither lost
+         * nor reordered while the buffer is frequently full.
+         */
+        void testMultipleProducers() {
+              ImmediateVectorAppenderPtr vectorAppender = new ImmediateVectorAppender();
+              AsyncAppenderPtr async = new AsyncAppender();
+              async->addAppender(vectorAppender);
+              async->setBufferSize(4);
+              Pool p;
+              async->activateOptions(p);
+              runProducers(async, 0);
+              checkProducerOrder(vectorAppender->getVector());
+        }
+
+        /**
+         * Tests that growing the buffer while threads are logging
+         * keeps every event in order.
+         */
+        void testGrowBuffer() {
+              ImmediateVectorAppenderPtr vectorAppender = new ImmediateVectorAppender();
+              AsyncAppenderPtr async = new AsyncAppender();
+              async->addAppender(vectorAppender);
+              async->setBufferSize(2);
+              Pool p;
+              async->activateOptions(p);
+              runProducers(async, 1000);
+              LOGUNIT_ASSERT_EQUAL(1000, async->getBufferSize());
+              checkProducerOrder(vectorAppender->getVector());
+        }
+
+        /**
+         * Tests that events logged by concurrent threads to queues
+         * of their own are neither lost nor reordered.
+         */
+        void testProducerQueues() {
+              ImmediateVectorAppenderPtr vectorAppender = new ImmediateVectorAppender();
+              AsyncAppenderPtr async = new AsyncAppender();
+              async->addAppender(vectorAppender);
+              async->setBufferSize(4);
+              async->setProducerQueues(true);
+              Pool p;
+              async->activateOptions(p);
+              runProducers(async, 0);
+              checkProducerOrder(vectorAppender->getVector());
+        }
+
+        /**
+         * Tests that the queues of logging threads are replaced
+         * without losing or reordering events when the buffer grows.
+         */
+        void testGrowProducerQueues() {
+              ImmediateVectorAppenderPtr vectorAppender = new ImmediateVectorAppender();
+              AsyncAppenderPtr async = new AsyncAppender();
+              async->addAppender(vectorAppender);
+              async->setBufferSize(2);
+              async->setProducerQueues(true);
+              Pool p;
+              async->activateOptions(p);
+              runProducers(async, 1000);
+              checkProducerOrder(vectorAppender->getVector());
+        }
+
+        struct CountedProducer {
+              LoggerPtr logger;
+              unsigned int volatile* finished;
+        };
+
+        static void* LOG4CXX_THREAD_FUNC produceCounted(apr_thread_t* /* thread */, void* data) {
+              CountedProducer* producer = (CountedProducer*) data;
+              for (int i = 0; i < 10; i++) {
+                    LOG4CXX_INFO(producer->logger, i)
+              }
+              apr_atomic_inc32(producer->finished);
+              return 0;
+        }
+
+        /**
+         * Tests that threads logging at once do not take
+         * the mutex of the appender.
+         */
+        void testUnlockedProducers() {
+              ImmediateVectorAppenderPtr vectorAppender = new ImmediateVectorAppender();
+              LockableAsyncAppenderPtr async = new LockableAsyncAppender();
+              async->addAppender(vectorAppender);
+              Pool p;
+              async->activateOptions(p);
+              unsigned int volatile finished = 0;
+              Thread threads[PRODUCERS];
+              CountedProducer producers[PRODUCERS];
+              {
+                  synchronized sync(async->getMutex());
+                  for (int i = 0; i < PRODUCERS; i++) {
+                        LogString name(LOG4CXX_STR("unlocked"));
+                        name.append(1, (logchar) (0x30 + i));
+                        producers[i].logger = Logger::getLoggerLS(name);
+                        producers[i].logger->setAdditivity(false);
+                        producers[i].logger->addAppender(async);
+                        producers[i].finished = &finished;
+                        threads[i].run(produceCounted, &producers[i]);
+                  }
+                  for (int i = 0; i < 500 && apr_atomic_read32(&finished) < PRODUCERS; i++) {
+                        Thread::sleep(10);
+                  }
+                  LOGUNIT_ASSERT_EQUAL((unsigned int) PRODUCERS, apr_atomic_read32(&finished));
+              }
+              for (int i = 0; i < PRODUCERS; i++) {
+                    threads[i].join();
+                    producers[i].logger->removeAllAppenders();
+              }
+              async->close();
+              LOGUNIT_ASSERT_EQUAL((size_t) (PRODUCERS * 10), vectorAppender->getVector().size());
+        }
+
+        static void* LOG4CXX_THREAD_FUNC logOther(apr_thread_t* /* thread */, void* data) {
+              LoggerPtr logger((Logger*) data);
+              LOG4CXX_INFO(logger, "other")
+              return 0;
+        }
+
+        /**
+         * Waits for the clock to advance so that the next event
+         * has a later time stamp than the events already logged.
+         */
+        static void awaitNextTick() {
+              apr_time_t logged = apr_time_now();
+              while (apr_time_now() == logged) {
+                  apr_thread_yield();
+              }
+        }
+
+        /**
+         * Logs "hold", then "first" and "second" from the calling thread
+         * with "other" from another thread in between while the dispatcher
+         * is held, so the events are removed from the queues together.
+         */
+        std::vector<LogString> logHeld(bool strictOrdering) {
+              HoldingVectorAppenderPtr vectorAppender = new HoldingVectorAppender();
+              AsyncAppenderPtr async = new AsyncAppender();
+              async->addAppender(vectorAppender);
+              async->setProducerQueues(true);
+              async->setStrictOrdering(strictOrdering);
+              Pool p;
+              async->activateOptions(p);
+              LoggerPtr logger(Logger::getLogger("held"));
+              logger->setAdditivity(false);
+              logger->addAppender(async);
+              {
+                  synchronized sync(vectorAppender->getHolder());
+                  LOG4CXX_INFO(logger, "hold")
+                  while (!vectorAppender->isHolding()) {
+                      Thread::sleep(1);
+                  }
+                  LOG4CXX_INFO(logger, "first")
+                  awaitNextTick();
+                  Thread other;
+                  other.run(logOther, logger);
+                  other.join();
+                  awaitNextTick();
+                  LOG4CXX_INFO(logger, "second")
+              }
+              async->close();
+              logger->removeAllAppenders();
+
+              std::vector<LogString> messages;
+              const std::vector<spi::LoggingEventPtr>& v = vectorAppender->getVector();
+              for (size_t i = 0; i < v.size(); i++) {
+                  messages.push_back(v[i]->getMessage());
+              }
+              return messages;
+        }
+
+        /**
+         * Tests that events of different threads are merged by time stamp.
+         */
+        void testStrictOrdering() {
+              std::vector<LogString> messages(logHeld(true));
+              LOGUNIT_ASSERT_EQUAL((size_t) 4, messages.size());
+              LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("hold"), messages[0]);
+              LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("first"), messages[1]);
+              LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("other"), messages[2]);
+              LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("second"), messages[3]);
+        }
+
+        /**
+         * Tests that without strict ordering the events of each thread
+         * are kept together, and that the queue of a thread that
+         * has ended is still read.
+         */
+        void testThreadOrdering() {
+              std::vector<LogString> messages(logHeld(false));
+              LOGUNIT_ASSERT_EQUAL((size_t) 4, messages.size());
+              LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("hold"), messages[0]);
+              LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("first"), messages[1]);
+              LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("second"), messages[2]);
+              LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("other"), messages[3]);
+        }
+
+        /**
+         * Waits up to five seconds for an appender to hold a number of events.
+         */
+        static size_t awaitEvents(const ImmediateVectorAppenderPtr& appender, size_t count) {
+              for (int i = 0; i < 500 && appender->getVector().size() < count; i++) {
+                  Thread::sleep(10);
+              }
+              return appender->getVector().size();
+        }
+
+        /**
+         * Tests that an appender receives events while another
+         * appender of the same AsyncAppender is held.
+         */
+        void testDispatchLanes() {
+              HoldingVectorAppenderPtr slowAppender = new HoldingVectorAppender();
+              ImmediateVectorAppenderPtr fastAppender = new ImmediateVectorAppender();
+              AsyncAppenderPtr async = new AsyncAppender();
+              async->addAppender(slowAppender);
+              async->addAppender(fastAppender);
+              async->setDispatchLanes(true);
+              async->setLaneBlocking(true);
+              async->setLaneBufferSize(200);
+              Pool p;
+              async->activateOptions(p);
+              LoggerPtr logger(Logger::getLogger("lanes"));
+              logger->setAdditivity(false);
+              logger->addAppender(async);
+              {
+                  synchronized sync(slowAppender->getHolder());
+                  LOG4CXX_INFO(logger, "hold")
+                  for (int i = 0; i < 100; i++) {
+                      LOG4CXX_INFO(logger, i)
+                  }
+                  LOGUNIT_ASSERT_EQUAL((size_t) 101, awaitEvents(fastAppender, 101));
+                  LOGUNIT_ASSERT(slowAppender->getVector().size() <= 1);
+              }
+              async->close();
+              logger->removeAllAppenders();
+              LOGUNIT_ASSERT_EQUAL((size_t) 101, slowAppender->getVector().size());
+              LOGUNIT_ASSERT_EQUAL((size_t) 101, fastAppender->getVector().size());
+              const std::vector<spi::LoggingEventPtr>& slow = slowAppender->getVector();
+              const std::vector<spi::LoggingEventPtr>& fast = fastAppender->getVector();
+              for (size_t i = 0; i < slow.size(); i++) {
+                  //
+                  //   the lanes share the events
+                  LOGUNIT_ASSERT(slow[i] == fast[i]);
+              }
+        }
+
+        /**
+         * Tests that a full lane discards its events with a summary
+         * without discarding the events of the other lanes.
+         */
+        void testLaneOverflow() {
+              HoldingVectorAppenderPtr slowAppender = new HoldingVectorAppender();
+              slowAppender->setName(LOG4CXX_STR("slow"));
+              ImmediateVectorAppenderPtr fastAppender = new ImmediateVectorAppender();
+              AsyncAppenderPtr async = new AsyncAppender();
+              async->addAppender(slowAppender);
+              async->addAppender(fastAppender);
+              async->setDispatchLanes(true);
+              async->setLaneBlocking(true);
+              async->setLaneOptions(LOG4CXX_STR("slow"), 5, false);
+              Pool p;
+              async->activateOptions(p);
+              LoggerPtr logger(Logger::getLogger("lanes"));
+              logger->setAdditivity(false);
+              logger->addAppender(async);
+              {
+                  synchronized sync(slowAppender->getHolder());
+                  LOG4CXX_INFO(logger, "hold")
+                  while (!slowAppender->isHolding()) {
+                      Thread::sleep(1);
+                  }
+                  for (int i = 0; i < 100; i++) {
+                      LOG4CXX_INFO(logger, i)
+                  }
+                  LOGUNIT_ASSERT_EQUAL((size_t) 101, awaitEvents(fastAppender, 101));
+              }
+              async->close();
+              logger->removeAllAppenders();
+              const std::vector<spi::LoggingEventPtr>& slow = slowAppender->getVector();
+              LOGUNIT_ASSERT(slow.size() < 101);
+              LogString discarded(slow.back()->getMessage());
+              LOGUNIT_ASSERT(StringHelper::startsWith(discarded, LOG4CXX_STR("Discarded ")));
+              LOGUNIT_ASSERT_EQUAL((size_t) 101, fastAppender->getVector().size());
+        }
+
+        /**
+         * Tests that appenders can be listed and added while
+         * a blocking lane waits for space.
+         */
+        void testBlockedLane() {
+              HoldingVectorAppenderPtr slowAppender = new HoldingVectorAppender();
+              AsyncAppenderPtr async = new AsyncAppender();
+              async->addAppender(slowAppender);
+              async->setDispatchLanes(true);
+              async->setLaneBlocking(true);
+              async->setLaneBufferSize(1);
+              Pool p;
+              async->activateOptions(p);
+              LoggerPtr logger(Logger::getLogger("lanes"));
+              logger->setAdditivity(false);
+              logger->addAppender(async);
+              ImmediateVectorAppenderPtr addedAppender = new ImmediateVectorAppender();
+              {
+                  synchronized sync(slowAppender->getHolder());
+                  LOG4CXX_INFO(logger, "hold")
+                  while (!slowAppender->isHolding()) {
+                      Thread::sleep(1);
+                  }
+                  for (int i = 0; i < 10; i++) {
+                      LOG4CXX_INFO(logger, i)
+                  }
+                  LOGUNIT_ASSERT_EQUAL((size_t) 1, async->getAllAppenders().size());
+                  async->addAppender(addedAppender);
+              }
+              async->close();
+              logger->removeAllAppenders();
+              LOGUNIT_ASSERT_EQUAL((size_t) 11, slowAppender->getVector().size());
+        }
+
+        /**
+         * Tests that a full blocking lane does not hold
+         * the events of the other lanes.
+         */
+        void testFullLane() {
+              HoldingVectorAppenderPtr slowAppender = new HoldingVectorAppender();
+              ImmediateVectorAppenderPtr fastAppender = new ImmediateVectorAppender();
+              AsyncAppenderPtr async = new AsyncAppender();
+              async->addAppender(slowAppender);
+              async->addAppender(fastAppender);
+              async->setDispatchLanes(true);
+              async->setLaneBlocking(true);
+              async->setLaneBufferSize(5);
+              Pool p;
+              async->activateOptions(p);
+              LoggerPtr logger(Logger::getLogger("lanes"));
+              logger->setAdditivity(false);
+              logger->addAppender(async);
+              {
+                  synchronized sync(slowAppender->getHolder());
+                  LOG4CXX_INFO(logger, "hold")
+                  while (!slowAppender->isHolding()) {
+                      Thread::sleep(1);
+                  }
+                  for (int i = 0; i < 9; i++) {
+                      LOG4CXX_INFO(logger, i)
+                  }
+                  LOGUNIT_ASSERT_EQUAL((size_t) 10, awaitEvents(fastAppender, 10));
+              }
+              async->close();
+              logger->removeAllAppenders();
+              const std::vector<spi::LoggingEventPtr>& slow = slowAppender->getVector();
+              const std::vector<spi::LoggingEventPtr>& fast = fastAppender->getVector();
+              LOGUNIT_ASSERT_EQUAL((size_t) 10, slow.size());
+              for (size_t i = 0; i < slow.size(); i++) {
+                  LOGUNIT_ASSERT(slow[i] == fast[i]);
+              }
+        }
+
+        /**
+         * Tests that the events of a lane whose appender
+         * throws are still appended.
+         */
+        void testFailedLane() {
+              FailingVectorAppenderPtr failingAppender = new FailingVectorAppender();
+              AsyncAppenderPtr async = new AsyncAppender();
+              async->addAppender(failingAppender);
+              async->setDispatchLanes(true);
+              async->setLaneBufferSize(20);
+              Pool p;
+              async->activateOptions(p);
+              LoggerPtr logger(Logger::getLogger("lanes"));
+              logger->setAdditivity(false);
+              logger->addAppender(async);
+              {
+                  synchronized sync(failingAppender->getHolder());
+                  LOG4CXX_INFO(logger, "hold")
+                  while (!failingAppender->isHolding()) {
+                      Thread::sleep(1);
+                  }
+                  for (int i = 0; i < 10; i++) {
+                      LOG4CXX_INFO(logger, i)
+                  }
+              }
+              for (int i = 0; i < 10; i++) {
+                  LOG4CXX_INFO(logger, i)
+              }
+              async->close();
+              logger->removeAllAppenders();
+              LOGUNIT_ASSERT_EQUAL((size_t) 21, failingAppender->getVector().size());
+        }
+
+        /**
+         * Tests that events below the overflow threshold are discarded
+         * without waiting and leave the reserved part of the buffer
+         * to more severe events.
+         */
+        void testOverflowThreshold() {
+              HoldingVectorAppenderPtr vectorAppender = new HoldingVectorAppender();
+              AsyncAppenderPtr async = new AsyncAppender();
+              async->addAppender(vectorAppender);
+              async->setBufferSize(10);
+              async->setOverflowThreshold(Level::getWarn());
+              async->setReservedSize(4);
+              Pool p;
+              async->activateOptions(p);
+              LoggerPtr logger(Logger::getLogger("overflow"));
+              logger->setAdditivity(false);
+              logger->setLevel(Level::getDebug());
+              logger->addAppender(async);
+              {
+                  synchronized sync(vectorAppender->getHolder());
+                  LOG4CXX_INFO(logger, "hold")
+                  while (!vectorAppender->isHolding()) {
+                      Thread::sleep(1);
+                  }
+                  for (int i = 0; i < 10; i++) {
+                      LOG4CXX_DEBUG(logger, "debug")
+                  }
+                  for (int i = 0; i < 4; i++) {
+                      LOG4CXX_ERROR(logger, "error")
+                  }
+                  LOG4CXX_DEBUG(logger, "debug")
+                  LOGUNIT_ASSERT_EQUAL(5U, async->getDiscardCount(Level::getDebug()));
+                  LOGUNIT_ASSERT_EQUAL(0U, async->getDiscardCount(Level::getError()));
+              }
+              async->close();
+              logger->removeAllAppenders();
+              const std::vector<spi::LoggingEventPtr>& v = vectorAppender->getVector();
+              LOGUNIT_ASSERT_EQUAL((size_t) 12, v.size());
+              int errors = 0;
+              for (size_t i = 0; i < v.size(); i++) {
+                  if (v[i]->getLevel() == Level::getError()) {
+                      errors++;
+                  }
+              }
+              LOGUNIT_ASSERT_EQUAL(4, errors);
+              LOGUNIT_ASSERT(StringHelper::startsWith(v[11]->getMessage(), LOG4CXX_STR("Discarded 5 ")));
+        }
+
+        /**
+         * Tests that a reserved size beyond the buffer size
+         * leaves one event to events below the overflow threshold.
+         */
+        void testReservedSizeLimit() {
+              HoldingVectorAppenderPtr vectorAppender = new HoldingVectorAppender();
+              AsyncAppenderPtr async = new AsyncAppender();
+              async->addAppender(vectorAppender);
+              async->setBufferSize(4);
+              async->setOverflowThreshold(Level::getWarn());
+              async->setReservedSize(10);
+              Pool p;
+              async->activateOptions(p);
+              LoggerPtr logger(Logger::getLogger("overflow"));
+              logger->setAdditivity(false);
+              logger->setLevel(Level::getDebug());
+              logger->addAppender(async);
+              {
+                  synchronized sync(vectorAppender->getHolder());
+                  LOG4CXX_ERROR(logger, "hold")
+                  while (!vectorAppender->isHolding()) {
+                      Thread::sleep(1);
+                  }
+                  for (int i = 0; i < 3; i++) {
+                      LOG4CXX_DEBUG(logger, "debug")
+                  }
+                  LOGUNIT_ASSERT_EQUAL(2U, async->getDiscardCount(Level::getDebug()));
+              }
+              async->close();
+              logger->removeAllAppenders();
+              LOGUNIT_ASSERT_EQUAL((size_t) 3, vectorAppender->getVector().size());
+        }
+
+        /**
+         * Tests that a blocking lane discards events below the
+         * overflow threshold without waiting and counts them.
+         */
+        void testLaneOverflowThreshold() {
+              HoldingVectorAppenderPtr slowAppender = new HoldingVectorAppender();
+              AsyncAppenderPtr async = new AsyncAppender();
+              async->addAppender(slowAppender);
+              async->setDispatchLanes(true);
+              async->setLaneBlocking(true);
+              async->setLaneBufferSize(5);
+              async->setOverflowThreshold(Level::getWarn());
+              async->setReservedSize(2);
+              Pool p;
+              async->activateOptions(p);
+              LoggerPtr logger(Logger::getLogger("lanes"));
+              logger->setAdditivity(false);
+              logger->setLevel(Level::getDebug());
+              logger->addAppender(async);
+              {
+                  synchronized sync(slowAppender->getHolder());
+                  LOG4CXX_ERROR(logger, "hold")
+                  while (!slowAppender->isHolding()) {
+                      Thread::sleep(1);
+                  }
+                  for (int i = 0; i < 10; i++) {
+                      LOG4CXX_DEBUG(logger, "debug")
+                  }
+                  for (int i = 0; i < 500 && async->getDiscardCount(Level::getDebug()) < 7; i++) {
+                      Thread::sleep(10);
+                  }
+                  LOGUNIT_ASSERT_EQUAL(7U, async->getDiscardCount(Level::getDebug()));
+                  for (int i = 0; i < 2; i++) {
+                      LOG4CXX_ERROR(logger, "error")
+                  }
+              }
+              async->close();
+              logger->removeAllAppenders();
+              const std::vector<spi::LoggingEventPtr>& slow = slowAppender->getVector();
+              LOGUNIT_ASSERT_EQUAL((size_t) 7, slow.size());
+              LOGUNIT_ASSERT_EQUAL(0U, async->getDiscardCount(Level::getError()));
+        }
+
 };
 
 LOGUNIT_TEST_SUITE_REGISTRATION(AsyncAppenderTestCase);
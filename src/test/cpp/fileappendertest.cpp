@@ -17,10 +17,37 @@
 #include <log4cxx/helpers/pool.h>
 #include <log4cxx/fileappender.h>
 #include <log4cxx/patternlayout.h>
+#include <log4cxx/spi/loggingevent.h>
 #include "logunit.h"
 
 using namespace log4cxx;
 using namespace log4cxx::helpers;
+using namespace log4cxx::spi;
+
+/**
+ * FileAppender that counts the events passed to subAppend.
+ */
+class CountingFileAppender : public FileAppender {
+public:
+  DECLARE_LOG4CXX_OBJECT(CountingFileAppender)
+  BEGIN_LOG4CXX_CAST_MAP()
+    LOG4CXX_CAST_ENTRY(CountingFileAppender)
+    LOG4CXX_CAST_ENTRY_CHAIN(FileAppender)
+  END_LOG4CXX_CAST_MAP()
+
+  CountingFileAppender() : count(0) {
+  }
+
+  int count;
+
+protected:
+  void subAppend(const LoggingEventPtr& event, Pool& p) {
+    count++;
+    FileAppender::subAppend(event, p);
+  }
+};
+
+IMPLEMENT_LOG4CXX_OBJECT(CountingFileAppender)
 
 
 /**
@@ -32,6 +59,8 @@ LOGUNIT_CLASS(FileAppenderTest) {
           LOGUNIT_TEST(testDirectoryCreation);
           LOGUNIT_TEST(testgetSetThreshold);
           LOGUNIT_TEST(testIsAsSevereAsThreshold);
+          LOGUNIT_TEST(testAppendBatch);
+          LOGUNIT_TEST(testAppendBatchOverride);
   LOGUNIT_TEST_SUITE_END();
 public:
   /**
@@ -77,6 +106,56 @@ public:
     LevelPtr debug = Level::getDebug();
     LOGUNIT_ASSERT(appender->isAsSevereAsThreshold(debug));
   }
+
+  /**
+   * Tests that doAppendBatch writes the events
+   * that pass the threshold.
+   */
+  void testAppendBatch() {
+    Pool p;
+    FileAppenderPtr appender(new FileAppender());
+    appender->setFile(LOG4CXX_STR("output/batch.log"));
+    appender->setAppend(false);
+    appender->setLayout(new PatternLayout(LOG4CXX_STR("%m%n")));
+    appender->setThreshold(Level::getInfo());
+    appender->activateOptions(p);
+
+    LoggingEventList events;
+    events.push_back(LoggingEvent::obtain(LOG4CXX_STR("batch"), Level::getInfo(),
+        LOG4CXX_STR("first"), LocationInfo::getLocationUnavailable()));
+    events.push_back(LoggingEvent::obtain(LOG4CXX_STR("batch"), Level::getDebug(),
+        LOG4CXX_STR("hidden"), LocationInfo::getLocationUnavailable()));
+    events.push_back(LoggingEvent::obtain(LOG4CXX_STR("batch"), Level::getWarn(),
+        LOG4CXX_STR("last"), LocationInfo::getLocationUnavailable()));
+    appender->doAppendBatch(events, p);
+    appender->close();
+
+    size_t expected = 5 + 4 + 2 * LogString(LOG4CXX_EOL).length();
+    LOGUNIT_ASSERT_EQUAL(expected, File(LOG4CXX_STR("output/batch.log")).length(p));
+  }
+
+  /**
+   * Tests that doAppendBatch calls subAppend for each event
+   * of a subclass that overrides it.
+   */
+  void testAppendBatchOverride() {
+    Pool p;
+    ObjectPtrT<CountingFileAppender> appender(new CountingFileAppender());
+    appender->setFile(LOG4CXX_STR("output/batchoverride.log"));
+    appender->setAppend(false);
+    appender->setLayout(new PatternLayout(LOG4CXX_STR("%m%n")));
+    appender->activateOptions(p);
+
+    LoggingEventList events;
+    events.push_back(LoggingEvent::obtain(LOG4CXX_STR("batch"), Level::getInfo(),
+        LOG4CXX_STR("first"), LocationInfo::getLocationUnavailable()));
+    events.push_back(LoggingEvent::obtain(LOG4CXX_STR("batch"), Level::getWarn(),
+        LOG4CXX_STR("last"), LocationInfo::getLocationUnavailable()));
+    appender->doAppendBatch(events, p);
+    appender->close();
+
+    LOGUNIT_ASSERT_EQUAL(2, appender->count);
+  }
 };
 
 LOGUNIT_TEST_SUITE_REGISTRATION(FileAppenderTest);
@@ -0,0 +1,124 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <log4cxx/filter/locationinfofilter.h>
+#include <log4cxx/logger.h>
+#include <log4cxx/spi/filter.h>
+#include <log4cxx/spi/loggingevent.h>
+#include "../logunit.h"
+
+using namespace log4cxx;
+using namespace log4cxx::filter;
+using namespace log4cxx::spi; 
+using namespace log4cxx::helpers;
+
+
+/**
+ * Unit tests for LocationInfoFilter.
+ */
+LOGUNIT_CLASS(LocationInfoFilterTest) {
+    LOGUNIT_TEST_SUITE(LocationInfoFilterTest);
+       LOGUNIT_TEST(test1);
+       LOGUNIT_TEST(test2);
+       LOGUNIT_TEST(test3);
+       LOGUNIT_TEST(test4);
+       LOGUNIT_TEST(test5);
+    LOGUNIT_TEST_SUITE_END();
+    
+public:
+    /**
+     * Check that LocationInfoFilter::decide() with no options
+     *    returns Filter::ACCEPT.
+     */
+    void test1() {
+        LoggingEventPtr event(new LoggingEvent(
+                LOG4CXX_STR("root"),
+                Level::getInfo(), 
+                LOG4CXX_STR("Hello, World"), 
+                LocationInfo("src/main/cpp/logger.cpp", "void Logger::info()", 42)));
+        FilterPtr filter(new LocationInfoFilter());
+        Pool p; 
+        filter->activateOptions(p);
+        LOGUNIT_ASSERT_EQUAL(Filter::ACCEPT, filter->decide(event));
+    }
+
+    /**
+     * Check that LocationInfoFilter::decide() matches trailing
+     *    path components of the file name only.
+     */
+    void test2() {
+        LocationInfoFilterPtr filter(new LocationInfoFilter());
+        filter->setFileName(LOG4CXX_STR("logger.cpp"));
+        filter->setAcceptOnMatch(false);
+        Pool p; 
+        filter->activateOptions(p);
+        LOGUNIT_ASSERT_EQUAL(Filter::DENY, filter->decide(
+            LocationInfo("src/main/cpp/logger.cpp", "void Logger::info()", 42)));
+        LOGUNIT_ASSERT_EQUAL(Filter::DENY, filter->decide(
+            LocationInfo("logger.cpp", "void Logger::info()", 42)));
+        LOGUNIT_ASSERT_EQUAL(Filter::NEUTRAL, filter->decide(
+            LocationInfo("src/main/cpp/xlogger.cpp", "void Logger::info()", 42)));
+        filter->setFileName(LOG4CXX_STR("cpp/logger.cpp"));
+        LOGUNIT_ASSERT_EQUAL(Filter::DENY, filter->decide(
+            LocationInfo("src\\main\\cpp/logger.cpp", "void Logger::info()", 42)));
+    }
+
+    /**
+     * Check that LocationInfoFilter::decide() matches the method name
+     *    with or without the class name.
+     */
+    void test3() {
+        LocationInfoFilterPtr filter(new LocationInfoFilter());
+        filter->setMethodName(LOG4CXX_STR("info"));
+        LOGUNIT_ASSERT_EQUAL(Filter::ACCEPT, filter->decide(
+            LocationInfo("logger.cpp", "void Logger::info()", 42)));
+        filter->setMethodName(LOG4CXX_STR("Logger::info"));
+        LOGUNIT_ASSERT_EQUAL(Filter::ACCEPT, filter->decide(
+            LocationInfo("logger.cpp", "void Logger::info()", 42)));
+        LOGUNIT_ASSERT_EQUAL(Filter::NEUTRAL, filter->decide(
+            LocationInfo("logger.cpp", "void Logger::debug()", 42)));
+    }
+
+    /**
+     * Check that LocationInfoFilter::decide() requires every
+     *    option that is set to match.
+     */
+    void test4() {
+        LocationInfoFilterPtr filter(new LocationInfoFilter());
+        filter->setOption(LOG4CXX_STR("FileName"), LOG4CXX_STR("logger.cpp"));
+        filter->setOption(LOG4CXX_STR("LineNumber"), LOG4CXX_STR("42"));
+        LOGUNIT_ASSERT_EQUAL(Filter::ACCEPT, filter->decide(
+            LocationInfo("logger.cpp", "void Logger::info()", 42)));
+        LOGUNIT_ASSERT_EQUAL(Filter::NEUTRAL, filter->decide(
+            LocationInfo("logger.cpp", "void Logger::info()", 43)));
+        LOGUNIT_ASSERT_EQUAL(Filter::NEUTRAL, filter->decide(
+            LocationInfo("hierarchy.cpp", "void Logger::info()", 42)));
+    }
+
+    /**
+     * Check that LocationInfoFilter::decide() returns Filter::NEUTRAL
+     *    when location information is not available.
+     */
+    void test5() {
+        LocationInfoFilterPtr filter(new LocationInfoFilter());
+        filter->setFileName(LOG4CXX_STR("logger.cpp"));
+        LOGUNIT_ASSERT_EQUAL(Filter::NEUTRAL, filter->decide(
+            LocationInfo::getLocationUnavailable()));
+    }
+
+};
+
+LOGUNIT_TEST_SUITE_REGISTRATION(LocationInfoFilterTest);
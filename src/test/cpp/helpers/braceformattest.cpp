@@ -0,0 +1,98 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <log4cxx/helpers/braceformat.h>
+#include <iomanip>
+#include "../insertwide.h"
+#include "../logunit.h"
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+
+/**
+ *  Test brace formatting used by the LOG4CXX_INFO_FMT and similar macros.
+ */
+LOGUNIT_CLASS(BraceFormatTest)
+{
+   LOGUNIT_TEST_SUITE(BraceFormatTest);
+      LOGUNIT_TEST(testNoArguments);
+      LOGUNIT_TEST(testArguments);
+      LOGUNIT_TEST(testEscapes);
+      LOGUNIT_TEST(testMissingArguments);
+      LOGUNIT_TEST(testExtraArguments);
+      LOGUNIT_TEST(testEightArguments);
+      LOGUNIT_TEST(testManipulator);
+#if LOG4CXX_WCHAR_T_API
+      LOGUNIT_TEST(testWide);
+#endif
+   LOGUNIT_TEST_SUITE_END();
+
+
+public:
+    void testNoArguments() {
+        MessageBuffer buf;
+        CharMessageBuffer& retval = braceFormat(buf, "Hello, World");
+        LOGUNIT_ASSERT_EQUAL(std::string("Hello, World"), buf.str(retval));
+    }
+
+    void testArguments() {
+        MessageBuffer buf;
+        CharMessageBuffer& retval = braceFormat(buf, "user={} took {}ms", std::string("bob"), 42);
+        LOGUNIT_ASSERT_EQUAL(std::string("user=bob took 42ms"), buf.str(retval));
+    }
+
+    void testEscapes() {
+        MessageBuffer buf;
+        CharMessageBuffer& retval = braceFormat(buf, "{{{}}} {{}} { }", 'x');
+        LOGUNIT_ASSERT_EQUAL(std::string("{x} {} { }"), buf.str(retval));
+    }
+
+    void testMissingArguments() {
+        MessageBuffer buf;
+        CharMessageBuffer& retval = braceFormat(buf, "{}, {} and {}", 1, 2.5);
+        LOGUNIT_ASSERT_EQUAL(std::string("1, 2.5 and {}"), buf.str(retval));
+    }
+
+    void testExtraArguments() {
+        MessageBuffer buf;
+        CharMessageBuffer& retval = braceFormat(buf, "only {}", "one", "two");
+        LOGUNIT_ASSERT_EQUAL(std::string("only one"), buf.str(retval));
+    }
+
+    void testEightArguments() {
+        MessageBuffer buf;
+        CharMessageBuffer& retval = braceFormat(buf, "{}{}{}{}{}{}{}{}", 1, 2, 3, 4, 5, 6, 7, 8);
+        LOGUNIT_ASSERT_EQUAL(std::string("12345678"), buf.str(retval));
+    }
+
+    void testManipulator() {
+        MessageBuffer buf;
+        CharMessageBuffer& retval = braceFormat(buf, "pi={} ({})", std::setprecision(3), 3.14159);
+        LOGUNIT_ASSERT_EQUAL(std::string("pi= (3.14)"), buf.str(retval));
+        LOGUNIT_ASSERT_EQUAL(true, buf.hasStream());
+    }
+
+#if LOG4CXX_WCHAR_T_API
+    void testWide() {
+        MessageBuffer buf;
+        WideMessageBuffer& retval = braceFormat(buf, L"{} + {} = {}", 1, 1, std::wstring(L"two"));
+        LOGUNIT_ASSERT_EQUAL(std::wstring(L"1 + 1 = two"), buf.str(retval));
+    }
+#endif
+};
+
+LOGUNIT_TEST_SUITE_REGISTRATION(BraceFormatTest);
@@ -20,6 +20,9 @@
 #include <log4cxx/helpers/absolutetimedateformat.h>
 #include <log4cxx/helpers/relativetimedateformat.h>
 #include <log4cxx/helpers/pool.h>
+#include <log4cxx/helpers/iso8601dateformat.h>
+#include <log4cxx/helpers/thread.h>
+#include <log4cxx/helpers/threadspecificdata.h>
 #include <locale>
 #include "../insertwide.h"
 #include <apr.h>
@@ -77,6 +80,8 @@ LOGUNIT_CLASS(CachedDateFormatTestCase)
      LOGUNIT_TEST( test19);
      LOGUNIT_TEST( test20);
      LOGUNIT_TEST( test21);
+     LOGUNIT_TEST( test22);
+     LOGUNIT_TEST( test23 );
      LOGUNIT_TEST_SUITE_END();
 
 
@@ -607,6 +612,76 @@ void test21() {
     LOGUNIT_ASSERT_EQUAL(1000, maxValid);
 }
 
+struct FormatThreadData {
+    CachedDateFormat* cached;
+    DateFormatPtr base;
+    apr_time_t start;
+    int mismatches;
+};
+
+static void* LOG4CXX_THREAD_FUNC formatTimes(apr_thread_t* /* thread */, void* data) {
+    FormatThreadData* td = (FormatThreadData*) data;
+    Pool p;
+    LogString expected;
+    LogString actual;
+    for (int i = 0; i < 5000; i++) {
+        apr_time_t now = td->start + i * APR_INT64_C(1237);
+        expected.erase(expected.begin(), expected.end());
+        actual.erase(actual.begin(), actual.end());
+        td->base->format(expected, now, p);
+        td->cached->format(actual, now, p);
+        if (expected != actual) {
+            td->mismatches++;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Check that threads sharing one format, each formatting
+ * different times, get the same results as the wrapped format.
+ */
+void test22() {
+    DateFormatPtr baseFormat(new ISO8601DateFormat());
+    CachedDateFormat cachedFormat(baseFormat, 1000000);
+    cachedFormat.setTimeZone(TimeZone::getGMT());
+    apr_time_t jul1 = MICROSECONDS_PER_DAY * 12601L;
+
+    enum { THREADS = 4 };
+    FormatThreadData data[THREADS];
+    Thread threads[THREADS];
+    for (int i = 0; i < THREADS; i++) {
+        data[i].cached = &cachedFormat;
+        data[i].base = baseFormat;
+        data[i].start = jul1 + i * MICROSECONDS_PER_DAY + i * 777000;
+        data[i].mismatches = 0;
+        threads[i].run(formatTimes, &data[i]);
+    }
+    for (int i = 0; i < THREADS; i++) {
+        threads[i].join();
+        LOGUNIT_ASSERT_EQUAL(0, data[i].mismatches);
+    }
+}
+
+/**
+ * Check that formats whose identifiers differ by a multiple of
+ * the cache size keep separate entries on the calling thread.
+ */
+void test23() {
+    const unsigned int first = 0x7FFF0001;
+    const unsigned int second = first + ThreadSpecificData::DATE_CACHE_SIZE;
+    ThreadSpecificData::DateCacheEntry* entry1 = ThreadSpecificData::getDateCache(first);
+    LOGUNIT_ASSERT(entry1 != 0);
+    entry1->formatId = first;
+    ThreadSpecificData::DateCacheEntry* entry2 = ThreadSpecificData::getDateCache(second);
+    LOGUNIT_ASSERT(entry2 != entry1);
+    entry2->formatId = second;
+    LOGUNIT_ASSERT(ThreadSpecificData::getDateCache(first) == entry1);
+    LOGUNIT_ASSERT(ThreadSpecificData::getDateCache(second) == entry2);
+    entry1->formatId = 0;
+    entry2->formatId = 0;
+}
+
 };
 
 
@@ -0,0 +1,230 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.
+ * The ASF licenses this file to You under the Apache License, Version 2.0
+ * (the "License"); you may not use this file except in compliance with
+ * the License.  You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <log4cxx/logger.h>
+#include <log4cxx/basicconfigurator.h>
+#include <log4cxx/logmanager.h>
+#include <log4cxx/helpers/deferredlog.h>
+#include <log4cxx/helpers/thread.h>
+#include <log4cxx/helpers/threadspecificdata.h>
+#include <log4cxx/helpers/stringhelper.h>
+#include <log4cxx/helpers/pool.h>
+#include "../vectorappender.h"
+#include "../insertwide.h"
+#include "../logunit.h"
+#include "../xml/xlevel.h"
+
+using namespace log4cxx;
+using namespace log4cxx::helpers;
+using namespace log4cxx::spi;
+
+#if LOG4CXX_HAS_VARIADIC_MACROS
+/**
+ *  Tests LOG4CXX_INFO_DEFERRED and similar macros.
+ */
+LOGUNIT_CLASS(DeferredLogTest)
+{
+   LOGUNIT_TEST_SUITE(DeferredLogTest);
+      LOGUNIT_TEST(testFormat);
+      LOGUNIT_TEST(testWideIntegers);
+      LOGUNIT_TEST(testCustomLevel);
+      LOGUNIT_TEST(testPatternCopied);
+      LOGUNIT_TEST(testDisabled);
+      LOGUNIT_TEST(testThreadName);
+      LOGUNIT_TEST(testOrder);
+      LOGUNIT_TEST(testOversize);
+      LOGUNIT_TEST(testThreads);
+      LOGUNIT_TEST(testShutdown);
+   LOGUNIT_TEST_SUITE_END();
+
+   LoggerPtr logger;
+   VectorAppenderPtr appender;
+
+public:
+   void setUp() {
+      logger = Logger::getLogger("org.apache.log4cxx.deferred");
+      appender = new ImmediateVectorAppender();
+      logger->addAppender(appender);
+   }
+
+   void tearDown() {
+      DeferredLog::flush();
+      logger->removeAppender(appender);
+      logger = 0;
+      appender = 0;
+      BasicConfigurator::resetConfiguration();
+   }
+
+   void testFormat() {
+      std::string name("bob");
+      const char* unit = "ms";
+      LOG4CXX_INFO_DEFERRED(logger, "user={} took {}{} ({}, {}, {}, {})",
+         name, 42, unit, 2.5, 'x', -7L, 3000000000UL);
+      LOG4CXX_WARN_DEFERRED(logger, "no arguments {{}}");
+      DeferredLog::flush();
+      const std::vector<LoggingEventPtr>& events = appender->getVector();
+      LOGUNIT_ASSERT_EQUAL((size_t) 2, events.size());
+      LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("user=bob took 42ms (2.5, x, -7, 3000000000)"),
+         events[0]->getMessage());
+      LOGUNIT_ASSERT_EQUAL(Level::getInfo(), events[0]->getLevel());
+      LOGUNIT_ASSERT_EQUAL(logger->getName(), events[0]->getLoggerName());
+      LOGUNIT_ASSERT(events[0]->getLocationInformation().getLineNumber() > 0);
+      LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("no arguments {}"), events[1]->getMessage());
+      LOGUNIT_ASSERT_EQUAL(Level::getWarn(), events[1]->getLevel());
+   }
+
+   void testWideIntegers() {
+      log4cxx_int64_t big = 1;
+      big <<= 40;
+      log4cxx_uint64_t ubig = 1;
+      ubig <<= 63;
+      LOG4CXX_INFO_DEFERRED(logger, "{} {}", -big, ubig);
+      DeferredLog::flush();
+      const std::vector<LoggingEventPtr>& events = appender->getVector();
+      LOGUNIT_ASSERT_EQUAL((size_t) 1, events.size());
+      LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("-1099511627776 9223372036854775808"),
+         events[0]->getMessage());
+   }
+
+   /**
+    *  Custom levels are kept rather than mapped to a standard level.
+    */
+   void testCustomLevel() {
+      static CallSite site = LOG4CXX_CALL_SITE;
+      deferredLog(logger, XLevel::getLethal(), site, "lethal {}", 1);
+      DeferredLog::flush();
+      const std::vector<LoggingEventPtr>& events = appender->getVector();
+      LOGUNIT_ASSERT_EQUAL((size_t) 1, events.size());
+      LOGUNIT_ASSERT_EQUAL(XLevel::getLethal(), events[0]->getLevel());
+      LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("lethal 1"), events[0]->getMessage());
+   }
+
+   /**
+    *  The pattern may be released once the request returns.
+    */
+   void testPatternCopied() {
+      {
+         std::string pattern("copied {}");
+         LOG4CXX_INFO_DEFERRED(logger, pattern.c_str(), 7);
+         pattern.assign(pattern.length(), 'z');
+      }
+      DeferredLog::flush();
+      const std::vector<LoggingEventPtr>& events = appender->getVector();
+      LOGUNIT_ASSERT_EQUAL((size_t) 1, events.size());
+      LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("copied 7"), events[0]->getMessage());
+   }
+
+   void testDisabled() {
+      logger->setLevel(Level::getInfo());
+      LOG4CXX_DEBUG_DEFERRED(logger, "skipped {}", 1);
+      DeferredLog::flush();
+      LOGUNIT_ASSERT_EQUAL((size_t) 0, appender->getVector().size());
+   }
+
+   /**
+    *  Events keep the name of the thread that logged them.
+    */
+   void testThreadName() {
+      ThreadSpecificData::setThreadName(LOG4CXX_STR("deferred-producer"));
+      LOG4CXX_INFO_DEFERRED(logger, "named");
+      DeferredLog::flush();
+      ThreadSpecificData::setThreadName(LogString());
+      const std::vector<LoggingEventPtr>& events = appender->getVector();
+      LOGUNIT_ASSERT_EQUAL((size_t) 1, events.size());
+      LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("deferred-producer"), events[0]->getThreadName());
+      LOGUNIT_ASSERT(!DeferredLog::isDispatchThread());
+   }
+
+   enum { EVENT_COUNT = 10000 };
+
+   /**
+    *  More events than fit in the buffer arrive in order.
+    */
+   void testOrder() {
+      for (int i = 0; i < EVENT_COUNT; i++) {
+         LOG4CXX_INFO_DEFERRED(logger, "{}", i);
+      }
+      DeferredLog::flush();
+      const std::vector<LoggingEventPtr>& events = appender->getVector();
+      LOGUNIT_ASSERT_EQUAL((size_t) EVENT_COUNT, events.size());
+      for (int i = 0; i < EVENT_COUNT; i++) {
+         LogString expected;
+         Pool p;
+         StringHelper::toString(i, p, expected);
+         LOGUNIT_ASSERT_EQUAL(expected, events[i]->getMessage());
+      }
+      for (int i = 1; i < EVENT_COUNT; i++) {
+         LOGUNIT_ASSERT(events[i - 1]->getTimeStamp() <= events[i]->getTimeStamp());
+      }
+   }
+
+   /**
+    *  Requests larger than the buffer are logged immediately, in order.
+    */
+   void testOversize() {
+      std::string large(DeferredBuffer::CAPACITY, 'x');
+      LOG4CXX_INFO_DEFERRED(logger, "before");
+      LOG4CXX_INFO_DEFERRED(logger, "{}", large);
+      LOG4CXX_INFO_DEFERRED(logger, "after");
+      DeferredLog::flush();
+      const std::vector<LoggingEventPtr>& events = appender->getVector();
+      LOGUNIT_ASSERT_EQUAL((size_t) 3, events.size());
+      LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("before"), events[0]->getMessage());
+      LOGUNIT_ASSERT_EQUAL((size_t) DeferredBuffer::CAPACITY, events[1]->getMessage().size());
+      LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("after"), events[2]->getMessage());
+   }
+
+   enum { THREAD_COUNT = 4, EVENTS_PER_THREAD = 5000 };
+
+   static void* LOG4CXX_THREAD_FUNC logEvents(apr_thread_t* /* thread */, void* data) {
+      Logger* target = (Logger*) data;
+      for (int i = 0; i < EVENTS_PER_THREAD; i++) {
+         LOG4CXX_INFO_DEFERRED(target, "event {}", i);
+      }
+      return 0;
+   }
+
+   /**
+    *  Buffers of ended threads are processed completely.
+    */
+   void testThreads() {
+      Thread threads[THREAD_COUNT];
+      for (int i = 0; i < THREAD_COUNT; i++) {
+         threads[i].run(logEvents, (Logger*) logger);
+      }
+      for (int i = 0; i < THREAD_COUNT; i++) {
+         threads[i].join();
+      }
+      DeferredLog::flush();
+      LOGUNIT_ASSERT_EQUAL((size_t) (THREAD_COUNT * EVENTS_PER_THREAD), appender->getVector().size());
+   }
+
+   /**
+    *  Shutting down delivers pending events, later requests restart the thread.
+    */
+   void testShutdown() {
+      LOG4CXX_INFO_DEFERRED(logger, "first");
+      DeferredLog::shutdown();
+      LOGUNIT_ASSERT_EQUAL((size_t) 1, appender->getVector().size());
+      LOG4CXX_INFO_DEFERRED(logger, "second");
+      DeferredLog::flush();
+      LOGUNIT_ASSERT_EQUAL((size_t) 2, appender->getVector().size());
+   }
+};
+
+LOGUNIT_TEST_SUITE_REGISTRATION(DeferredLogTest);
+#endif
@@ -17,6 +17,8 @@
  
 #include <log4cxx/helpers/messagebuffer.h>
 #include <iomanip>
+#include <locale>
+#include <limits.h>
 #include "../insertwide.h"
 #include "../logunit.h"
 #include <log4cxx/logstring.h>
@@ -41,10 +43,20 @@ LOGUNIT_CLASS(MessageBufferTest)
       LOGUNIT_TEST(testInsertNull);
       LOGUNIT_TEST(testInsertInt);
       LOGUNIT_TEST(testInsertManipulator);
+      LOGUNIT_TEST(testExtract);
+      LOGUNIT_TEST(testExtractStream);
+      LOGUNIT_TEST(testExtractStreamManipulator);
+      LOGUNIT_TEST(testInsertIntegers);
+      LOGUNIT_TEST(testInsertFloatingPoint);
+      LOGUNIT_TEST(testInsertAfterStream);
+      LOGUNIT_TEST(testInsertEndl);
+      LOGUNIT_TEST(testStreamReuse);
 #if LOG4CXX_WCHAR_T_API
       LOGUNIT_TEST(testInsertConstWStr);
       LOGUNIT_TEST(testInsertWString);
       LOGUNIT_TEST(testInsertWStr);
+      LOGUNIT_TEST(testExtractWide);
+      LOGUNIT_TEST(testInsertWideNumbers);
 #endif
 #if LOG4CXX_UNICHAR_API
       LOGUNIT_TEST(testInsertConstUStr);
@@ -119,6 +131,108 @@ public:
         LOGUNIT_ASSERT_EQUAL(true, buf.hasStream());
     }
 
+    void testExtract() {
+        MessageBuffer buf;
+        std::string greeting(1000, 'x');
+        CharMessageBuffer& retval = buf << greeting;
+        const char* storage = buf.str(retval).data();
+        LogString msg;
+        buf.extract(msg);
+        LOGUNIT_ASSERT_EQUAL(LogString(1000, LOG4CXX_STR('x')), msg);
+#if LOG4CXX_LOGCHAR_IS_UTF8
+        //
+        //   content that needs no decoding is not copied
+        LOGUNIT_ASSERT(storage == msg.data());
+#endif
+    }
+
+    void testExtractStream() {
+        MessageBuffer buf;
+        buf << "x=" << 42;
+        LOGUNIT_ASSERT_EQUAL(true, buf.hasStream());
+        LogString msg;
+        buf.extract(msg);
+        LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("x=42"), msg);
+    }
+
+    void testExtractStreamManipulator() {
+        MessageBuffer buf;
+        buf << "x=" << std::hex << 42 << ' ' << (short) -1;
+        LogString msg;
+        buf.extract(msg);
+        LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("x=2a ffff"), msg);
+    }
+
+    /**
+     *  Numbers are formatted without num_put
+     *  exactly as std::ostream would format them.
+     */
+    void testInsertIntegers() {
+        MessageBuffer buf;
+        std::ostringstream expected;
+        std::ostream& retval = buf << 0 << ' ' << -1 << ' ' << 7 << ' ' << 99 << ' ' << 100
+            << ' ' << INT_MIN << ' ' << INT_MAX << ' ' << LONG_MIN << ' ' << LONG_MAX
+            << ' ' << ULONG_MAX << ' ' << UINT_MAX << ' ' << (short) -32768 << ' ' << true << false;
+        expected << 0 << ' ' << -1 << ' ' << 7 << ' ' << 99 << ' ' << 100
+            << ' ' << INT_MIN << ' ' << INT_MAX << ' ' << LONG_MIN << ' ' << LONG_MAX
+            << ' ' << ULONG_MAX << ' ' << UINT_MAX << ' ' << (short) -32768 << ' ' << true << false;
+        LOGUNIT_ASSERT_EQUAL(expected.str(), buf.str(retval));
+    }
+
+    void testInsertFloatingPoint() {
+        const double values[] = { 0.0, -0.0, 0.1, 1.0/3, 2.5f, 100000.0, 1000000.0, 123456789.0,
+            1e-5, 1.5e-7, 1e300, -1.7976931348623157e308, 4.9e-324 };
+        for (size_t i = 0; i < sizeof(values)/sizeof(values[0]); i++) {
+            MessageBuffer buf;
+            std::ostringstream expected;
+            std::ostream& retval = buf << values[i] << ' ' << (float) values[i];
+            expected << values[i] << ' ' << (float) values[i];
+            LOGUNIT_ASSERT_EQUAL(expected.str(), buf.str(retval));
+        }
+    }
+
+    void testInsertAfterStream() {
+        MessageBuffer buf;
+        buf << std::setprecision(3);
+        std::ostream& retval = buf << 3.14159 << ',' << 2.71828;
+        LOGUNIT_ASSERT_EQUAL(std::string("3.14,2.72"), buf.str(retval));
+        LOGUNIT_ASSERT_EQUAL(true, buf.hasStream());
+    }
+
+    void testInsertEndl() {
+        MessageBuffer buf;
+        std::ostream& retval = buf << "x=" << 5 << std::endl;
+        LOGUNIT_ASSERT_EQUAL(std::string("x=5\n"), buf.str(retval));
+    }
+
+    /**
+     *  Groups digits by three, like many named locales.
+     */
+    class GroupingNumpunct : public std::numpunct<char> {
+    protected:
+        char do_thousands_sep() const { return ','; }
+        std::string do_grouping() const { return "\3"; }
+    };
+
+    /**
+     *  A statement's stream reused by the next statement on
+     *  the thread keeps neither its content, locale nor formatting.
+     */
+    void testStreamReuse() {
+        {
+            MessageBuffer buf;
+            std::ostream& s = buf << "first statement, longer than the next";
+            s.imbue(std::locale(std::locale::classic(), new GroupingNumpunct()));
+            s << std::hex << 1234567;
+            LOGUNIT_ASSERT_EQUAL(std::string("first statement, longer than the next12d,687"),
+                buf.str(s));
+        }
+        MessageBuffer buf;
+        std::ostream& s = buf << "n=" << std::setw(0);
+        s << 1234567;
+        LOGUNIT_ASSERT_EQUAL(std::string("n=1234567"), buf.str(s));
+    }
+
 #if LOG4CXX_WCHAR_T_API
     void testInsertConstWStr() {
         MessageBuffer buf;
@@ -149,6 +263,22 @@ public:
         LOGUNIT_ASSERT_EQUAL(greeting, buf.str(retval)); 
         LOGUNIT_ASSERT_EQUAL(false, buf.hasStream());
     }
+
+    void testExtractWide() {
+        MessageBuffer buf;
+        buf << L"Hello" << L", World";
+        LogString msg;
+        buf.extract(msg);
+        LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("Hello, World"), msg);
+    }
+
+    void testInsertWideNumbers() {
+        MessageBuffer buf;
+        std::wostringstream expected;
+        std::basic_ostream<wchar_t>& retval = buf << L"n=" << -123456789L << L", x=" << 0.1 << L", u=" << 42u;
+        expected << L"n=" << -123456789L << L", x=" << 0.1 << L", u=" << 42u;
+        LOGUNIT_ASSERT_EQUAL(expected.str(), buf.str(retval));
+    }
 #endif
 
 #if LOG4CXX_UNICHAR_API
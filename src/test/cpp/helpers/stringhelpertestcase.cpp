@@ -19,6 +19,11 @@
 #include <log4cxx/helpers/stringhelper.h>
 #include "../insertwide.h"
 #include "../logunit.h"
+#include <log4cxx/helpers/pool.h>
+#include <log4cxx/helpers/transcoder.h>
+#include <apr.h>
+#include <limits.h>
+#include <sstream>
 
 
 using namespace log4cxx;
@@ -42,6 +47,8 @@ LOGUNIT_CLASS(StringHelperTestCase)
      LOGUNIT_TEST( testEndsWith3 );
      LOGUNIT_TEST( testEndsWith4 );
      LOGUNIT_TEST( testEndsWith5 );
+     LOGUNIT_TEST( testToStringInt );
+     LOGUNIT_TEST( testToStringInt64 );
      LOGUNIT_TEST_SUITE_END();
 
 
@@ -82,6 +89,38 @@ public:
     LOGUNIT_ASSERT_EQUAL(false, StringHelper::startsWith(LOG4CXX_STR("foobar"), LOG4CXX_STR("abc")));
   }
 
+  /**
+   * Check that toString(int) matches std::ostream formatting.
+   */
+  void testToStringInt() {
+    Pool p;
+    const int values[] = { 0, 9, 10, -10, 99, 100, -12345, INT_MAX, INT_MIN };
+    for (size_t i = 0; i < sizeof(values)/sizeof(values[0]); i++) {
+      std::ostringstream expected;
+      expected << values[i];
+      LogString actual;
+      StringHelper::toString(values[i], p, actual);
+      LOG4CXX_ENCODE_CHAR(encoded, actual);
+      LOGUNIT_ASSERT_EQUAL(expected.str(), encoded);
+    }
+  }
+
+  /**
+   * Check that toString(log4cxx_int64_t) handles values outside the int range.
+   */
+  void testToStringInt64() {
+    Pool p;
+    LogString actual;
+    StringHelper::toString((log4cxx_int64_t) APR_INT64_C(9223372036854775807), p, actual);
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("9223372036854775807"), actual);
+    actual.erase();
+    StringHelper::toString((log4cxx_int64_t) (-APR_INT64_C(9223372036854775807) - 1), p, actual);
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("-9223372036854775808"), actual);
+    actual.erase();
+    StringHelper::toString((log4cxx_int64_t) APR_INT64_C(-5000000001), p, actual);
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("-5000000001"), actual);
+  }
+
 
 
   /**
@@ -18,10 +18,16 @@
 
 #include <log4cxx/logger.h>
 #include <log4cxx/hierarchy.h>
+#include <log4cxx/helpers/thread.h>
+#include <log4cxx/helpers/stringhelper.h>
+#include <log4cxx/helpers/pool.h>
 #include "logunit.h"
 #include "insertwide.h"
+#include <apr_atomic.h>
+#include <vector>
 
 using namespace log4cxx;
+using namespace log4cxx::helpers;
 
 /**
  * Tests hierarchy.
@@ -30,6 +36,9 @@ using namespace log4cxx;
 LOGUNIT_CLASS(HierarchyTest) {
   LOGUNIT_TEST_SUITE(HierarchyTest);
           LOGUNIT_TEST(testGetParent);
+          LOGUNIT_TEST(testUnconfiguredThreshold);
+          LOGUNIT_TEST(testConcurrentLookup);
+          LOGUNIT_TEST(testBulkCreation);
   LOGUNIT_TEST_SUITE_END();
 public:
 
@@ -51,7 +60,160 @@ public:
           logger2->getParent()->getName());
   }
 
+    /**
+     * Tests that a hierarchy that has only been auto-configured
+     * applies its threshold, including on several threads at once.
+     * See the benchmark example for the cost of these checks.
+     */
+  void testUnconfiguredThreshold() {
+      Hierarchy* hierarchy = new Hierarchy();
+      spi::LoggerRepositoryPtr h(hierarchy);
+      LoggerPtr logger(h->getLogger(LOG4CXX_STR("a.b.c.d.e.f")));
+      //
+      //   first request triggers automatic configuration
+      //
+      LOGUNIT_ASSERT_EQUAL(false, logger->isTraceEnabled());
+      LOGUNIT_ASSERT_EQUAL(true, h->isConfigured());
+      LOGUNIT_ASSERT_EQUAL(false, h->isDisabled(Level::TRACE_INT));
+
+      h->setThreshold(Level::getWarn());
+      LOGUNIT_ASSERT_EQUAL(true, h->isDisabled(Level::INFO_INT));
+      LOGUNIT_ASSERT_EQUAL(false, h->isDisabled(Level::ERROR_INT));
+
+      std::vector<Thread*> threads(4);
+      for (size_t i = 0; i < threads.size(); i++) {
+          threads[i] = new Thread();
+          threads[i]->run(checkThreshold, hierarchy);
+      }
+      for (size_t i = 0; i < threads.size(); i++) {
+          threads[i]->join();
+          delete threads[i];
+      }
+      LOGUNIT_ASSERT_EQUAL(0, (int) apr_atomic_read32(&thresholdErrors));
+  }
+
+    /**
+     * Tests that loggers looked up on several threads at once are
+     * the loggers created before, and that clear releases them.
+     */
+  void testConcurrentLookup() {
+      Hierarchy* hierarchy = new Hierarchy();
+      spi::LoggerRepositoryPtr h(hierarchy);
+      std::vector<LogString> names;
+      std::vector<LoggerPtr> loggers;
+      Pool p;
+      for (int i = 0; i < LOOKUP_NAMES; i++) {
+          LogString name(LOG4CXX_STR("org.example.plugin"));
+          name.append(1, (logchar) (0x61 + (i % 26)));
+          name.append(LOG4CXX_STR(".Handler"));
+          StringHelper::toString(i, p, name);
+          names.push_back(name);
+          loggers.push_back(h->getLogger(name));
+      }
+      LookupRequest request = { hierarchy, &names, &loggers };
+
+      std::vector<Thread*> threads(4);
+      for (size_t i = 0; i < threads.size(); i++) {
+          threads[i] = new Thread();
+          threads[i]->run(lookupLoggers, &request);
+      }
+      for (size_t i = 0; i < threads.size(); i++) {
+          threads[i]->join();
+          delete threads[i];
+      }
+      LOGUNIT_ASSERT_EQUAL(0, (int) apr_atomic_read32(&lookupErrors));
+      LOGUNIT_ASSERT_EQUAL((size_t) LOOKUP_NAMES, h->getCurrentLoggers().size());
+
+      hierarchy->clear();
+      LOGUNIT_ASSERT(h->exists(names[0]) == 0);
+      LOGUNIT_ASSERT(h->getLogger(names[0]) != loggers[0]);
+  }
+
+    /**
+     * Creates a large synthetic set of loggers, descendants before
+     * ancestors, and checks the resulting parents.  See the benchmark
+     * example for the time this takes.
+     */
+  void testBulkCreation() {
+      spi::LoggerRepositoryPtr h(new Hierarchy());
+      std::vector<LogString> names;
+      Pool p;
+      for (int i = 0; i < BULK_LOGGERS; i++) {
+          //
+          //   com.example.m<i % 100>.p<i % 10>.C<i>
+          //
+          LogString name(LOG4CXX_STR("com.example.m"));
+          StringHelper::toString(i % 100, p, name);
+          name.append(LOG4CXX_STR(".p"));
+          StringHelper::toString(i % 10, p, name);
+          name.append(LOG4CXX_STR(".C"));
+          StringHelper::toString(i, p, name);
+          names.push_back(name);
+      }
+
+      for (int i = 0; i < BULK_LOGGERS; i++) {
+          h->getLogger(names[i]);
+      }
+      for (int i = 0; i < 100; i++) {
+          LogString name(LOG4CXX_STR("com.example.m"));
+          StringHelper::toString(i, p, name);
+          h->getLogger(name);
+      }
+
+      LoggerList loggers(h->getCurrentLoggers());
+      LOGUNIT_ASSERT_EQUAL((size_t) BULK_LOGGERS + 100, loggers.size());
+      for (size_t i = 1; i < loggers.size(); i++) {
+          LOGUNIT_ASSERT(loggers[i - 1]->getName() < loggers[i]->getName());
+      }
+      for (int i = 0; i < BULK_LOGGERS; i += 97) {
+          LoggerPtr logger(h->getLogger(names[i]));
+          LogString module(names[i].substr(0, names[i].find(LOG4CXX_STR(".p"))));
+          LOGUNIT_ASSERT_EQUAL(module, logger->getParent()->getName());
+          LOGUNIT_ASSERT_EQUAL(LogString(LOG4CXX_STR("root")),
+              logger->getParent()->getParent()->getName());
+      }
+  }
+
+private:
+  enum { THRESHOLD_CHECKS = 10000, LOOKUPS = 20000, LOOKUP_NAMES = 1000,
+      BULK_LOGGERS = 10000 };
+
+  struct LookupRequest {
+      Hierarchy* hierarchy;
+      const std::vector<LogString>* names;
+      const std::vector<LoggerPtr>* loggers;
+  };
+
+  static apr_uint32_t volatile thresholdErrors;
+  static apr_uint32_t volatile lookupErrors;
+
+  static void* LOG4CXX_THREAD_FUNC checkThreshold(apr_thread_t* /* thread */, void* data) {
+      const Hierarchy* hierarchy = reinterpret_cast<const Hierarchy*>(data);
+      for (int i = 0; i < THRESHOLD_CHECKS; i++) {
+          if (!hierarchy->isDisabled(Level::INFO_INT)
+              || hierarchy->isDisabled(Level::ERROR_INT)) {
+              apr_atomic_inc32(&thresholdErrors);
+          }
+      }
+      return NULL;
+  }
+
+  static void* LOG4CXX_THREAD_FUNC lookupLoggers(apr_thread_t* /* thread */, void* data) {
+      const LookupRequest& request = *reinterpret_cast<const LookupRequest*>(data);
+      const std::vector<LogString>& names = *request.names;
+      const std::vector<LoggerPtr>& loggers = *request.loggers;
+      for (int i = 0; i < LOOKUPS; i++) {
+          if (request.hierarchy->getLogger(names[i % LOOKUP_NAMES]) != loggers[i % LOOKUP_NAMES]) {
+              apr_atomic_inc32(&lookupErrors);
+          }
+      }
+      return NULL;
+  }
+
 };
 
+apr_uint32_t volatile HierarchyTest::thresholdErrors = 0;
+apr_uint32_t volatile HierarchyTest::lookupErrors = 0;
+
 LOGUNIT_TEST_SUITE_REGISTRATION(HierarchyTest);
 
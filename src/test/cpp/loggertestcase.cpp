@@ -30,10 +30,16 @@
 #include "logunit.h"
 #include <log4cxx/helpers/locale.h>
 #include "vectorappender.h"
+#include <log4cxx/helpers/thread.h>
+#include <log4cxx/spi/callsiteregistry.h>
+#include <log4cxx/helpers/pool.h>
+#include <set>
+#include <string.h>
 
 using namespace log4cxx;
 using namespace log4cxx::spi;
 using namespace log4cxx::helpers;
+using namespace log4cxx::filter;
 
 class CountingAppender;
 typedef helpers::ObjectPtrT<CountingAppender> CountingAppenderPtr;
@@ -56,6 +62,46 @@ public:
                 { return true; }
 };
 
+class PoolRecordingAppender;
+typedef helpers::ObjectPtrT<PoolRecordingAppender> PoolRecordingAppenderPtr;
+
+/**
+ *  Records the pools passed to append and, optionally,
+ *  logs to another logger while appending.
+ */
+class PoolRecordingAppender : public AppenderSkeleton
+{
+public:
+        int counter;
+        std::set<apr_pool_t*> pools;
+        LoggerPtr nested;
+        apr_pool_t* nestedPool;
+        bool outerIntact;
+
+        PoolRecordingAppender() : counter(0), nestedPool(0), outerIntact(false)
+                {}
+
+        void close()
+                {}
+
+        void append(const spi::LoggingEventPtr& /*event*/, Pool& p)
+        {
+                counter++;
+                pools.insert(p.getAPRPool());
+                if (nested != 0) {
+                    char* outer = p.pstrdup("outer");
+                    nested->info("nested");
+                    outerIntact = (strcmp(outer, "outer") == 0);
+                }
+                if (nestedPool == 0 && nested == 0) {
+                    nestedPool = p.getAPRPool();
+                }
+        }
+
+        bool requiresLayout() const
+                { return false; }
+};
+
 LOGUNIT_CLASS(LoggerTestCase)
 {
         LOGUNIT_TEST_SUITE(LoggerTestCase);
@@ -72,6 +118,19 @@ LOGUNIT_CLASS(LoggerTestCase)
                 LOGUNIT_TEST(testHierarchy1);
                 LOGUNIT_TEST(testTrace);
                 LOGUNIT_TEST(testIsTraceEnabled);
+                LOGUNIT_TEST(testEffectiveLevelCache);
+                LOGUNIT_TEST(testConcurrentAppenderChanges);
+                LOGUNIT_TEST(testAppenderRoute);
+                LOGUNIT_TEST(testCallSiteCache);
+                LOGUNIT_TEST(testCallSiteRegistry);
+                LOGUNIT_TEST(testCallSiteUnregistration);
+                LOGUNIT_TEST(testRequestPool);
+                LOGUNIT_TEST(testRequestPoolCreations);
+                LOGUNIT_TEST(testSharedLoggerName);
+#if LOG4CXX_HAS_VARIADIC_MACROS
+                LOGUNIT_TEST(testFormatMacros);
+#endif
+                LOGUNIT_TEST(testFieldsMacros);
         LOGUNIT_TEST_SUITE_END();
 
 public:
@@ -453,6 +512,370 @@ public:
         LOGUNIT_ASSERT_EQUAL(false, root->isTraceEnabled());
     }
 
+    /**
+     * Tests that the cached effective level follows changes
+     * to ancestor levels, the hierarchy and the threshold.
+     */
+    void testEffectiveLevelCache() {
+        LoggerRepositoryPtr h = new Hierarchy();
+        h->setConfigured(true);
+        LoggerPtr root(h->getRootLogger());
+        root->setLevel(Level::getInfo());
+
+        LoggerPtr abc = h->getLogger(LOG4CXX_STR("a.b.c"));
+        LOGUNIT_ASSERT_EQUAL(false, abc->isDebugEnabled());
+        LOGUNIT_ASSERT_EQUAL(true, abc->isInfoEnabled());
+
+        root->setLevel(Level::getDebug());
+        LOGUNIT_ASSERT_EQUAL(true, abc->isDebugEnabled());
+
+        LoggerPtr a = h->getLogger(LOG4CXX_STR("a"));
+        a->setLevel(Level::getWarn());
+        LOGUNIT_ASSERT_EQUAL(false, abc->isInfoEnabled());
+        LOGUNIT_ASSERT_EQUAL(true, abc->isWarnEnabled());
+
+        LoggerPtr ab = h->getLogger(LOG4CXX_STR("a.b"));
+        LOGUNIT_ASSERT_EQUAL(false, abc->isInfoEnabled());
+        ab->setLevel(Level::getTrace());
+        LOGUNIT_ASSERT_EQUAL(true, abc->isTraceEnabled());
+
+        h->setThreshold(Level::getError());
+        LOGUNIT_ASSERT_EQUAL(false, abc->isWarnEnabled());
+        LOGUNIT_ASSERT_EQUAL(true, abc->isEnabledFor(Level::getError()));
+
+        h->setThreshold(Level::getAll());
+        ab->setLevel(0);
+        LOGUNIT_ASSERT_EQUAL(false, abc->isInfoEnabled());
+        LOGUNIT_ASSERT_EQUAL(true, abc->isWarnEnabled());
+    }
+
+    /**
+     * Tests that the resolved appender route follows changes
+     * to appenders, additivity and the hierarchy.
+     */
+    void testAppenderRoute() {
+        LoggerRepositoryPtr h = new Hierarchy();
+        h->setConfigured(true);
+        LoggerPtr root(h->getRootLogger());
+        CountingAppenderPtr ca = new CountingAppender();
+        root->addAppender(ca);
+
+        LoggerPtr abc(h->getLogger(LOG4CXX_STR("a.b.c")));
+        abc->info(MSG);
+        LOGUNIT_ASSERT_EQUAL(1, ca->counter);
+
+        // appender reached through two loggers is called once
+        abc->addAppender(ca);
+        abc->info(MSG);
+        LOGUNIT_ASSERT_EQUAL(2, ca->counter);
+
+        abc->removeAppender(ca);
+        CountingAppenderPtr ca2 = new CountingAppender();
+        LoggerPtr ab(h->getLogger(LOG4CXX_STR("a.b")));
+        ab->addAppender(ca2);
+        abc->info(MSG);
+        LOGUNIT_ASSERT_EQUAL(3, ca->counter);
+        LOGUNIT_ASSERT_EQUAL(1, ca2->counter);
+
+        ab->setAdditivity(false);
+        abc->info(MSG);
+        LOGUNIT_ASSERT_EQUAL(3, ca->counter);
+        LOGUNIT_ASSERT_EQUAL(2, ca2->counter);
+
+        ab->setAdditivity(true);
+        ab->removeAllAppenders();
+        abc->info(MSG);
+        LOGUNIT_ASSERT_EQUAL(4, ca->counter);
+        LOGUNIT_ASSERT_EQUAL(2, ca2->counter);
+    }
+
+    static void logDebug(const LoggerPtr& l) {
+        LOG4CXX_DEBUG(l, "Message");
+    }
+
+    /**
+     * Tests that the decision cached by a call site follows
+     * configuration changes and is not shared between loggers.
+     */
+    void testCallSiteCache() {
+        LoggerRepositoryPtr h = new Hierarchy();
+        h->setConfigured(true);
+        LoggerPtr root(h->getRootLogger());
+        root->setLevel(Level::getInfo());
+        CountingAppenderPtr ca = new CountingAppender();
+        root->addAppender(ca);
+        LoggerPtr a(h->getLogger(LOG4CXX_STR("a")));
+        LoggerPtr b(h->getLogger(LOG4CXX_STR("b")));
+
+        logDebug(a);
+        logDebug(a);
+        LOGUNIT_ASSERT_EQUAL(0, ca->counter);
+
+        a->setLevel(Level::getDebug());
+        logDebug(a);
+        logDebug(b);
+        LOGUNIT_ASSERT_EQUAL(1, ca->counter);
+
+        b->setLevel(Level::getDebug());
+        a->setLevel(Level::getInfo());
+        logDebug(a);
+        logDebug(b);
+        logDebug(b);
+        LOGUNIT_ASSERT_EQUAL(3, ca->counter);
+
+        h->setThreshold(Level::getWarn());
+        logDebug(b);
+        LOGUNIT_ASSERT_EQUAL(3, ca->counter);
+        h->setThreshold(Level::getAll());
+        logDebug(b);
+        LOGUNIT_ASSERT_EQUAL(4, ca->counter);
+    }
+
+    static void logTrace(const LoggerPtr& l) {
+        LOG4CXX_TRACE(l, "Message");
+    }
+
+    /**
+     * Tests switching call sites on and off independently of logger levels.
+     */
+    void testCallSiteRegistry() {
+        LoggerRepositoryPtr h = new Hierarchy();
+        h->setConfigured(true);
+        LoggerPtr root(h->getRootLogger());
+        root->setLevel(Level::getInfo());
+        CountingAppenderPtr ca = new CountingAppender();
+        root->addAppender(ca);
+        LoggerPtr a(h->getLogger(LOG4CXX_STR("a")));
+
+        logTrace(a);
+        logDebug(a);
+        LOGUNIT_ASSERT_EQUAL(0, ca->counter);
+
+        LocationInfoFilterPtr on(new LocationInfoFilter());
+        on->setMethodName(LOG4CXX_STR("LoggerTestCase::logTrace"));
+        CallSiteRegistry::addFilter(on);
+        logTrace(a);
+        logDebug(a);
+        LOGUNIT_ASSERT_EQUAL(1, ca->counter);
+
+        LocationInfoList sites(CallSiteRegistry::getCallSites());
+        bool found = false;
+        for (LocationInfoList::iterator it = sites.begin(); it != sites.end(); it++) {
+            found |= it->getMethodName() == "logTrace";
+        }
+        LOGUNIT_ASSERT_EQUAL(true, found);
+
+        a->setLevel(Level::getTrace());
+        LocationInfoFilterPtr off(new LocationInfoFilter());
+        off->setFileName(LOG4CXX_STR("loggertestcase.cpp"));
+        off->setAcceptOnMatch(false);
+        CallSiteRegistry::addFilter(off);
+        logTrace(a);
+        logDebug(a);
+        LOGUNIT_ASSERT_EQUAL(1, ca->counter);
+
+        CallSiteRegistry::clearFilters();
+        logTrace(a);
+        logDebug(a);
+        LOGUNIT_ASSERT_EQUAL(3, ca->counter);
+    }
+
+    /**
+     * Tests that call sites of a module being unloaded can be removed
+     * and are no longer updated by the registry.
+     */
+    void testCallSiteUnregistration() {
+        CallSite module[2] = { LOG4CXX_CALL_SITE, LOG4CXX_CALL_SITE };
+        CallSiteRegistry::registerCallSite(module[0]);
+        CallSiteRegistry::registerCallSite(module[1]);
+        size_t count = CallSiteRegistry::getCallSites().size();
+
+        CallSiteRegistry::unregisterCallSites(module, module + 2);
+        LOGUNIT_ASSERT_EQUAL(count - 2, CallSiteRegistry::getCallSites().size());
+        LOGUNIT_ASSERT_EQUAL(0U, (unsigned int) module[0].registered);
+        LOGUNIT_ASSERT_EQUAL(0U, (unsigned int) module[1].registered);
+
+        LocationInfoFilterPtr on(new LocationInfoFilter());
+        on->setFileName(LOG4CXX_STR("loggertestcase.cpp"));
+        CallSiteRegistry::addFilter(on);
+        LOGUNIT_ASSERT_EQUAL((int) Filter::NEUTRAL, (int) module[0].decision);
+        CallSiteRegistry::clearFilters();
+    }
+
+    /**
+     * Tests that logging requests on a thread reuse one pool,
+     * where each request previously created and destroyed a pool of its own.
+     */
+    void testRequestPool() {
+        LoggerPtr a(Logger::getLogger("a"));
+        PoolRecordingAppenderPtr pa(new PoolRecordingAppender());
+        a->addAppender(pa);
+
+        const int EVENTS = 100;
+        for (int i = 0; i < EVENTS; i++) {
+            a->info("Message");
+        }
+        LOGUNIT_ASSERT_EQUAL(EVENTS, pa->counter);
+        LOGUNIT_ASSERT_EQUAL((size_t) 1, pa->pools.size());
+
+        //
+        //   a request made while appending gets a pool of its own
+        //      and leaves the enclosing request's allocations alone
+        LoggerPtr b(Logger::getLogger("b"));
+        PoolRecordingAppenderPtr pb(new PoolRecordingAppender());
+        b->addAppender(pb);
+        pa->nested = b;
+        a->info("Message");
+        LOGUNIT_ASSERT_EQUAL(1, pb->counter);
+        LOGUNIT_ASSERT(pa->outerIntact);
+        LOGUNIT_ASSERT(pb->nestedPool != 0);
+        LOGUNIT_ASSERT(pa->pools.find(pb->nestedPool) == pa->pools.end());
+        LOGUNIT_ASSERT_EQUAL((size_t) 1, pa->pools.size());
+        pa->nested = 0;
+
+        //
+        //   and the thread's pool is available again afterwards
+        b->info("Message");
+        LOGUNIT_ASSERT_EQUAL((size_t) 2, pb->pools.size());
+        LOGUNIT_ASSERT(pb->pools.find(*pa->pools.begin()) != pb->pools.end());
+    }
+
+    /**
+     * Tests that logging requests create no pools once the thread's
+     * pool exists, while a request that cannot borrow it still
+     * creates one pool as every request did before.
+     */
+    void testRequestPoolCreations() {
+        LoggerPtr a(Logger::getLogger("a"));
+        PoolRecordingAppenderPtr pa(new PoolRecordingAppender());
+        a->addAppender(pa);
+        a->info("Message");
+
+        const unsigned int EVENTS = 100;
+        unsigned int before = Pool::getCreatedCount();
+        for (unsigned int i = 0; i < EVENTS; i++) {
+            a->info("Message");
+        }
+        LOGUNIT_ASSERT_EQUAL(0U, Pool::getCreatedCount() - before);
+
+        //
+        //   requests nested in an appender create a pool each
+        LoggerPtr b(Logger::getLogger("b"));
+        b->addAppender(new PoolRecordingAppender());
+        pa->nested = b;
+        before = Pool::getCreatedCount();
+        for (unsigned int i = 0; i < EVENTS; i++) {
+            a->info("Message");
+        }
+        LOGUNIT_ASSERT_EQUAL(EVENTS, Pool::getCreatedCount() - before);
+        pa->nested = 0;
+    }
+
+    /**
+     * Tests that events share the name of their logger rather than copying it.
+     */
+    void testSharedLoggerName() {
+        LoggerPtr a(Logger::getLogger("org.apache.log4cxx.logging.long.logger.name"));
+        VectorAppenderPtr appender(new VectorAppender());
+        a->addAppender(appender);
+        a->info("Message");
+        a->info("Message");
+        const std::vector<spi::LoggingEventPtr>& events = appender->getVector();
+        LOGUNIT_ASSERT_EQUAL((size_t) 2, events.size());
+        LOGUNIT_ASSERT_EQUAL(a->getName(), events[0]->getLoggerName());
+        LOGUNIT_ASSERT(&events[0]->getLoggerName() == &events[1]->getLoggerName());
+    }
+
+#if LOG4CXX_HAS_VARIADIC_MACROS
+    /**
+     * Tests that the brace format macros format
+     * their arguments only when the level is enabled.
+     */
+    void testFormatMacros() {
+        LoggerPtr a(Logger::getLogger("a"));
+        a->setLevel(Level::getInfo());
+        VectorAppenderPtr appender(new VectorAppender());
+        a->addAppender(appender);
+        int formatted = 0;
+        LOG4CXX_DEBUG_FMT(a, "skipped {}", ++formatted);
+        LOG4CXX_INFO_FMT(a, "user={} took {}ms", "bob", ++formatted);
+        LOG4CXX_LOG_FMT(a, Level::getWarn(), "{} of {}", 2, 2);
+        const std::vector<spi::LoggingEventPtr>& events = appender->getVector();
+        LOGUNIT_ASSERT_EQUAL((size_t) 2, events.size());
+        LOGUNIT_ASSERT_EQUAL(1, formatted);
+        LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("user=bob took 1ms"), events[0]->getMessage());
+        LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("2 of 2"), events[1]->getMessage());
+    }
+#endif
+
+    void testFieldsMacros() {
+        LoggerPtr a(Logger::getLogger("a"));
+        a->setLevel(Level::getInfo());
+        VectorAppenderPtr appender(new VectorAppender());
+        a->addAppender(appender);
+        int evaluated = 0;
+        LOG4CXX_DEBUG_FIELDS(a, "skipped",
+            spi::EventFields().add(LOG4CXX_STR("count"), ++evaluated));
+        LOG4CXX_INFO_FIELDS(a, "request " << 7,
+            spi::EventFields().add(LOG4CXX_STR("status"), 200).add(LOG4CXX_STR("elapsed"), 1.5));
+        LOG4CXX_LOG_FIELDS(a, Level::getWarn(), "retry",
+            spi::EventFields().add(LOG4CXX_STR("count"), ++evaluated));
+        const std::vector<spi::LoggingEventPtr>& events = appender->getVector();
+        LOGUNIT_ASSERT_EQUAL((size_t) 2, events.size());
+        LOGUNIT_ASSERT_EQUAL(1, evaluated);
+        LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("request 7"), events[0]->getMessage());
+        LOGUNIT_ASSERT_EQUAL((size_t) 2, events[0]->getFieldCount());
+        LOGUNIT_ASSERT_EQUAL((log4cxx_int64_t) 200, events[0]->getField(0).getInteger());
+        LOGUNIT_ASSERT_EQUAL(1.5, events[0]->getField(1).getDouble());
+        LogString count;
+        LOGUNIT_ASSERT_EQUAL(true, events[1]->getField(LOG4CXX_STR("count"), count));
+        LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("1"), count);
+    }
+
+    enum { LOGGING_THREADS = 4, EVENTS_PER_THREAD = 20000 };
+
+    static void* LOG4CXX_THREAD_FUNC logEvents(apr_thread_t* /* thread */, void* data) {
+        Logger* child = (Logger*) data;
+        for (int i = 0; i < EVENTS_PER_THREAD; i++) {
+            LOG4CXX_INFO(child, "Message");
+        }
+        return 0;
+    }
+
+    /**
+     * Tests that appenders can be added and removed while
+     * other threads are logging through the same loggers.
+     */
+    void testConcurrentAppenderChanges() {
+        LoggerRepositoryPtr h = new Hierarchy();
+        h->setConfigured(true);
+        LoggerPtr root(h->getRootLogger());
+        CountingAppenderPtr fixed = new CountingAppender();
+        root->addAppender(fixed);
+        LoggerPtr child(h->getLogger(LOG4CXX_STR("a.b")));
+
+        Thread threads[LOGGING_THREADS];
+        for (int i = 0; i < LOGGING_THREADS; i++) {
+            threads[i].run(logEvents, (Logger*) child);
+        }
+
+        CountingAppenderPtr transient = new CountingAppender();
+        for (int i = 0; i < 1000; i++) {
+            root->addAppender(transient);
+            child->addAppender(transient);
+            root->removeAppender(transient);
+            child->removeAppender(transient);
+        }
+
+        for (int i = 0; i < LOGGING_THREADS; i++) {
+            threads[i].join();
+        }
+
+        LOGUNIT_ASSERT_EQUAL(LOGGING_THREADS * EVENTS_PER_THREAD, fixed->counter);
+        LOGUNIT_ASSERT_EQUAL((size_t) 1, root->getAllAppenders().size());
+        LOGUNIT_ASSERT_EQUAL(true, child->getAllAppenders().empty());
+    }
+
 protected:
         static LogString MSG;
         LoggerPtr logger;
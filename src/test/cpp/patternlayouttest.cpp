@@ -77,6 +77,7 @@ LOGUNIT_CLASS(PatternLayoutTest)
                 LOGUNIT_TEST(test12);
                 LOGUNIT_TEST(testMDC1);
                 LOGUNIT_TEST(testMDC2);
+                LOGUNIT_TEST(testFormatSteps);
         LOGUNIT_TEST_SUITE_END();
 
         LoggerPtr root;
@@ -538,6 +539,27 @@ private:
         static const LogString FILTERED;
         static const LogString TEMP;
 
+
+        /**
+        Merged literals, padded fields and the common converters
+        give the same result as formatting each converter.
+        */
+        void testFormatSteps()
+        {
+                PatternLayout layout(LOG4CXX_STR("[%-5p] %%%c{1} %c%10.10m|%.3m|%m%n"));
+                spi::LoggingEventPtr event(new spi::LoggingEvent(
+                        LOG4CXX_STR("org.example.Foo"), Level::getInfo(),
+                        LOG4CXX_STR("Hello"), spi::LocationInfo::getLocationUnavailable()));
+                Pool p;
+                LogString expected(LOG4CXX_STR("[INFO ] %Foo org.example.Foo     Hello|llo|Hello"));
+                expected.append(LOG4CXX_EOL);
+                for (int i = 0; i < 3; i++)
+                {
+                        LogString output(LOG4CXX_STR("prefix"));
+                        layout.format(output, event, p);
+                        LOGUNIT_ASSERT_EQUAL(LOG4CXX_STR("prefix") + expected, output);
+                }
+        }
 };
 
 const LogString PatternLayoutTest::TEMP(LOG4CXX_STR("output/temp"));
@@ -32,6 +32,7 @@
 #include <log4cxx/consoleappender.h>
 #include <log4cxx/helpers/exception.h>
 #include <log4cxx/helpers/fileoutputstream.h>
+#include <log4cxx/spi/loggingevent.h>
 
 
 using namespace log4cxx;
@@ -55,6 +56,7 @@ LOGUNIT_CLASS(SizeBasedRollingTest)  {
            LOGUNIT_TEST(test4);
            LOGUNIT_TEST(test5);
            LOGUNIT_TEST(test6);
+           LOGUNIT_TEST(test7);
    LOGUNIT_TEST_SUITE_END();
 
    LoggerPtr root;
@@ -345,6 +347,59 @@ LOGUNIT_CLASS(SizeBasedRollingTest)  {
     LOGUNIT_ASSERT_EQUAL(true, Compare::compare(File("output/sbr-test6.log"),  File("witness/rolling/sbr-test3.log")));
   }
   
+
+  /**
+   * Tests that events appended as one batch roll over
+   * at the same events as when appended one at a time.
+   */
+  void test7() {
+    PatternLayoutPtr layout = new PatternLayout(LOG4CXX_STR("%m\n"));
+    RollingFileAppenderPtr rfa = new RollingFileAppender();
+    rfa->setName(LOG4CXX_STR("ROLLING"));
+    rfa->setAppend(false);
+    rfa->setLayout(layout);
+    rfa->setFile(LOG4CXX_STR("output/sizeBased-test7.log"));
+
+    FixedWindowRollingPolicyPtr swrp = new FixedWindowRollingPolicy();
+    SizeBasedTriggeringPolicyPtr sbtp = new SizeBasedTriggeringPolicy();
+
+    sbtp->setMaxFileSize(100);
+    swrp->setMinIndex(0);
+
+    swrp->setFileNamePattern(LOG4CXX_STR("output/sizeBased-test7.%i"));
+    Pool p;
+    swrp->activateOptions(p);
+
+    rfa->setRollingPolicy(swrp);
+    rfa->setTriggeringPolicy(sbtp);
+    rfa->activateOptions(p);
+
+    LogString msg(LOG4CXX_STR("Hello---N"));
+    spi::LoggingEventList events;
+    for (int i = 0; i < 25; i++) {
+      if (i < 10) {
+        msg[8] = (logchar) (0x30 + i);
+      } else {
+        msg[7] = (logchar) (0x30 + i / 10);
+        msg[8] = (logchar) (0x30 + i % 10);
+      }
+      events.push_back(spi::LoggingEvent::obtain(logger->getName(), Level::getDebug(),
+        msg, spi::LocationInfo::getLocationUnavailable()));
+    }
+    rfa->doAppendBatch(events, p);
+
+    LOGUNIT_ASSERT_EQUAL(true, File("output/sizeBased-test7.log").exists(p));
+    LOGUNIT_ASSERT_EQUAL(true, File("output/sizeBased-test7.0").exists(p));
+    LOGUNIT_ASSERT_EQUAL(true, File("output/sizeBased-test7.1").exists(p));
+
+    LOGUNIT_ASSERT_EQUAL(true, Compare::compare(File("output/sizeBased-test7.log"),
+     File("witness/rolling/sbr-test2.log")));
+    LOGUNIT_ASSERT_EQUAL(true, Compare::compare(File("output/sizeBased-test7.0"),
+     File("witness/rolling/sbr-test2.0")));
+    LOGUNIT_ASSERT_EQUAL(true, Compare::compare(File("output/sizeBased-test7.1"),
+     File("witness/rolling/sbr-test2.1")));
+  }
+
 };
 
 
@@ -20,6 +20,12 @@
 #include <log4cxx/ndc.h>
 #include <log4cxx/mdc.h>
 #include "../logunit.h"
+#include <log4cxx/helpers/thread.h>
+#include <log4cxx/helpers/threadspecificdata.h>
+#include <log4cxx/helpers/bytearrayoutputstream.h>
+#include <log4cxx/helpers/objectoutputstream.h>
+#include <log4cxx/helpers/sharedstring.h>
+#include <set>
 
 using namespace log4cxx;
 using namespace log4cxx::helpers;
@@ -38,6 +44,15 @@ LOGUNIT_CLASS(LoggingEventTest)
                 LOGUNIT_TEST(testSerializationWithLocation);
                 LOGUNIT_TEST(testSerializationNDC);
                 LOGUNIT_TEST(testSerializationMDC);
+                LOGUNIT_TEST(testSerializationSharedName);
+                LOGUNIT_TEST(testRecycle);
+                LOGUNIT_TEST(testRecycleAcrossThreads);
+                LOGUNIT_TEST(testThreadName);
+                LOGUNIT_TEST(testThreadNameAfterNDC);
+                LOGUNIT_TEST(testFields);
+                LOGUNIT_TEST(testManyFields);
+                LOGUNIT_TEST(testUnsignedField);
+                LOGUNIT_TEST(testSwapFields);
          LOGUNIT_TEST_SUITE_END();
 
 public:
@@ -116,6 +131,270 @@ public:
       "witness/serialization/mdc.bin", event, 237));
   }
 
+  /**
+   * Tests that a released event is reused and carries
+   * nothing over from its previous use.
+   */
+  void testRecycle() {
+    LoggingEventPtr event(
+      LoggingEvent::obtain(
+        LOG4CXX_STR("root"), Level::getInfo(), LOG4CXX_STR("Hello, world."), LOG4CXX_LOCATION));
+    event->setProperty(LOG4CXX_STR("key"), LOG4CXX_STR("value"));
+    NDC::push("ndc test");
+    LogString ndc;
+    LOGUNIT_ASSERT_EQUAL(true, event->getNDC(ndc));
+    NDC::pop();
+    LoggingEvent* released = event;
+    event = 0;
+
+    event = LoggingEvent::obtain(
+        LOG4CXX_STR("other"), Level::getWarn(), LOG4CXX_STR("Goodbye."),
+        LocationInfo::getLocationUnavailable());
+    LOGUNIT_ASSERT(released == event);
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("other"), event->getLoggerName());
+    LOGUNIT_ASSERT_EQUAL(Level::getWarn(), event->getLevel());
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("Goodbye."), event->getMessage());
+    LOGUNIT_ASSERT_EQUAL(-1, event->getLocationInformation().getLineNumber());
+    LOGUNIT_ASSERT_EQUAL(false, event->getThreadName().empty());
+    LOGUNIT_ASSERT_EQUAL(true, event->getPropertyKeySet().empty());
+    ndc.erase();
+    LOGUNIT_ASSERT_EQUAL(false, event->getNDC(ndc));
+  }
+
+  /**
+   * Tests that events sharing a logger name written to one stream
+   * only carry the name once.
+   */
+  void testSerializationSharedName() {
+    SharedStringPtr name(new SharedString(LOG4CXX_STR("org.example.shared")));
+    LoggingEventPtr first(new LoggingEvent(name, Level::getInfo(),
+        LOG4CXX_STR("Hello, world."), LocationInfo::getLocationUnavailable()));
+    LoggingEventPtr second(new LoggingEvent(name, Level::getInfo(),
+        LOG4CXX_STR("Hello, world."), LocationInfo::getLocationUnavailable()));
+    ByteArrayOutputStreamPtr memOut = new ByteArrayOutputStream();
+    Pool p;
+    ObjectOutputStream objOut(memOut, p);
+    first->write(objOut, p);
+    second->write(objOut, p);
+    objOut.close(p);
+
+    std::vector<unsigned char> bytes(memOut->toByteArray());
+    std::string serialized(bytes.begin(), bytes.end());
+    std::string::size_type pos = serialized.find("org.example.shared");
+    LOGUNIT_ASSERT(pos != std::string::npos);
+    LOGUNIT_ASSERT_EQUAL(std::string::npos, serialized.find("org.example.shared", pos + 1));
+  }
+
+  enum { EVENTS = 200 };
+
+  static void* LOG4CXX_THREAD_FUNC releaseEvents(apr_thread_t* /* thread */, void* data) {
+    std::vector<LoggingEventPtr>* events = (std::vector<LoggingEventPtr>*) data;
+    events->clear();
+    return 0;
+  }
+
+  /**
+   * Tests that events released on another thread,
+   * as by the AsyncAppender dispatcher, are reused by the logging thread.
+   */
+  void testRecycleAcrossThreads() {
+    std::vector<LoggingEventPtr> events;
+    std::set<LoggingEvent*> released;
+    for (int i = 0; i < EVENTS; i++) {
+      LoggingEventPtr event(LoggingEvent::obtain(
+        LOG4CXX_STR("root"), Level::getInfo(), LOG4CXX_STR("Hello, world."),
+        LocationInfo::getLocationUnavailable()));
+      events.push_back(event);
+      released.insert(event);
+    }
+
+    Thread thread;
+    thread.run(releaseEvents, &events);
+    thread.join();
+    LOGUNIT_ASSERT_EQUAL(true, events.empty());
+
+    int reused = 0;
+    for (int i = 0; i < EVENTS; i++) {
+      LoggingEventPtr event(LoggingEvent::obtain(
+        LOG4CXX_STR("root"), Level::getInfo(), LOG4CXX_STR("Hello, world."),
+        LocationInfo::getLocationUnavailable()));
+      events.push_back(event);
+      if (released.find(event) != released.end()) {
+        reused++;
+      }
+    }
+    LOGUNIT_ASSERT(reused >= EVENTS / 2);
+  }
+
+  /**
+   * Tests that events from one thread share its name
+   * and that a name set for the thread is used by later events.
+   */
+  void testThreadName() {
+    LoggingEventPtr first(LoggingEvent::obtain(
+        LOG4CXX_STR("root"), Level::getInfo(), LOG4CXX_STR("Hello, world."),
+        LocationInfo::getLocationUnavailable()));
+    LoggingEventPtr second(new LoggingEvent(
+        LOG4CXX_STR("root"), Level::getInfo(), LOG4CXX_STR("Hello, world."),
+        LocationInfo::getLocationUnavailable()));
+    LOGUNIT_ASSERT(&first->getThreadName() == &second->getThreadName());
+    LogString id(first->getThreadName());
+
+    ThreadSpecificData::setThreadName(LOG4CXX_STR("worker"));
+    LoggingEventPtr named(new LoggingEvent(
+        LOG4CXX_STR("root"), Level::getInfo(), LOG4CXX_STR("Hello, world."),
+        LocationInfo::getLocationUnavailable()));
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("worker"), named->getThreadName());
+    LOGUNIT_ASSERT_EQUAL(id, first->getThreadName());
+
+    ThreadSpecificData::setThreadName(LogString());
+    LoggingEventPtr unnamed(new LoggingEvent(
+        LOG4CXX_STR("root"), Level::getInfo(), LOG4CXX_STR("Hello, world."),
+        LocationInfo::getLocationUnavailable()));
+    LOGUNIT_ASSERT_EQUAL(id, unnamed->getThreadName());
+  }
+
+  static void* LOG4CXX_THREAD_FUNC nameThread(apr_thread_t* /* thread */, void* data) {
+    LogString* name = (LogString*) data;
+    ThreadSpecificData::setThreadName(LOG4CXX_STR("worker"));
+    NDC::push(LOG4CXX_STR("context"));
+    NDC::pop();
+    LoggingEventPtr event(new LoggingEvent(
+        LOG4CXX_STR("root"), Level::getInfo(), LOG4CXX_STR("Hello, world."),
+        LocationInfo::getLocationUnavailable()));
+    *name = event->getThreadName();
+    return 0;
+  }
+
+  /**
+   * Tests that the name of a thread is kept
+   * when its diagnostic context is emptied.
+   */
+  void testThreadNameAfterNDC() {
+    LogString name;
+    Thread thread;
+    thread.run(nameThread, &name);
+    thread.join();
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("worker"), name);
+  }
+
+  /**
+   * Tests that typed fields keep their values, are formatted
+   * on request and are not carried over to a recycled event.
+   */
+  void testFields() {
+    LoggingEventPtr event(LoggingEvent::obtain(
+        LOG4CXX_STR("root"), Level::getInfo(), LOG4CXX_STR("Hello, world."),
+        LocationInfo::getLocationUnavailable()));
+    LOGUNIT_ASSERT_EQUAL((size_t) 0, event->getFieldCount());
+    event->setFields(EventFields()
+        .add(LOG4CXX_STR("count"), 42)
+        .add(LOG4CXX_STR("total"), (log4cxx_int64_t) -5000000000LL)
+        .add(LOG4CXX_STR("ratio"), 0.25)
+        .add(LOG4CXX_STR("ok"), true)
+        .add(LOG4CXX_STR("user"), LOG4CXX_STR("bob")));
+    LOGUNIT_ASSERT_EQUAL((size_t) 5, event->getFieldCount());
+    LOGUNIT_ASSERT_EQUAL(EventField::INTEGER, event->getField(0).getType());
+    LOGUNIT_ASSERT_EQUAL((log4cxx_int64_t) 42, event->getField(0).getInteger());
+    LOGUNIT_ASSERT_EQUAL(EventField::DOUBLE, event->getField(2).getType());
+    LOGUNIT_ASSERT_EQUAL(EventField::BOOLEAN, event->getField(3).getType());
+    LOGUNIT_ASSERT_EQUAL(EventField::STRING, event->getField(4).getType());
+
+    LogString value;
+    LOGUNIT_ASSERT_EQUAL(true, event->getField(LOG4CXX_STR("total"), value));
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("-5000000000"), value);
+    value.erase();
+    LOGUNIT_ASSERT_EQUAL(true, event->getField(LOG4CXX_STR("ratio"), value));
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("0.25"), value);
+    value.erase();
+    LOGUNIT_ASSERT_EQUAL(true, event->getField(LOG4CXX_STR("ok"), value));
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("true"), value);
+    value.erase();
+    LOGUNIT_ASSERT_EQUAL(true, event->getField(LOG4CXX_STR("user"), value));
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("bob"), value);
+    LOGUNIT_ASSERT_EQUAL(false, event->getField(LOG4CXX_STR("missing"), value));
+
+    LoggingEvent* released = event;
+    event = 0;
+    event = LoggingEvent::obtain(
+        LOG4CXX_STR("root"), Level::getInfo(), LOG4CXX_STR("Hello, world."),
+        LocationInfo::getLocationUnavailable());
+    LOGUNIT_ASSERT(released == event);
+    LOGUNIT_ASSERT_EQUAL((size_t) 0, event->getFieldCount());
+  }
+
+  /**
+   * Tests more fields than fit in the inline array.
+   */
+  void testManyFields() {
+    static const logchar* const keys[] = {
+        LOG4CXX_STR("f0"), LOG4CXX_STR("f1"), LOG4CXX_STR("f2"), LOG4CXX_STR("f3"),
+        LOG4CXX_STR("f4"), LOG4CXX_STR("f5"), LOG4CXX_STR("f6"), LOG4CXX_STR("f7"),
+        LOG4CXX_STR("f8"), LOG4CXX_STR("f9"), LOG4CXX_STR("f10"), LOG4CXX_STR("f11"),
+        LOG4CXX_STR("f12"), LOG4CXX_STR("f13"), LOG4CXX_STR("f14"), LOG4CXX_STR("f15"),
+        LOG4CXX_STR("f16"), LOG4CXX_STR("f17"), LOG4CXX_STR("f18"), LOG4CXX_STR("f19") };
+    EventFields fields;
+    for (int i = 0; i < 20; i++) {
+        fields.add(keys[i], i);
+    }
+    LoggingEventPtr event(new LoggingEvent(
+        LOG4CXX_STR("root"), Level::getInfo(), LOG4CXX_STR("Hello, world."),
+        LocationInfo::getLocationUnavailable()));
+    event->setFields(fields);
+    LOGUNIT_ASSERT_EQUAL((size_t) 20, event->getFieldCount());
+    for (int i = 0; i < 20; i++) {
+        LOGUNIT_ASSERT_EQUAL((log4cxx_int64_t) i, event->getField(i).getInteger());
+    }
+    LogString value;
+    LOGUNIT_ASSERT_EQUAL(true, event->getField(LOG4CXX_STR("f19"), value));
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("19"), value);
+  }
+
+  /**
+   * Tests that unsigned values above the signed range are kept.
+   */
+  void testUnsignedField() {
+    log4cxx_uint64_t big = 1;
+    big <<= 63;
+    EventFields fields;
+    fields.add(LOG4CXX_STR("big"), big);
+    fields.add(LOG4CXX_STR("max"), (unsigned long) -1);
+    LOGUNIT_ASSERT_EQUAL(EventField::UNSIGNED, fields[0].getType());
+    LOGUNIT_ASSERT(big == fields[0].getUnsigned());
+    LogString value;
+    fields[0].format(value);
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("9223372036854775808"), value);
+    LOGUNIT_ASSERT_EQUAL(EventField::UNSIGNED, fields[1].getType());
+    LOGUNIT_ASSERT(fields[1].getUnsigned() == (unsigned long) -1);
+  }
+
+  /**
+   * Tests that fields taken over by an event keep their string values
+   * and that copies do not share the characters of their source.
+   */
+  void testSwapFields() {
+    EventFields fields;
+    fields.add(LOG4CXX_STR("user"), LOG4CXX_STR("bob"));
+    fields.add(LOG4CXX_STR("count"), 3);
+    fields.add(LOG4CXX_STR("host"), LogString(LOG4CXX_STR("alpha")));
+    EventFields copy(fields);
+    LoggingEventPtr event(new LoggingEvent(
+        LOG4CXX_STR("root"), Level::getInfo(), LOG4CXX_STR("Hello, world."),
+        LocationInfo::getLocationUnavailable()));
+    event->swapFields(fields);
+    LOGUNIT_ASSERT_EQUAL((size_t) 0, fields.size());
+    fields.add(LOG4CXX_STR("other"), LOG4CXX_STR("zzzzzzzz"));
+    LOGUNIT_ASSERT_EQUAL((size_t) 3, event->getFieldCount());
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("bob"), event->getField(0).getString());
+    LogString value;
+    LOGUNIT_ASSERT_EQUAL(true, event->getField(LOG4CXX_STR("host"), value));
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("alpha"), value);
+    copy.clear();
+    copy.add(LOG4CXX_STR("user"), LOG4CXX_STR("eve"));
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("bob"), event->getField(0).getString());
+    LOGUNIT_ASSERT_EQUAL((LogString) LOG4CXX_STR("eve"), copy[0].getString());
+  }
+
 };
 
 LOGUNIT_TEST_SUITE_REGISTRATION(LoggingEventTest);
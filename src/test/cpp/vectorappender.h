@@ -56,4 +56,15 @@ namespace log4cxx
                         { return false;   }
         };
         typedef helpers::ObjectPtrT<VectorAppender> VectorAppenderPtr;
+
+        /**
+        Vector appender that does not delay each event.
+        */
+        class ImmediateVectorAppender : public VectorAppender
+        {
+        public:
+                void append(const spi::LoggingEventPtr& event, log4cxx::helpers::Pool&)
+                        { vector.push_back(event); }
+        };
+        typedef helpers::ObjectPtrT<ImmediateVectorAppender> ImmediateVectorAppenderPtr;
 }
@@ -66,6 +66,7 @@ LOGUNIT_CLASS(XMLLayoutTest) {
                 LOGUNIT_TEST(testActivateOptions);
                 LOGUNIT_TEST(testProblemCharacters);
                 LOGUNIT_TEST(testNDCWithCDATA);
+                LOGUNIT_TEST(testFields);
         LOGUNIT_TEST_SUITE_END();
 
   
@@ -410,6 +411,37 @@ public:
         LOGUNIT_ASSERT_EQUAL(1, ndcCount);
    }
 
+    /**
+      * Tests typed fields are written with the properties.
+      */
+    void testFields() {
+        LoggingEventPtr event =
+          new LoggingEvent(
+            LOG4CXX_STR("com.example.bar"), Level::getInfo(), LOG4CXX_STR("Hello, World"), LOG4CXX_LOCATION);
+        event->setFields(EventFields().add(LOG4CXX_STR("count"), 3).add(LOG4CXX_STR("ratio"), 0.5));
+        XMLLayout layout;
+        layout.setProperties(true);
+        Pool p;
+        LogString result;
+        layout.format(result, event, p);
+        apr_xml_elem* parsedResult = parse(result, p);
+        int dataCount = 0;
+        for(apr_xml_elem* node = parsedResult->first_child;
+            node != NULL;
+            node = node->next) {
+            if (strcmp(node->name, "properties") == 0) {
+                for(apr_xml_elem* child = node->first_child;
+                    child != NULL;
+                    child = child->next) {
+                    dataCount++;
+                }
+            }
+        }
+        LOGUNIT_ASSERT_EQUAL(2, dataCount);
+        LOGUNIT_ASSERT(result.find(LOG4CXX_STR("<log4j:data name=\"count\" value=\"3\"/>")) != LogString::npos);
+        LOGUNIT_ASSERT(result.find(LOG4CXX_STR("<log4j:data name=\"ratio\" value=\"0.5\"/>")) != LogString::npos);
+   }
+
 };
 
 